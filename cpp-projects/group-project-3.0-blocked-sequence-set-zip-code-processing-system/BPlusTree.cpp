@@ -0,0 +1,811 @@
+// CSCI 331 Group Project - Copyright © 2024 Blocked Sequence Set Zip Code Processing System
+#include "BPlusTree.h"
+#include "Block.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+using namespace std;
+
+/// Identifies an index file written by BPlusTree with fixed-width leaf keys.
+static const char BPT_MAGIC[4] = { 'B', 'P', 'T', '1' };
+
+/// Identifies an index file written by BPlusTree with front coded leaves.
+static const char BPT_FRONT_CODED_MAGIC[4] = { 'B', 'P', 'T', '2' };
+
+/**
+ * @brief Orders two keys with compareKeys() for the standard algorithms.
+ */
+static bool keyLess(const string& a, const string& b) {
+    return compareKeys(a, b) < 0;
+}
+
+/**
+ * @brief Counts the leading bytes two keys share.
+ */
+static size_t sharedPrefix(const string& a, const string& b) {
+    size_t shared = 0;
+    while (shared < a.size() && shared < b.size() && a[shared] == b[shared]) shared++;
+    return shared;
+}
+
+/**
+ * @brief Bytes one entry takes in a front coded leaf: shared and suffix lengths, the
+ *        suffix, the RBN and, at a restart point, its restart offset.
+ * @param previous Key before it in the leaf; ignored at a restart point.
+ * @param key Key of the entry.
+ * @param index Position of the entry in the leaf, from 0.
+ */
+static size_t leafEntryBytes(const string& previous, const string& key, size_t index) {
+    if (index % BPT_RESTART_INTERVAL == 0) return 2 + key.size() + 4 + 2;
+    return 2 + key.size() - sharedPrefix(previous, key) + 4;
+}
+
+BPlusTree::BPlusTree()
+    : pageSize(512)
+    , frontCoded(true)
+    , rootPage(-1)
+    , height(0)
+    , firstLeaf(-1)
+    , pageCount(0)
+    , entryCount(0)
+    , pageReads(0) {}
+
+/**
+ * @brief Largest number of keys a leaf page can hold.
+ */
+size_t BPlusTree::maxLeafKeys() const {
+    return (pageSize - BPT_NODE_HEADER_SIZE) / (BPT_KEY_WIDTH + 4);
+}
+
+/**
+ * @brief Largest number of keys an internal page can hold (it holds one more child).
+ */
+size_t BPlusTree::maxInternalKeys() const {
+    return (pageSize - BPT_NODE_HEADER_SIZE - 4) / (BPT_KEY_WIDTH + 4);
+}
+
+/**
+ * @brief Tells whether a leaf fits in one page in the tree's leaf format.
+ */
+bool BPlusTree::leafFits(const Node& node) const {
+    if (!frontCoded) return node.keys.size() <= maxLeafKeys();
+    size_t bytes = BPT_NODE_HEADER_SIZE;
+    for (size_t i = 0; i < node.keys.size(); i++) {
+        bytes += leafEntryBytes(node.keys[i > 0 ? i - 1 : 0], node.keys[i], i);
+    }
+    return bytes <= static_cast<size_t>(pageSize);
+}
+
+/**
+ * @brief Returns the bytes of one page.
+ *
+ * A mapped tree returns the page straight from the mapping instead of reading it.
+ *
+ * @param page Page number.
+ * @return The page, valid until the next read, or nullptr if it could not be read.
+ */
+const char* BPlusTree::readPage(int page) {
+    long long offset = static_cast<long long>(page) * pageSize;
+    const char* data;
+    if (mapping.isOpen()) {
+        data = page >= 1 && page < pageCount && offset + pageSize <= static_cast<long long>(mapping.getSize())
+            ? mapping.getData() + offset : nullptr;
+    } else {
+        buffer.resize(pageSize);
+        file.clear();
+        file.seekg(offset);
+        data = page >= 1 && page < pageCount && file.read(buffer.data(), pageSize) ? buffer.data() : nullptr;
+    }
+    if (data == nullptr) {
+        cerr << "Error: Could not read index page " << page << " of " << fileName << endl;
+        return nullptr;
+    }
+    pageReads++;
+    return data;
+}
+
+/**
+ * @brief Reads and decodes one node page.
+ * @param page Page number.
+ * @param node Receives the decoded node.
+ * @return True if the page was read.
+ */
+bool BPlusTree::readNode(int page, Node& node) {
+    const char* data = readPage(page);
+    if (data == nullptr) return false;
+    if (data[0] == 0 && frontCoded) return decodeLeaf(page, data, node);
+
+    uint16_t count;
+    int32_t next;
+    memcpy(&count, data + 2, 2);
+    memcpy(&next, data + 4, 4);
+    node.leaf = data[0] == 0;
+    node.next = next;
+    if (count > (node.leaf ? maxLeafKeys() : maxInternalKeys())) {
+        cerr << "Error: Index page " << page << " of " << fileName << " is corrupt" << endl;
+        return false;
+    }
+    node.keys.resize(count);
+    node.values.clear();
+
+    size_t pos = BPT_NODE_HEADER_SIZE;
+    if (!node.leaf) {
+        int32_t child;
+        memcpy(&child, data + pos, 4);
+        node.values.push_back(child);
+        pos += 4;
+    }
+    for (uint16_t i = 0; i < count; i++) {
+        const char* key = data + pos;
+        node.keys[i].assign(key, strnlen(key, BPT_KEY_WIDTH));
+        int32_t value;
+        memcpy(&value, data + pos + BPT_KEY_WIDTH, 4);
+        node.values.push_back(value);
+        pos += BPT_KEY_WIDTH + 4;
+    }
+    return true;
+}
+
+/**
+ * @brief Decodes a front coded leaf page, checking every length against the page.
+ * @param page Page number, for the error message.
+ * @param data Page bytes.
+ * @param node Receives the decoded leaf.
+ * @return False if the page is corrupt.
+ */
+bool BPlusTree::decodeLeaf(int page, const char* data, Node& node) const {
+    uint16_t count;
+    int32_t next;
+    memcpy(&count, data + 2, 2);
+    memcpy(&next, data + 4, 4);
+    node.leaf = true;
+    node.next = next;
+    node.keys.resize(count);
+    node.values.resize(count);
+
+    size_t restarts = (count + BPT_RESTART_INTERVAL - 1) / BPT_RESTART_INTERVAL;
+    bool valid = restarts * 2 <= pageSize - BPT_NODE_HEADER_SIZE;
+    size_t end = valid ? pageSize - restarts * 2 : 0;  ///< Start of the restart offsets
+    size_t pos = BPT_NODE_HEADER_SIZE;
+    for (size_t i = 0; valid && i < count; i++) {
+        size_t shared = pos + 2 <= end ? static_cast<unsigned char>(data[pos]) : BPT_KEY_WIDTH + 1;
+        size_t suffix = pos + 2 <= end ? static_cast<unsigned char>(data[pos + 1]) : 0;
+        valid = shared <= (i > 0 ? node.keys[i - 1].size() : 0) && (i % BPT_RESTART_INTERVAL != 0 || shared == 0)
+            && shared + suffix <= BPT_KEY_WIDTH && pos + 2 + suffix + 4 <= end;
+        if (!valid) break;
+
+        string& key = node.keys[i];
+        if (shared > 0) key.assign(node.keys[i - 1], 0, shared);
+        else key.clear();
+        key.append(data + pos + 2, suffix);
+        int32_t value;
+        memcpy(&value, data + pos + 2 + suffix, 4);
+        node.values[i] = value;
+        pos += 2 + suffix + 4;
+    }
+    if (!valid) {
+        cerr << "Error: Index page " << page << " of " << fileName << " is corrupt" << endl;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Looks up a key in a front coded leaf page without decoding the whole page.
+ *
+ * The restart keys are binary searched for the last one not greater than the key,
+ * then the keys from that restart point on are decoded until the key is passed.
+ *
+ * @param page Page number, for the error message.
+ * @param data Page bytes.
+ * @param key Key to look up.
+ * @param RBN Receives the RBN stored for the key, or -1 if the leaf does not hold it.
+ * @return False if the page is corrupt.
+ */
+bool BPlusTree::searchLeaf(int page, const char* data, const string& key, int& RBN) const {
+    RBN = -1;
+    uint16_t count;
+    memcpy(&count, data + 2, 2);
+    size_t restarts = (count + BPT_RESTART_INTERVAL - 1) / BPT_RESTART_INTERVAL;
+    bool valid = restarts * 2 <= pageSize - BPT_NODE_HEADER_SIZE;
+    size_t end = valid ? pageSize - restarts * 2 : 0;  ///< Start of the restart offsets
+
+    // Offset of the entry at a restart point, or 0 if it is not a full key inside the page
+    auto restartOffset = [&](size_t restart) -> size_t {
+        uint16_t stored;
+        memcpy(&stored, data + end + restart * 2, 2);
+        size_t offset = stored;
+        if (offset < BPT_NODE_HEADER_SIZE || offset + 2 > end || data[offset] != 0) return 0;
+        size_t length = static_cast<unsigned char>(data[offset + 1]);
+        return length <= BPT_KEY_WIDTH && offset + 2 + length + 4 <= end ? offset : 0;
+    };
+
+    size_t low = 0, high = valid ? restarts : 0;
+    while (low < high) {
+        size_t mid = (low + high) / 2;
+        size_t offset = restartOffset(mid);
+        if (offset == 0) {
+            valid = false;
+            break;
+        }
+        string_view restartKey(data + offset + 2, static_cast<unsigned char>(data[offset + 1]));
+        if (compareKeys(restartKey, key) <= 0) low = mid + 1;
+        else high = mid;
+    }
+
+    char current[BPT_KEY_WIDTH];
+    size_t currentLength = 0;
+    size_t pos = valid && low > 0 ? restartOffset(low - 1) : 0;
+    size_t first = low > 0 ? (low - 1) * BPT_RESTART_INTERVAL : count;  ///< Keys before the first restart are absent
+    size_t last = min<size_t>(count, low * BPT_RESTART_INTERVAL);
+    for (size_t i = first; valid && i < last; i++) {
+        size_t shared = pos + 2 <= end ? static_cast<unsigned char>(data[pos]) : BPT_KEY_WIDTH + 1;
+        size_t suffix = pos + 2 <= end ? static_cast<unsigned char>(data[pos + 1]) : 0;
+        valid = shared <= currentLength && shared + suffix <= BPT_KEY_WIDTH && pos + 2 + suffix + 4 <= end;
+        if (!valid) break;
+
+        memcpy(current + shared, data + pos + 2, suffix);
+        currentLength = shared + suffix;
+        int order = compareKeys(string_view(current, currentLength), key);
+        if (order >= 0) {
+            int32_t value;
+            memcpy(&value, data + pos + 2 + suffix, 4);
+            if (order == 0 && string_view(current, currentLength) == key) RBN = value;
+            break;
+        }
+        pos += 2 + suffix + 4;
+    }
+    if (!valid) {
+        cerr << "Error: Index page " << page << " of " << fileName << " is corrupt" << endl;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Encodes and writes one node page.
+ *
+ * Leaves store (key, RBN) pairs; internal nodes store the first child followed by
+ * (key, child) pairs, where each key is the smallest key below the child after it.
+ * A front coded leaf stores each key as the length of the prefix it shares with the
+ * previous key and the rest of the key, with the offsets of its restart points (the
+ * full keys) at the end of the page.
+ *
+ * @param page Page number.
+ * @param node Node to write.
+ * @return True if the page was written.
+ */
+bool BPlusTree::writeNode(int page, const Node& node) {
+    vector<char> data(pageSize, '\0');
+    uint16_t count = static_cast<uint16_t>(node.keys.size());
+    int32_t next = node.next;
+    data[0] = node.leaf ? 0 : 1;
+    memcpy(&data[2], &count, 2);
+    memcpy(&data[4], &next, 4);
+
+    size_t pos = BPT_NODE_HEADER_SIZE;
+    if (node.leaf && frontCoded) {
+        if (!leafFits(node)) {
+            cerr << "Error: Index leaf does not fit in a " << pageSize << " byte page" << endl;
+            return false;
+        }
+        size_t restart = pageSize - (node.keys.size() + BPT_RESTART_INTERVAL - 1) / BPT_RESTART_INTERVAL * 2;
+        for (size_t i = 0; i < node.keys.size(); i++) {
+            size_t shared = 0;
+            if (i % BPT_RESTART_INTERVAL == 0) {
+                uint16_t offset = static_cast<uint16_t>(pos);
+                memcpy(&data[restart], &offset, 2);
+                restart += 2;
+            } else {
+                shared = sharedPrefix(node.keys[i - 1], node.keys[i]);
+            }
+            size_t suffix = node.keys[i].size() - shared;
+            data[pos] = static_cast<char>(shared);
+            data[pos + 1] = static_cast<char>(suffix);
+            memcpy(&data[pos + 2], node.keys[i].data() + shared, suffix);
+            int32_t value = node.values[i];
+            memcpy(&data[pos + 2 + suffix], &value, 4);
+            pos += 2 + suffix + 4;
+        }
+    } else {
+        if (!node.leaf) {
+            int32_t child = node.values[0];
+            memcpy(&data[pos], &child, 4);
+            pos += 4;
+        }
+        for (size_t i = 0; i < node.keys.size(); i++) {
+            memcpy(&data[pos], node.keys[i].data(), node.keys[i].size());
+            int32_t value = node.values[node.leaf ? i : i + 1];
+            memcpy(&data[pos + BPT_KEY_WIDTH], &value, 4);
+            pos += BPT_KEY_WIDTH + 4;
+        }
+    }
+
+    file.clear();
+    file.seekp(static_cast<long long>(page) * pageSize);
+    file.write(data.data(), pageSize);
+    return file.good();
+}
+
+/**
+ * @brief Writes the meta page (page 0).
+ * @return True if the page was written.
+ */
+bool BPlusTree::writeMeta() {
+    vector<char> data(pageSize, '\0');
+    int32_t values[7] = { pageSize, rootPage, height, firstLeaf, pageCount,
+                          static_cast<int32_t>(BPT_KEY_WIDTH), entryCount };
+    memcpy(&data[0], frontCoded ? BPT_FRONT_CODED_MAGIC : BPT_MAGIC, 4);
+    memcpy(&data[4], values, sizeof(values));
+
+    file.clear();
+    file.seekp(0);
+    file.write(data.data(), pageSize);
+    file.flush();
+    return file.good();
+}
+
+/**
+ * @brief Reserves a new page at the end of the file.
+ * @return Page number of the new page.
+ */
+int BPlusTree::allocatePage() {
+    return pageCount++;
+}
+
+/**
+ * @brief Builds a new tree file bottom-up from entries sorted by key.
+ *
+ * Leaves are filled first and linked left to right, then each internal level is
+ * built over the level below it until a single root remains. Each leaf takes as many
+ * front coded entries as fit its page; internal entries are spread evenly so no node
+ * ends up with a single child.
+ *
+ * @param fileName Path of the index file to create.
+ * @param entries Key and RBN pairs in ascending key order.
+ * @param pageSize Size of each page in bytes.
+ * @return True if the tree was written; the tree is left open on the new file.
+ */
+bool BPlusTree::build(const string& fileName, const vector<pair<string, int>>& entries, int pageSize) {
+    close();
+    this->pageSize = pageSize;
+    frontCoded = true;
+    if (maxInternalKeys() < 2 || pageSize > UINT16_MAX + 1) {
+        cerr << "Error: Index page size " << pageSize << " is out of range" << endl;
+        return false;
+    }
+    for (size_t i = 0; i < entries.size(); i++) {
+        if (entries[i].first.size() > BPT_KEY_WIDTH) {
+            cerr << "Error: Key " << entries[i].first << " is longer than " << BPT_KEY_WIDTH << " bytes" << endl;
+            return false;
+        }
+        if (i > 0 && !keyLess(entries[i - 1].first, entries[i].first)) {
+            cerr << "Error: Index entries are not in ascending key order at " << entries[i].first << endl;
+            return false;
+        }
+    }
+
+    file.open(fileName, ios::in | ios::out | ios::binary | ios::trunc);
+    if (!file.is_open()) {
+        cerr << "Error: Could not create index file: " << fileName << endl;
+        return false;
+    }
+    this->fileName = fileName;
+    pageCount = 1;
+    entryCount = static_cast<int>(entries.size());
+
+    // Leaf level: (first key, page) of every leaf
+    vector<pair<string, int>> level;
+    firstLeaf = pageCount;
+    size_t pos = 0;
+    do {
+        Node node;
+        node.leaf = true;
+        size_t bytes = BPT_NODE_HEADER_SIZE;
+        for (; pos < entries.size(); pos++) {
+            size_t entryBytes = leafEntryBytes(node.keys.empty() ? entries[pos].first : node.keys.back(),
+                                               entries[pos].first, node.keys.size());
+            if (!node.keys.empty() && bytes + entryBytes > static_cast<size_t>(pageSize)) break;
+            bytes += entryBytes;
+            node.keys.push_back(entries[pos].first);
+            node.values.push_back(entries[pos].second);
+        }
+        node.next = pos < entries.size() ? pageCount + 1 : -1;
+        int page = allocatePage();
+        if (!writeNode(page, node)) return false;
+        level.push_back({ node.keys.empty() ? string() : node.keys[0], page });
+    } while (pos < entries.size());
+    height = 1;
+
+    // Internal levels until one node remains
+    while (level.size() > 1) {
+        size_t maxChildren = maxInternalKeys() + 1;
+        size_t nodeCount = (level.size() + maxChildren - 1) / maxChildren;
+        vector<pair<string, int>> upper;
+        for (size_t n = 0, pos = 0; n < nodeCount; n++) {
+            size_t take = level.size() / nodeCount + (n < level.size() % nodeCount ? 1 : 0);
+            Node node;
+            node.leaf = false;
+            node.next = -1;
+            node.values.push_back(level[pos].second);
+            string firstKey = level[pos].first;
+            for (size_t i = 1; i < take; i++) {
+                node.keys.push_back(level[pos + i].first);
+                node.values.push_back(level[pos + i].second);
+            }
+            pos += take;
+            int page = allocatePage();
+            if (!writeNode(page, node)) return false;
+            upper.push_back({ firstKey, page });
+        }
+        level.swap(upper);
+        height++;
+    }
+
+    rootPage = level[0].second;
+    return writeMeta();
+}
+
+/**
+ * @brief Opens an existing tree file.
+ * @param fileName Path of the index file.
+ * @param mapped True to map the file read-only instead of reading pages from it.
+ * @return True if the file holds a valid tree.
+ */
+bool BPlusTree::open(const string& fileName, bool mapped) {
+    close();
+    char data[32];
+    int32_t values[7];
+    bool read;
+    if (mapped) {
+        if (!mapping.open(fileName)) return false;
+        read = mapping.getSize() >= sizeof(data);
+        if (read) memcpy(data, mapping.getData(), sizeof(data));
+    } else {
+        file.open(fileName, ios::in | ios::out | ios::binary);
+        if (!file.is_open()) {
+            cerr << "Error: Could not open index file: " << fileName << endl;
+            return false;
+        }
+        read = static_cast<bool>(file.read(data, sizeof(data)));
+    }
+    bool frontCodedFile = read && memcmp(data, BPT_FRONT_CODED_MAGIC, 4) == 0;
+    if (!read || (!frontCodedFile && memcmp(data, BPT_MAGIC, 4) != 0)) {
+        cerr << "Error: " << fileName << " is not a B+tree index file" << endl;
+        close();
+        return false;
+    }
+    memcpy(values, data + 4, sizeof(values));
+    if (values[5] != static_cast<int32_t>(BPT_KEY_WIDTH)) {
+        cerr << "Error: " << fileName << " uses an unsupported key width" << endl;
+        close();
+        return false;
+    }
+
+    this->fileName = fileName;
+    pageSize = values[0];
+    frontCoded = frontCodedFile;
+    rootPage = values[1];
+    height = values[2];
+    firstLeaf = values[3];
+    pageCount = values[4];
+    entryCount = values[6];
+    pageReads = 0;
+    return true;
+}
+
+/**
+ * @brief Describes the tree, e.g. "4-level B+tree".
+ */
+string BPlusTree::describe() const {
+    return to_string(height) + "-level B+tree";
+}
+
+/**
+ * @brief Closes the tree file.
+ */
+void BPlusTree::close() {
+    if (file.is_open()) file.close();
+    mapping.close();
+    file.clear();
+    fileName.clear();
+    rootPage = -1;
+    height = 0;
+    firstLeaf = -1;
+    pageCount = 0;
+    entryCount = 0;
+}
+
+/**
+ * @brief Descends from the root to the leaf that may hold a key.
+ * @param key Key to look for.
+ * @return Page number of the leaf, or -1 on an I/O error.
+ */
+int BPlusTree::findLeaf(const string& key) {
+    int page = rootPage;
+    Node node;
+    for (int level = 1; level < height; level++) {
+        if (!readNode(page, node)) return -1;
+        size_t child = upper_bound(node.keys.begin(), node.keys.end(), key, keyLess) - node.keys.begin();
+        page = node.values[child];
+    }
+    return page;
+}
+
+/**
+ * @brief Looks up the RBN stored for a key.
+ *
+ * Reads one page per level of the tree. A front coded leaf is searched in place
+ * through its restart points instead of being decoded.
+ *
+ * @param key Key to look up.
+ * @return RBN of the block holding the key, or -1 if the key is not indexed.
+ */
+int BPlusTree::find(const string& key) {
+    if (!isOpen()) return -1;
+    int page = findLeaf(key);
+    if (page < 0) return -1;
+    if (frontCoded) {
+        const char* data = readPage(page);
+        int RBN;
+        return data != nullptr && data[0] == 0 && searchLeaf(page, data, key, RBN) ? RBN : -1;
+    }
+
+    Node leaf;
+    if (!readNode(page, leaf)) return -1;
+
+    auto it = lower_bound(leaf.keys.begin(), leaf.keys.end(), key, keyLess);
+    if (it == leaf.keys.end() || *it != key) return -1;
+    return leaf.values[it - leaf.keys.begin()];
+}
+
+/**
+ * @brief Looks up many keys in one ordered pass over the tree.
+ *
+ * The node read at every level for the previous key is cached together with its page
+ * number. Because the keys ascend, the descent for the next key only reads a page when
+ * it leaves the cached node at that level, and never returns to a page it left. A
+ * front coded leaf is cached as its page bytes and searched in place.
+ *
+ * @param sortedKeys Keys to look up in ascending order.
+ * @param visit Called for each key, in order, with its RBN or -1 if it is not indexed.
+ */
+void BPlusTree::findMany(const vector<string>& sortedKeys, const function<void(const string&, int)>& visit) {
+    vector<Node> path(height);
+    vector<int> pathPage(height, -1);
+    vector<char> leafPage;  ///< Bytes of the cached front coded leaf
+
+    for (const string& key : sortedKeys) {
+        int page = rootPage;
+        bool failed = !isOpen();
+        for (int level = 0; level < height && !failed; level++) {
+            if (pathPage[level] != page && frontCoded && level == height - 1) {
+                const char* data = readPage(page);
+                failed = data == nullptr || data[0] != 0;
+                if (failed) break;
+                leafPage.assign(data, data + pageSize);
+                pathPage[level] = page;
+            } else if (pathPage[level] != page) {
+                if (!readNode(page, path[level])) {
+                    failed = true;
+                    break;
+                }
+                pathPage[level] = page;
+            }
+            const Node& node = path[level];
+            if (level < height - 1 && !node.leaf) {
+                page = node.values[upper_bound(node.keys.begin(), node.keys.end(), key, keyLess) - node.keys.begin()];
+            }
+        }
+
+        int RBN = -1;
+        if (!failed && height > 0 && frontCoded) {
+            if (!searchLeaf(pathPage[height - 1], leafPage.data(), key, RBN)) pathPage[height - 1] = -1;
+        } else if (!failed && height > 0) {
+            const Node& leaf = path[height - 1];
+            auto it = lower_bound(leaf.keys.begin(), leaf.keys.end(), key, keyLess);
+            if (it != leaf.keys.end() && *it == key) RBN = leaf.values[it - leaf.keys.begin()];
+        }
+        visit(key, RBN);
+    }
+}
+
+/**
+ * @brief Finds the largest indexed key.
+ *
+ * Follows the rightmost child down to the last leaf. Leaves emptied by erase() are
+ * skipped by falling back to a scan of the leaf chain.
+ *
+ * @param key Receives the largest key.
+ * @param RBN Receives the RBN stored for it.
+ * @return False if the tree is empty.
+ */
+bool BPlusTree::last(string& key, int& RBN) {
+    if (!isOpen() || entryCount == 0) return false;
+    Node node;
+    int page = rootPage;
+    for (int level = 1; level < height; level++) {
+        if (!readNode(page, node)) return false;
+        page = node.values.back();
+    }
+    if (!readNode(page, node)) return false;
+    if (!node.keys.empty()) {
+        key = node.keys.back();
+        RBN = node.values.back();
+        return true;
+    }
+
+    bool found = false;
+    scan(string(), [&](const string& k, int value) {
+        key = k;
+        RBN = value;
+        found = true;
+        return true;
+    });
+    return found;
+}
+
+/**
+ * @brief Recursive insert or removal below a page, splitting full nodes on the way
+ *        back up.
+ * @param page Page to insert below.
+ * @param key Key to insert or remove.
+ * @param RBN Value to store, or -1 to remove the key.
+ * @param upKey Receives the separator key when the page splits.
+ * @param newPage Receives the new right sibling page when the page splits, else -1.
+ * @return False on an I/O error.
+ */
+bool BPlusTree::insertBelow(int page, const string& key, int RBN, string& upKey, int& newPage) {
+    newPage = -1;
+    Node node;
+    if (!readNode(page, node)) return false;
+
+    if (node.leaf) {
+        auto it = lower_bound(node.keys.begin(), node.keys.end(), key, keyLess);
+        size_t pos = it - node.keys.begin();
+        bool found = it != node.keys.end() && *it == key;
+        if (RBN < 0) {
+            if (!found) return true;
+            node.keys.erase(it);
+            node.values.erase(node.values.begin() + pos);
+            entryCount--;
+        } else if (found) {
+            node.values[pos] = RBN;
+        } else {
+            node.keys.insert(it, key);
+            node.values.insert(node.values.begin() + pos, RBN);
+            entryCount++;
+        }
+        if (leafFits(node)) return writeNode(page, node);
+
+        // Split the leaf, the right half moves to a new page
+        size_t half = node.keys.size() / 2;
+        Node right;
+        right.leaf = true;
+        right.next = node.next;
+        right.keys.assign(node.keys.begin() + half, node.keys.end());
+        right.values.assign(node.values.begin() + half, node.values.end());
+        node.keys.resize(half);
+        node.values.resize(half);
+        newPage = allocatePage();
+        node.next = newPage;
+        upKey = right.keys[0];
+        return writeNode(newPage, right) && writeNode(page, node);
+    }
+
+    size_t child = upper_bound(node.keys.begin(), node.keys.end(), key, keyLess) - node.keys.begin();
+    string childKey;
+    int childPage;
+    if (!insertBelow(node.values[child], key, RBN, childKey, childPage)) return false;
+    if (childPage < 0) return true;
+
+    node.keys.insert(node.keys.begin() + child, childKey);
+    node.values.insert(node.values.begin() + child + 1, childPage);
+    if (node.keys.size() <= maxInternalKeys()) return writeNode(page, node);
+
+    // Split the internal node, the middle key moves up
+    size_t mid = node.keys.size() / 2;
+    Node right;
+    right.leaf = false;
+    right.next = -1;
+    right.keys.assign(node.keys.begin() + mid + 1, node.keys.end());
+    right.values.assign(node.values.begin() + mid + 1, node.values.end());
+    upKey = node.keys[mid];
+    node.keys.resize(mid);
+    node.values.resize(mid + 1);
+    newPage = allocatePage();
+    return writeNode(newPage, right) && writeNode(page, node);
+}
+
+/**
+ * @brief Inserts a key, or replaces the RBN of a key that is already indexed.
+ *
+ * A full node is split in two and its separator is inserted into the parent; when
+ * the root splits the tree grows by one level.
+ *
+ * @param key Key to insert.
+ * @param RBN Relative Block Number of the block holding the key.
+ * @return True if the tree was updated.
+ */
+bool BPlusTree::insert(const string& key, int RBN) {
+    if (!isOpen()) return false;
+    if (mapping.isOpen()) {
+        cerr << "Error: " << fileName << " is open read-only" << endl;
+        return false;
+    }
+    if (key.empty() || key.size() > BPT_KEY_WIDTH) {
+        cerr << "Error: Key " << key << " cannot be indexed" << endl;
+        return false;
+    }
+
+    return update(key, RBN);
+}
+
+/**
+ * @brief Inserts or removes a key from the root down, adding a root when it splits.
+ * @param key Key to insert or remove.
+ * @param RBN Value to store, or -1 to remove the key.
+ * @return False on an I/O error.
+ */
+bool BPlusTree::update(const string& key, int RBN) {
+    string upKey;
+    int newPage;
+    int entries = entryCount;
+    if (!insertBelow(rootPage, key, RBN, upKey, newPage)) return false;
+    if (newPage >= 0) {
+        Node root;
+        root.leaf = false;
+        root.next = -1;
+        root.keys.push_back(upKey);
+        root.values.push_back(rootPage);
+        root.values.push_back(newPage);
+        rootPage = allocatePage();
+        height++;
+        if (!writeNode(rootPage, root)) return false;
+    }
+    if (RBN < 0 && entryCount == entries) return true;
+    return writeMeta();
+}
+
+/**
+ * @brief Removes a key from its leaf, splitting a front coded leaf that grew.
+ * @param key Key to remove.
+ * @return True if the key was indexed and has been removed.
+ */
+bool BPlusTree::erase(const string& key) {
+    if (!isOpen()) return false;
+    if (mapping.isOpen()) {
+        cerr << "Error: " << fileName << " is open read-only" << endl;
+        return false;
+    }
+    int entries = entryCount;
+    return update(key, -1) && entryCount < entries;
+}
+
+/**
+ * @brief Visits entries in key order starting at the first key not less than low.
+ *
+ * Descends once to the leaf for low, then follows the leaf chain.
+ *
+ * @param low Smallest key to visit.
+ * @param visit Called with each key and RBN; return false to stop the scan.
+ */
+void BPlusTree::scan(const string& low, const function<bool(const string&, int)>& visit) {
+    if (!isOpen()) return;
+    Node leaf;
+    int page = findLeaf(low);
+    bool first = true;
+    while (page > 0 && readNode(page, leaf)) {
+        size_t start = 0;
+        if (first) {
+            start = lower_bound(leaf.keys.begin(), leaf.keys.end(), low, keyLess) - leaf.keys.begin();
+            first = false;
+        }
+        for (size_t i = start; i < leaf.keys.size(); i++) {
+            if (!visit(leaf.keys[i], leaf.values[i])) return;
+        }
+        page = leaf.next;
+    }
+}
@@ -0,0 +1,201 @@
+// CSCI 331 Group Project - Copyright © 2024 Blocked Sequence Set Zip Code Processing System
+/**
+ * @file BPlusTree.h
+ * @brief Declaration of the BPlusTree class, a persistent primary key index mapping keys to RBNs.
+ *
+ * The tree lives in its own file of fixed-size pages. Page 0 holds the meta data
+ * (root page, height, first leaf, page and entry counts); every other page is either
+ * an internal node or a leaf. Leaves are chained in key order so range scans can walk
+ * from leaf to leaf without going back through the internal nodes.
+ *
+ * Leaves front code their keys: each key keeps only the bytes after the prefix it
+ * shares with the key before it, except every BPT_RESTART_INTERVAL-th key, which is
+ * stored in full and listed in a table of restart offsets at the end of the page. A
+ * lookup binary searches the restart keys and decodes at most one interval. Trees
+ * written before front coding ("BPT1" files, fixed-width leaf keys) are still read
+ * and updated in their own format.
+ *
+ * A tree can also be opened read-only on a memory mapping of its file, in which case
+ * pages are decoded directly from the mapped memory.
+ */
+
+#ifndef BPLUS_TREE_H
+#define BPLUS_TREE_H
+
+#include <fstream>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+#include "KeyIndex.h"
+#include "MappedFile.h"
+
+/// Bytes reserved for a key inside a page; longer keys are rejected.
+const size_t BPT_KEY_WIDTH = 12;
+
+/// Bytes of the node header at the start of every page (type, count, next leaf).
+const size_t BPT_NODE_HEADER_SIZE = 8;
+
+/// Keys of a front coded leaf from one full key (restart point) to the next.
+const size_t BPT_RESTART_INTERVAL = 16;
+
+/**
+ * @class BPlusTree
+ * @brief Disk-based B+tree from primary key to Relative Block Number.
+ *
+ * Keys are ordered with compareKeys(), the same order as the sequence set, so walking
+ * the leaf chain visits keys in the order the blocks store them.
+ */
+class BPlusTree : public KeyIndex {
+public:
+    BPlusTree();
+
+    /**
+     * @brief Builds a new tree file bottom-up from entries sorted by key.
+     * @param fileName Path of the index file to create.
+     * @param entries Key and RBN pairs in ascending key order.
+     * @param pageSize Size of each page in bytes.
+     * @return True if the tree was written; the tree is left open on the new file.
+     */
+    bool build(const std::string& fileName, const std::vector<std::pair<std::string, int>>& entries, int pageSize = 512) override;
+
+    /**
+     * @brief Opens an existing tree file.
+     *
+     * A mapped tree is read-only; insert() and erase() fail on it.
+     *
+     * @param fileName Path of the index file.
+     * @param mapped True to map the file read-only instead of reading pages from it.
+     * @return True if the file holds a valid tree.
+     */
+    bool open(const std::string& fileName, bool mapped = false) override;
+
+    /**
+     * @brief Closes the tree file.
+     */
+    void close() override;
+
+    /**
+     * @brief Looks up the RBN stored for a key.
+     * @param key Key to look up.
+     * @return RBN of the block holding the key, or -1 if the key is not indexed.
+     */
+    int find(const std::string& key) override;
+
+    /**
+     * @brief Looks up many keys in one ordered pass over the tree.
+     *
+     * Keys must be sorted with compareKeys() and free of duplicates. The nodes on the
+     * path of the previous key are kept, so every page is read at most once per call.
+     *
+     * @param sortedKeys Keys to look up in ascending order.
+     * @param visit Called for each key, in order, with its RBN or -1 if it is not indexed.
+     */
+    void findMany(const std::vector<std::string>& sortedKeys, const std::function<void(const std::string&, int)>& visit) override;
+
+    /**
+     * @brief Finds the largest indexed key.
+     * @param key Receives the largest key.
+     * @param RBN Receives the RBN stored for it.
+     * @return False if the tree is empty.
+     */
+    bool last(std::string& key, int& RBN) override;
+
+    /**
+     * @brief Inserts a key, or replaces the RBN of a key that is already indexed.
+     * @param key Key to insert.
+     * @param RBN Relative Block Number of the block holding the key.
+     * @return True if the tree was updated.
+     */
+    bool insert(const std::string& key, int RBN) override;
+
+    /**
+     * @brief Removes a key from its leaf.
+     *
+     * Leaves are not merged when they become sparse; the leaf chain simply skips over
+     * empty leaves during scans. A front coded leaf can grow when a key leaves it (the
+     * next key may share less with its new neighbour, or become a restart point), and
+     * is then split as on an insert.
+     *
+     * @param key Key to remove.
+     * @return True if the key was indexed and has been removed.
+     */
+    bool erase(const std::string& key) override;
+
+    /**
+     * @brief Visits entries in key order starting at the first key not less than low.
+     * @param low Smallest key to visit.
+     * @param visit Called with each key and RBN; return false to stop the scan.
+     */
+    void scan(const std::string& low, const std::function<bool(const std::string&, int)>& visit) override;
+
+    /**
+     * @brief Describes the tree, e.g. "4-level B+tree".
+     */
+    std::string describe() const override;
+
+    bool isOpen() const override { return file.is_open() || mapping.isOpen(); }
+    bool isMapped() const { return mapping.isOpen(); }
+    const std::string& getFileName() const override { return fileName; }
+    int getHeight() const { return height; }
+    int getPageCount() const { return pageCount; }
+    int getEntryCount() const override { return entryCount; }
+    unsigned long long getPageReads() const { return pageReads; }
+
+private:
+    /**
+     * @brief Decoded contents of one page.
+     */
+    struct Node {
+        bool leaf;                      ///< True for leaves, false for internal nodes
+        int next;                       ///< Next leaf in key order, -1 for the last leaf
+        std::vector<std::string> keys;  ///< Keys in ascending order
+        std::vector<int> values;        ///< Leaf: RBN per key; internal: child pages (keys + 1)
+    };
+
+    const char* readPage(int page);
+    bool readNode(int page, Node& node);
+    bool decodeLeaf(int page, const char* data, Node& node) const;
+    bool searchLeaf(int page, const char* data, const std::string& key, int& RBN) const;
+    bool writeNode(int page, const Node& node);
+    bool writeMeta();
+    int allocatePage();
+    int findLeaf(const std::string& key);
+    size_t maxLeafKeys() const;
+    size_t maxInternalKeys() const;
+    bool leafFits(const Node& node) const;
+
+    /**
+     * @brief Recursive insert or removal below a page.
+     * @param page Page to insert below.
+     * @param key Key to insert or remove.
+     * @param RBN Value to store, or -1 to remove the key.
+     * @param upKey Receives the separator key when the page splits.
+     * @param newPage Receives the new right sibling page when the page splits, else -1.
+     * @return False on an I/O error.
+     */
+    bool insertBelow(int page, const std::string& key, int RBN, std::string& upKey, int& newPage);
+
+    /**
+     * @brief Inserts or removes a key from the root down, adding a root when it splits.
+     * @param key Key to insert or remove.
+     * @param RBN Value to store, or -1 to remove the key.
+     * @return False on an I/O error.
+     */
+    bool update(const std::string& key, int RBN);
+
+    std::string fileName;          ///< Path of the open index file
+    std::fstream file;             ///< Open index file
+    MappedFile mapping;            ///< Read-only mapping of the index file, if mapped
+    std::vector<char> buffer;      ///< Page buffer for reads from the file
+    int pageSize;                  ///< Size of each page in bytes
+    bool frontCoded;               ///< True if leaves front code their keys
+    int rootPage;                  ///< Page number of the root
+    int height;                    ///< Number of levels, 1 when the root is a leaf
+    int firstLeaf;                 ///< Page number of the leftmost leaf
+    int pageCount;                 ///< Number of pages including the meta page
+    int entryCount;                ///< Number of indexed keys
+    unsigned long long pageReads;  ///< Pages read since the tree was opened
+};
+
+#endif // BPLUS_TREE_H
@@ -4,17 +4,73 @@
 #include <fstream>
 #include <sstream>
 #include <vector>
-#include <map>
+#include <algorithm>
+#include <cstring>
+#include <chrono>
+#include <cerrno>
 #include "HeaderRecord.h"
+#include "BufferPool.h"
+#include "KeyIndex.h"
+#include "BlockView.h"
+#include "StateExtremes.h"
+#include "ParallelScan.h"
+#include "BloomFilter.h"
+#include "SpatialIndex.h"
+#include "SecondaryIndex.h"
+#include "PrefixTrie.h"
+#include "Index.h"
 
 using namespace std;
 
 /**
- * @brief Global map of blocks indexed by Relative Block Number (RBN).
+ * @brief Buffer pool through which every block of the open block file is read.
  * 
- * This map stores all blocks, where the key is the RBN, and the value is the block object.
+ * Frames are filled on demand, so memory use depends on the frame count rather than the file size.
  */
-map<int, Block> blocks;
+BufferPool blockPool;
+
+/**
+ * @brief Primary key index used by search() to find the block that holds a zip code.
+ */
+std::unique_ptr<KeyIndex> primaryIndex;
+
+/**
+ * @brief Bloom filter over the primary keys, checked before primaryIndex.
+ */
+BloomFilter primaryFilter;
+
+/**
+ * @brief K-d tree over the record locations, built by the first spatial query and
+ *        dropped whenever a record is inserted or deleted.
+ */
+SpatialIndex spatialIndex;
+
+/**
+ * @brief Secondary indexes of the open block file by field number, loaded on first use.
+ */
+vector<SecondaryIndex> secondaryIndexes;
+
+/**
+ * @brief Place name trie of the open block file, mapped on first use.
+ */
+PrefixTrie placeTrie;
+
+/**
+ * @brief True once records were inserted or deleted since placeTrie was built; a
+ *        checkpoint then deletes the trie file, so later runs rebuild it too.
+ */
+static bool placeTrieStale = false;
+
+/**
+ * @brief False positive rate of the Bloom filter rebuilt by rollbackMutation().
+ */
+static double indexBloomRate = DEFAULT_BLOOM_FPR;
+
+/**
+ * @brief True once a rolled back mutation left index files that could not be rebuilt,
+ *        so checkpoints keep the block file stale and the next open rebuilds them.
+ */
+static bool indexesDiverged = false;
 
 /**
  * @brief Head of the active block list (RBN).
@@ -31,134 +87,767 @@ int listHeadRBN = -1;
 int availHeadRBN = -1;
 
 /**
- * @brief Creates a block file from an input CSV file.
- * 
- * This function reads an input CSV file, divides its data into fixed-size blocks, 
- * and writes those blocks into a new output file.
- * 
+ * @brief Compares two primary keys in sequence set order.
+ *
+ * Keys made only of digits compare by numeric value (so "501" sorts before "1001"),
+ * any other keys compare as plain strings.
+ *
+ * @param a First key.
+ * @param b Second key.
+ * @return Negative, zero or positive as a is less than, equal to or greater than b.
+ */
+int compareKeys(std::string_view a, std::string_view b) {
+    auto isNumber = [](std::string_view key) {
+        if (key.empty()) return false;
+        for (char c : key) {
+            if (c < '0' || c > '9') return false;
+        }
+        return true;
+    };
+    if (!isNumber(a) || !isNumber(b)) return a.compare(b);
+
+    size_t aStart = a.find_first_not_of('0');
+    size_t bStart = b.find_first_not_of('0');
+    if (aStart == std::string_view::npos) aStart = a.size();
+    if (bStart == std::string_view::npos) bStart = b.size();
+    size_t aDigits = a.size() - aStart;
+    size_t bDigits = b.size() - bStart;
+    if (aDigits != bDigits) return aDigits < bDigits ? -1 : 1;
+    return a.compare(aStart, aDigits, b, bStart, bDigits);
+}
+
+/**
+ * @brief Number of fields per record declared by a header record.
+ *
+ * Falls back to the six zip code fields when the header carries no field metadata.
+ *
+ * @param header Header record of the block file.
+ * @return Number of fields per record.
+ */
+size_t recordFieldCount(const HeaderRecord& header) {
+    size_t count = header.getFields().size();
+    return count > 0 ? count : 6;
+}
+
+/**
+ * @brief Finds a field by name in the header field metadata.
+ * @param header Header record of the block file.
+ * @param name Field name, e.g. "state".
+ * @param fallback Field number to use when the header does not name the field.
+ * @return Field number.
+ */
+size_t fieldIndex(const HeaderRecord& header, const std::string& name, size_t fallback) {
+    const auto& fields = header.getFields();
+    for (size_t i = 0; i < fields.size(); i++) {
+        if (fields[i].name == name) return i;
+    }
+    return fallback;
+}
+
+/**
+ * @brief Splits the comma separated text of one record into its fields.
+ * @param text Record text.
+ * @param fields Vector the fields are appended to.
+ */
+static void appendFields(const string& text, vector<string>& fields) {
+    size_t start = 0;
+    while (true) {
+        size_t comma = text.find(',', start);
+        if (comma == string::npos) {
+            fields.push_back(text.substr(start));
+            return;
+        }
+        fields.push_back(text.substr(start, comma - start));
+        start = comma + 1;
+    }
+}
+
+/**
+ * @brief Writes the header record at the start of a block file and pads it to the header size.
+ *
+ * The header region is a whole number of blocks. If the header text does not fit in the
+ * current header size, the region is grown when allowed, otherwise writing fails.
+ *
+ * @param out Block file opened in binary mode.
+ * @param header Header record to write; its header size may be updated.
+ * @param allowGrow True if the header region may still be enlarged.
+ * @return True if the header was written.
+ */
+bool writeHeaderRegion(std::ostream& out, HeaderRecord& header, bool allowGrow) {
+    long long blockSize = header.getBlockSize();
+    if (header.getHeaderSize() <= 0) header.setHeaderSize(static_cast<int>(blockSize));
+
+    while (true) {
+        out.seekp(0);
+        if (!header.writeHeader(out)) return false;
+        long long used = out.tellp();
+        if (used <= header.getHeaderSize()) {
+            string padding(header.getHeaderSize() - used, '\0');
+            out.write(padding.data(), padding.size());
+            return out.good();
+        }
+        if (!allowGrow) {
+            cerr << "Error: Header record no longer fits in its " << header.getHeaderSize() << " byte region" << endl;
+            return false;
+        }
+        header.setHeaderSize(static_cast<int>(((used + blockSize - 1) / blockSize) * blockSize));
+    }
+}
+
+/**
+ * @brief Packs the records of a CSV file into a new block file in one sequential pass.
+ *
+ * Each block is written as a binary block header followed by its records and zero
+ * padding up to BLOCK_SIZE bytes. A block is closed once the next record would take its
+ * records past fillFactor of the space after the block header, leaving the rest for
+ * later inserts. When an index is given, every written block is also added to it, and
+ * the records must then arrive in strictly increasing key order.
+ *
+ * In a compressed file a block is also closed once its records, compressed, would take
+ * more than fillFactor of the space after the block header of a compressed block. The
+ * records are only compressed for this test once they no longer fit uncompressed.
+ *
  * @param inputFile Path to the input CSV file.
  * @param outputFile Path to the output block file.
- * @param BLOCK_SIZE Maximum size of each block in bytes.
+ * @param BLOCK_SIZE Size of each block in bytes.
+ * @param indexSchema Index schema recorded in the header; it selects the index format.
+ * @param fillFactor Fraction of each block's record space filled, from the minimum block
+ *                   capacity up to 1.
+ * @param indexFile Index file named in the header record.
+ * @param compression Codec of the blocks.
+ * @param compressedBlockSize Bytes each block takes on disk; 0 for the default of the codec.
+ * @param index Collects the index entries of the blocks, or nullptr.
  * @return True if the file was successfully created, false otherwise.
  */
-bool createBlockFile(const std::string& inputFile, const std::string& outputFile, size_t BLOCK_SIZE) {
+static bool writeBlockFile(const std::string& inputFile, const std::string& outputFile, size_t BLOCK_SIZE,
+                           const std::string& indexSchema, double fillFactor, const std::string& indexFile,
+                           const std::string& compression, size_t compressedBlockSize, Index* index) {
     ifstream inFile(inputFile);
-    ofstream outFile(outputFile);
+    ofstream outFile(outputFile, ios::binary);
     if (!inFile.is_open() || !outFile.is_open()) {
         cerr << "Error: Could not open input or output file: " << inputFile << " | " << outputFile << endl;
         return false;
     }
+    if (BLOCK_SIZE <= BLOCK_HEADER_SIZE || BLOCK_SIZE > MAX_BLOCK_SIZE) {
+        cerr << "Error: Block size " << BLOCK_SIZE << " is not between " << BLOCK_HEADER_SIZE + 1
+             << " and " << MAX_BLOCK_SIZE << " bytes" << endl;
+        return false;
+    }
+    const BlockCodec* codec = findBlockCodec(compression);
+    if (codec == nullptr) {
+        cerr << "Error: Unknown compression " << compression << " (one of " << blockCodecNames() << ")" << endl;
+        return false;
+    }
+    if (compressedBlockSize == 0 && compression != "none") compressedBlockSize = codec->defaultStoredSize(BLOCK_SIZE);
+    if (compressedBlockSize != 0 && (compressedBlockSize <= BLOCK_HEADER_SIZE || compressedBlockSize > BLOCK_SIZE)) {
+        cerr << "Error: Compressed block size " << compressedBlockSize << " is not between " << BLOCK_HEADER_SIZE + 1
+             << " and the block size of " << BLOCK_SIZE << " bytes" << endl;
+        return false;
+    }
 
     HeaderRecord header;
     
     // Set basic header information
     header.setFileStructureType("blocked_sequence_set");
     header.setVersion("1.0");
-    header.setBlockSize(512);  // Default block size
+    header.setBlockSize(static_cast<int>(BLOCK_SIZE));
     header.setMinBlockCapacity(0.5);  // 50% minimum capacity
-    header.setIndexFileName("headerTest.idx");
-    header.setIndexSchema("key:string,rbn:int");
+    header.setFillFactor(fillFactor);
+    header.setCompression(codec->getName());
+    header.setCompressedBlockSize(static_cast<int>(compressedBlockSize));
+    header.setIndexFileName(indexFile);
+    header.setIndexSchema(indexSchema);
+    if (!(fillFactor >= header.getMinBlockCapacity() && fillFactor <= 1)) {
+        cerr << "Error: Fill factor " << fillFactor << " is not between " << header.getMinBlockCapacity()
+             << " and 1" << endl;
+        return false;
+    }
+
+    // Describe the record fields so readers know how many fields make up a record
+    header.addField("zip_code", "string(5)");
+    header.addField("place_name", string("string(64)") + SECONDARY_INDEX_TAG);
+    header.addField("state", string("string(2)") + SECONDARY_INDEX_TAG);
+    header.addField("county", string("string(64)") + SECONDARY_INDEX_TAG);
+    header.addField("latitude", "decimal(8,4)");
+    header.addField("longitude", "decimal(8,4)");
     
     // Set primary key field (zip_code is field 0)
     header.setPrimaryKeyField(0);
+    header.setActiveListRBN(1);
 
     // First write the header
-    if (!header.writeHeader(outFile)) {
+    if (!writeHeaderRegion(outFile, header, true)) {
         std::cerr << "Failed to write header to output file" << std::endl;
         return false;
     }
+    if (index != nullptr) index->begin(header);
 
-    size_t blockNumber = 1;               ///< Current block number being written
-    size_t currentBlockSize = 0;          ///< Current size of the block in bytes
-    vector<string> blockRecords;          ///< Records for the current block
+    const size_t capacity = BLOCK_SIZE - BLOCK_HEADER_SIZE;  ///< Bytes available for records
+    const size_t fillLimit = static_cast<size_t>(capacity * fillFactor);  ///< Bytes filled before a block is closed
+    const size_t storedCapacity = compressedBlockSize ? compressedBlockSize - BLOCK_HEADER_SIZE : capacity;
+    const size_t storedLimit = static_cast<size_t>(storedCapacity * fillFactor);  ///< Same, after compression
+    const size_t fieldCount = recordFieldCount(header);
+    const size_t keyField = header.getPrimaryKeyField();
+    string lastKey;                       ///< Key of the previous record, to check the order
+    size_t currentBlockSize = 0;          ///< Bytes of records in the current block
+    int recordCount = 0;                  ///< Records written, for the header
+
+    vector<ZoneMap> zones;                ///< Zone map of every written block, for the sidecar file
+    string storedRecords;                 ///< Records of the current block as packBlock() lays them out
+    string compressed(storedCapacity, '\0');  ///< Scratch output of the compression test
+
+    // True if the current block can take one more record of lineSize bytes
+    auto fits = [&](const string& line, size_t lineSize) {
+        if (currentBlockSize + lineSize > fillLimit) return false;
+        if (compressedBlockSize == 0 || currentBlockSize + lineSize <= storedLimit) return true;
+        uint16_t length = static_cast<uint16_t>(line.size());
+        size_t before = storedRecords.size();
+        storedRecords.append(reinterpret_cast<const char*>(&length), 2).append(line);
+        bool fit = codec->compress(storedRecords.data(), storedRecords.size(), &compressed[0], storedLimit) != 0;
+        storedRecords.resize(before);
+        return fit;
+    };
+
+    Block current;                        ///< Block currently being filled
+    current.RBN = 1;
+    current.isAvailable = false;
+    current.predecessorRBN = -1;
+    current.successorRBN = -1;
 
     string line;
     getline(inFile, line); // Skip header
     while (getline(inFile, line)) {
-        size_t lineSize = line.size() + 1; // Include newline character
-        if (currentBlockSize + lineSize > BLOCK_SIZE) {
-            // Write the current block to the output file
-            outFile << blockNumber << ":";
-            for (size_t i = 0; i < blockRecords.size(); i++) {
-                outFile << blockRecords[i];
-                if (i < blockRecords.size() - 1) outFile << ",";
-            }
-            outFile << "\n";
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty()) continue;
 
-            blockRecords.clear();
+        size_t lineSize = line.size() + 2; // Include the length prefix
+        if (lineSize > capacity || lineSize > storedCapacity) {
+            cerr << "Error: Record does not fit in a " << BLOCK_SIZE << " byte block: " << line << endl;
+            return false;
+        }
+        if (currentBlockSize > 0 && !fits(line, lineSize)) {
+            // The current block is full, link it to the next one and write it
+            current.successorRBN = current.RBN + 1;
+            if (!writeBlock(outFile, header, current)) return false;
+            zones.push_back(ZoneMap::of(current, header));
+            if (index != nullptr) index->addBlock(current);
+
+            current.predecessorRBN = current.RBN;
+            current.RBN++;
+            current.records.clear();
             currentBlockSize = 0;
-            blockNumber++;
+            storedRecords.clear();
         }
 
-        blockRecords.push_back(line);
+        size_t first = current.records.size();
+        appendFields(line, current.records);
         currentBlockSize += lineSize;
+        if (compressedBlockSize != 0) {
+            uint16_t length = static_cast<uint16_t>(line.size());
+            storedRecords.append(reinterpret_cast<const char*>(&length), 2).append(line);
+        }
+        recordCount++;
+
+        if (index != nullptr) {
+            if (current.records.size() - first != fieldCount) {
+                cerr << "Error: Record does not have " << fieldCount << " fields: " << line << endl;
+                return false;
+            }
+            const string& key = current.records[first + keyField];
+            if (recordCount > 1 && compareKeys(lastKey, key) >= 0) {
+                cerr << "Error: " << inputFile << " is not sorted by key: " << key << " follows " << lastKey << endl;
+                return false;
+            }
+            lastKey = key;
+        }
     }
 
     // Write the last block if there are remaining records
-    if (!blockRecords.empty()) {
-        outFile << blockNumber << ":";
-        for (size_t i = 0; i < blockRecords.size(); i++) {
-            outFile << blockRecords[i];
-            if (i < blockRecords.size() - 1) outFile << ",";
-        }
-        outFile << "\n";
+    current.successorRBN = -1;
+    if (!current.records.empty()) {
+        if (!writeBlock(outFile, header, current)) return false;
+        zones.push_back(ZoneMap::of(current, header));
+        if (index != nullptr) index->addBlock(current);
+    } else if (current.RBN == 1) {
+        header.setActiveListRBN(-1);
     }
 
+    // The counts are only known now, so the header is written again
+    header.setRecordCount(recordCount);
+    header.setBlockCount(static_cast<int>(zones.size()));
+    if (!writeHeaderRegion(outFile, header, false)) return false;
+
     inFile.close();
     outFile.close();
 
-    return true;
+    // Summaries of every block, so queries can skip blocks without reading them
+    return writeZoneMapFile(zoneMapFileName(outputFile), zones);
 }
 
 /**
- * @brief Parses a block file and populates the global map of blocks.
+ * @brief Creates a block file from an input CSV file.
  * 
- * This function reads a block file, splits its content into blocks, 
- * and populates the `blocks` map with their respective details.
+ * This function reads an input CSV file, divides its data into fixed-size blocks, 
+ * and writes those blocks into a new output file. Each block is written as a binary
+ * block header followed by its records and zero padding up to BLOCK_SIZE bytes.
  * 
- * @param blockFile Path to the block file to parse.
+ * @param inputFile Path to the input CSV file.
+ * @param outputFile Path to the output block file.
+ * @param BLOCK_SIZE Size of each block in bytes.
+ * @param indexSchema Index schema recorded in the header; it selects the index format.
+ * @return True if the file was successfully created, false otherwise.
  */
-void parseBlockFile(const string& blockFile) {
-    ifstream inFile(blockFile);
-    if (!inFile.is_open()) {
-        cerr << "Error: Could not open block file: " << blockFile << endl;
-        return;
+bool createBlockFile(const std::string& inputFile, const std::string& outputFile, size_t BLOCK_SIZE, const std::string& indexSchema) {
+    return writeBlockFile(inputFile, outputFile, BLOCK_SIZE, indexSchema, 1.0, DEFAULT_INDEX_FILE,
+                          DEFAULT_BLOCK_CODEC, 0, nullptr);
+}
+
+/**
+ * @brief Bulk loads a CSV file sorted by key into a new block file and its indexes.
+ *
+ * The CSV file is read once: blocks are packed to the fill factor and written in
+ * order, and the primary key, Bloom filter, secondary index and trie entries are
+ * collected from the same records, so the block file never has to be read back.
+ * The header record counts are written with the blocks.
+ *
+ * @param inputFile Path to the input CSV file, in strictly increasing key order.
+ * @param outputFile Path to the output block file.
+ * @param BLOCK_SIZE Size of each block in bytes.
+ * @param indexSchema Index schema recorded in the header; it selects the index format.
+ * @param fillFactor Fraction of each block's record space filled by the load.
+ * @param falsePositiveRate False positive rate the Bloom filter is sized for.
+ * @param indexFile Index file to create and name in the header record.
+ * @param compression Codec of the blocks.
+ * @param compressedBlockSize Bytes each block takes on disk; 0 for the default of the codec.
+ * @return True if the block file and every index were written.
+ */
+bool bulkLoad(const std::string& inputFile, const std::string& outputFile, size_t BLOCK_SIZE,
+              const std::string& indexSchema, double fillFactor, double falsePositiveRate,
+              const std::string& indexFile, const std::string& compression, size_t compressedBlockSize) {
+    Index index;
+    return writeBlockFile(inputFile, outputFile, BLOCK_SIZE, indexSchema, fillFactor, indexFile,
+                          compression, compressedBlockSize, &index)
+        && index.save(indexFile, falsePositiveRate);
+}
+
+/**
+ * @brief Bytes one block takes in the block file: the compressed block size of a
+ *        compressed file, otherwise the block size.
+ * @param header Header record of the block file.
+ * @return Bytes per block on disk.
+ */
+size_t storedBlockSize(const HeaderRecord& header) {
+    return header.getCompressedBlockSize() > 0 ? header.getCompressedBlockSize() : header.getBlockSize();
+}
+
+/**
+ * @brief Computes the byte offset of a block in the block file.
+ *
+ * Blocks are numbered from 1 and laid out back to back after the header region, each
+ * taking storedBlockSize() bytes.
+ *
+ * @param header Header record of the block file.
+ * @param RBN Relative Block Number of the block.
+ * @return Offset of the first byte of the block.
+ */
+long long blockOffset(const HeaderRecord& header, int RBN) {
+    return static_cast<long long>(header.getHeaderSize()) +
+           static_cast<long long>(RBN - 1) * storedBlockSize(header);
+}
+
+/**
+ * @brief Counts the blocks stored in a block file from its size.
+ * @param header Header record of the block file.
+ * @param in Block file opened in binary mode.
+ * @return Number of blocks following the header.
+ */
+int countBlocks(const HeaderRecord& header, std::istream& in) {
+    in.clear();
+    in.seekg(0, ios::end);
+    long long size = in.tellg();
+    long long blockSize = static_cast<long long>(storedBlockSize(header));
+    if (size <= header.getHeaderSize() || blockSize <= 0) return 0;
+    return static_cast<int>((size - header.getHeaderSize()) / blockSize);
+}
+
+/**
+ * @brief Encodes a block into its fixed-size image, zone map included.
+ *
+ * The image starts with the binary block header described by BLOCK_HEADER_SIZE, followed by
+ * one length-prefixed record per group of fieldCount fields and zero padding.
+ *
+ * @param block Block to encode.
+ * @param header Header record giving the block size and the record fields.
+ * @param out Receives exactly blockSize bytes.
+ * @return False if the records do not fit in one block.
+ */
+bool packBlock(const Block& block, const HeaderRecord& header, std::string& out) {
+    size_t fieldCount = recordFieldCount(header);
+    size_t blockSize = header.getBlockSize();
+    out.assign(blockSize, '\0');
+    if (blockSize < BLOCK_HEADER_SIZE || fieldCount == 0) return false;
+
+    int32_t recordCount = static_cast<int32_t>(block.records.size() / fieldCount);
+    int32_t predecessor = block.predecessorRBN;
+    int32_t successor = block.successorRBN;
+    memcpy(&out[0], &recordCount, 4);
+    memcpy(&out[4], &predecessor, 4);
+    memcpy(&out[8], &successor, 4);
+    out[12] = block.isAvailable ? 1 : 0;
+    ZoneMap::of(block, header).encode(&out[BLOCK_ZONE_MAP_OFFSET]);
+
+    size_t pos = BLOCK_HEADER_SIZE;
+    for (size_t first = 0; first + fieldCount <= block.records.size(); first += fieldCount) {
+        string text = block.records[first];
+        for (size_t i = first + 1; i < first + fieldCount; i++) {
+            text += ",";
+            text += block.records[i];
+        }
+        if (text.size() > UINT16_MAX || pos + 2 + text.size() > blockSize) return false;
+
+        uint16_t length = static_cast<uint16_t>(text.size());
+        memcpy(&out[pos], &length, 2);
+        memcpy(&out[pos + 2], text.data(), text.size());
+        pos += 2 + text.size();
     }
+    return true;
+}
 
-    string line;
-    while (getline(inFile, line)) {
-        size_t colonPos = line.find(':');
-        int RBN = stoi(line.substr(0, colonPos));  ///< Extracted RBN of the block
-        string recordsPart = line.substr(colonPos + 1);
-
-        vector<string> records;                   ///< Records in the block
-        stringstream recordStream(recordsPart);
-        string record;
-        while (getline(recordStream, record, ',')) {
-            records.push_back(record);
+/**
+ * @brief Turns a block image into the image stored in the block file.
+ *
+ * The records of the image end at its last nonzero byte, since the padding after them
+ * is zero. In a compressed file the stored image is the block header, with the codec
+ * flag and the length of the stored records set, followed by the records compressed
+ * with the codec of the file, or as they are if that is not smaller, and zero padding.
+ *
+ * @param header Header record of the block file.
+ * @param image Block image of blockSize bytes from packBlock().
+ * @param stored Receives storedBlockSize() bytes.
+ * @return False if the records do not fit in the compressed block size.
+ */
+bool compressBlock(const HeaderRecord& header, const std::string& image, std::string& stored) {
+    if (header.getCompressedBlockSize() <= 0) {
+        stored = image;
+        return true;
+    }
+    const BlockCodec* codec = findBlockCodec(header.getCompression());
+    if (codec == nullptr || image.size() < BLOCK_HEADER_SIZE || storedBlockSize(header) <= BLOCK_HEADER_SIZE) return false;
+    size_t room = storedBlockSize(header) - BLOCK_HEADER_SIZE;
+
+    size_t end = image.size();
+    while (end > BLOCK_HEADER_SIZE && image[end - 1] == '\0') end--;
+    size_t rawBytes = end - BLOCK_HEADER_SIZE;
+
+    stored.assign(storedBlockSize(header), '\0');
+    memcpy(&stored[0], image.data(), BLOCK_HEADER_SIZE);
+    size_t length = rawBytes == 0 ? 0 : codec->compress(image.data() + BLOCK_HEADER_SIZE, rawBytes,
+                                                          &stored[BLOCK_HEADER_SIZE], room);
+    char compressed = 1;
+    if (length == 0 || length >= rawBytes) {
+        // Not worth decompressing: store the records as they are
+        if (rawBytes > room) return false;
+        memcpy(&stored[BLOCK_HEADER_SIZE], image.data() + BLOCK_HEADER_SIZE, rawBytes);
+        memset(&stored[BLOCK_HEADER_SIZE + rawBytes], 0, room - rawBytes);
+        length = rawBytes;
+        compressed = 0;
+    }
+    uint16_t storedLength = static_cast<uint16_t>(length);
+    stored[BLOCK_CODEC_FLAG_OFFSET] = compressed;
+    memcpy(&stored[BLOCK_STORED_LENGTH_OFFSET], &storedLength, 2);
+
+    return true;
+}
+
+/**
+ * @brief Turns an image stored in the block file back into the block image.
+ *
+ * The time spent on a compressed file is added to codecStats.
+ *
+ * @param header Header record of the block file.
+ * @param stored storedBlockSize() bytes read from the block file.
+ * @param image Receives blockSize bytes.
+ * @return False if the stored records are malformed.
+ */
+bool expandBlock(const HeaderRecord& header, const char* stored, char* image) {
+    size_t blockSize = header.getBlockSize();
+    if (header.getCompressedBlockSize() <= 0) {
+        memcpy(image, stored, blockSize);
+        return true;
+    }
+    auto start = chrono::steady_clock::now();
+    const BlockCodec* codec = findBlockCodec(header.getCompression());
+    size_t room = storedBlockSize(header) - BLOCK_HEADER_SIZE;
+    uint16_t length;
+    memcpy(&length, stored + BLOCK_STORED_LENGTH_OFFSET, 2);
+    if (codec == nullptr || length > room || blockSize <= BLOCK_HEADER_SIZE) return false;
+
+    memcpy(image, stored, BLOCK_HEADER_SIZE);
+    memset(image + BLOCK_CODEC_FLAG_OFFSET, 0, BLOCK_ZONE_MAP_OFFSET - BLOCK_CODEC_FLAG_OFFSET);
+    size_t rawBytes = length;
+    if (stored[BLOCK_CODEC_FLAG_OFFSET] == 0) {
+        if (length > blockSize - BLOCK_HEADER_SIZE) return false;
+        memcpy(image + BLOCK_HEADER_SIZE, stored + BLOCK_HEADER_SIZE, length);
+    } else {
+        rawBytes = codec->decompress(stored + BLOCK_HEADER_SIZE, length, image + BLOCK_HEADER_SIZE,
+                                     blockSize - BLOCK_HEADER_SIZE);
+        if (rawBytes == 0) return false;
+    }
+    memset(image + BLOCK_HEADER_SIZE + rawBytes, 0, blockSize - BLOCK_HEADER_SIZE - rawBytes);
+
+    codecStats.decompressedBlocks++;
+    codecStats.rawBytes += rawBytes;
+    codecStats.storedBytes += length;
+    codecStats.decompressNanos += static_cast<unsigned long long>(
+        chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count());
+    return true;
+}
+
+/**
+ * @brief Decodes a fixed-size block image.
+ * @param data Pointer to blockSize bytes of block data.
+ * @param blockSize Size of the block image in bytes.
+ * @param RBN Relative Block Number the image was read from.
+ * @param block Receives the decoded block.
+ * @return False if the image is malformed.
+ */
+bool unpackBlock(const char* data, size_t blockSize, int RBN, Block& block) {
+    if (blockSize < BLOCK_HEADER_SIZE) return false;
+
+    int32_t recordCount, predecessor, successor;
+    memcpy(&recordCount, data, 4);
+    memcpy(&predecessor, data + 4, 4);
+    memcpy(&successor, data + 8, 4);
+
+    block.RBN = RBN;
+    block.isAvailable = data[12] != 0;
+    block.predecessorRBN = predecessor;
+    block.successorRBN = successor;
+    block.records.clear();
+
+    size_t pos = BLOCK_HEADER_SIZE;
+    for (int32_t i = 0; i < recordCount; i++) {
+        if (pos + 2 > blockSize) return false;
+        uint16_t length;
+        memcpy(&length, data + pos, 2);
+        pos += 2;
+        if (pos + length > blockSize) return false;
+        appendFields(string(data + pos, length), block.records);
+        pos += length;
+    }
+    return true;
+}
+
+/**
+ * @brief Reads one block from a block file with a single seek.
+ * @param in Block file opened in binary mode.
+ * @param header Header record of the block file.
+ * @param RBN Relative Block Number of the block to read.
+ * @param block Receives the decoded block.
+ * @return True if the block was read and decoded.
+ */
+bool readBlock(std::istream& in, const HeaderRecord& header, int RBN, Block& block) {
+    if (RBN < 1) return false;
+    string stored(storedBlockSize(header), '\0');
+    string image(header.getBlockSize(), '\0');
+    in.clear();
+    in.seekg(blockOffset(header, RBN));
+    if (!in.read(&stored[0], stored.size()) || !expandBlock(header, stored.data(), &image[0])) return false;
+    return unpackBlock(image.data(), image.size(), RBN, block);
+}
+
+/**
+ * @brief Writes one block in place in a block file.
+ * @param out Block file opened in binary mode.
+ * @param header Header record of the block file.
+ * @param block Block to write; its RBN selects the slot.
+ * @return True if the block fit and was written.
+ */
+bool writeBlock(std::ostream& out, const HeaderRecord& header, const Block& block) {
+    string image, stored;
+    if (block.RBN < 1 || !packBlock(block, header, image) || !compressBlock(header, image, stored)) {
+        cerr << "Error: Block " << block.RBN << " does not fit in " << storedBlockSize(header) << " bytes" << endl;
+        return false;
+    }
+    out.seekp(blockOffset(header, block.RBN));
+    out.write(stored.data(), stored.size());
+    return out.good();
+}
+
+/**
+ * @brief Writes every changed secondary index back to its file.
+ *
+ * Mutations only change the loaded indexes; checkpointIndexes() runs this at every
+ * checkpoint, before the stale flag that would rebuild them after a crash is cleared.
+ *
+ * @return False if a file could not be written.
+ */
+static bool saveSecondaryIndexes() {
+    bool saved = true;
+    for (SecondaryIndex& index : secondaryIndexes) {
+        if (index.isDirty() && !index.save()) saved = false;
+    }
+    return saved;
+}
+
+/**
+ * @brief Brings the index files up to date before a checkpoint clears the stale flag
+ *        (see BufferPool::setCheckpointHook()).
+ *
+ * Changed secondary indexes are saved. A place name trie missing mutations is deleted
+ * rather than rebuilt, which would take a scan of the file; openPlaceTrie() rebuilds
+ * it when a completion next needs it, in this run or a later one.
+ *
+ * @return False if an index file could not be written or deleted.
+ */
+static bool checkpointIndexes() {
+    if (indexesDiverged) {
+        cerr << "Error: The indexes of " << blockPool.getFileName() << " may not match its blocks;"
+             << " it stays stale so the next open rebuilds them" << endl;
+        return false;
+    }
+    bool saved = saveSecondaryIndexes();
+    if (placeTrieStale) {
+        string fileName = trieFileName(blockPool.getHeader().getIndexFileName());
+        placeTrie.close();
+        if (remove(fileName.c_str()) != 0 && errno != ENOENT) {
+            cerr << "Error: Could not delete stale trie file: " << fileName << endl;
+            saved = false;
         }
+    }
+    return saved;
+}
+
+/**
+ * @brief Opens a block file for on-demand block reads through the global buffer pool.
+ * 
+ * This function only reads the header record and sets the list heads from it;
+ * blocks are read into the pool when a dump, query or lookup first needs them.
+ * 
+ * In mapped mode the whole file is mapped read-only instead, so startup does not
+ * depend on the file size and processes on one host share the page cache copy.
+ * 
+ * @param blockFile Path to the block file to open.
+ * @param frameCount Number of block frames the buffer pool may hold.
+ * @param mapped True to map the block file (and later the index) read-only.
+ * @param falsePositiveRate False positive rate of the Bloom filter the indexes are
+ *                          rebuilt with after a failed mutation.
+ * @return True if the block file was opened.
+ */
+bool openBlockFile(const string& blockFile, size_t frameCount, bool mapped, double falsePositiveRate) {
+    blockPool.setFrameCount(frameCount);
+    if (!blockPool.open(blockFile, mapped)) {
+        return false;
+    }
+
+    listHeadRBN = blockPool.getHeader().getActiveListRBN();
+    availHeadRBN = blockPool.getHeader().getAvailListRBN();
+    blockPool.setCheckpointHook(checkpointIndexes);
+    indexBloomRate = falsePositiveRate;
+    indexesDiverged = false;
+    return true;
+}
+
+/**
+ * @brief Checkpoints and closes the open block file (see BufferPool::checkpoint()) and
+ *        the indexes opened on it.
+ *
+ * Mutations still pending in the redo log are written in place, the stale flag of the
+ * header record is cleared and the log is deleted.
+ */
+void closeBlockFile() {
+    blockPool.close();
+    blockPool.setCheckpointHook(nullptr);
+    if (primaryIndex) primaryIndex->close();
+    primaryFilter.close();
+    secondaryIndexes.clear();
+    placeTrie.close();
+    spatialIndex.clear();
+}
+
+/// Blocks each worker formats per round of a parallel physical dump.
+static const int DUMP_ROUND_BLOCKS = 256;
 
-        // Create a block using the parsed data
-        createBlock(RBN, false, records, -1, -1);
+/**
+ * @brief Prints the RBN and the record fields of one block.
+ * @param out Stream to print to.
+ * @param RBN Relative Block Number of the block.
+ * @param view View of the block image.
+ */
+static void printBlock(ostream& out, int RBN, const BlockView& view) {
+    out << "RBN: " << RBN << " ";
+    if (view.isAvailable()) {
+        out << "(available)";
+    }
+    for (size_t r = 0; r < view.getRecordCount(); r++) {
+        for (size_t f = 0; f < view.getFieldCount(); f++) {
+            out << view.field(r, f) << " ";
+        }
     }
+    out << "\n";
+}
 
-    inFile.close();
+/**
+ * @brief Pins a block in the buffer pool and points a view at it.
+ * @param RBN Relative Block Number of the block.
+ * @param view View to reset on the pinned frame.
+ * @return True if the block is pinned; the caller must unpin it.
+ */
+static bool pinBlockView(int RBN, BlockView& view) {
+    const char* data = blockPool.pin(RBN);
+    if (data == nullptr) return false;
+    if (!view.reset(data, blockPool.getHeader().getBlockSize(), recordFieldCount(blockPool.getHeader()))) {
+        cerr << "Error: Block " << RBN << " is malformed" << endl;
+        blockPool.unpin(RBN);
+        return false;
+    }
+    return true;
 }
 
 /**
  * @brief Dumps all blocks in physical order.
  * 
- * This function iterates through all blocks stored in the global `blocks` map 
- * and prints their details in ascending order of their RBNs.
- */
-void dumpPhysicalOrder() {
-    cout << "Dumping Blocks by Physical Order:\n";                                        
-    for (const auto& [RBN, block] : blocks) {
-        cout << "RBN: " << RBN << " ";
-        for (const string& record : block.records) {
-            cout << record << " ";
+ * With one worker this function reads every block of the open block file through
+ * the buffer pool and prints their details in ascending order of their RBNs,
+ * straight from the pinned frames.
+ * 
+ * With more workers the file is formatted in rounds of DUMP_ROUND_BLOCKS blocks per
+ * worker: each worker formats its slice of the round into its own buffer with
+ * parallelScan(), then the buffers are printed in RBN order.
+ * 
+ * @param workers Number of worker threads; 0 selects defaultScanWorkers().
+ */
+void dumpPhysicalOrder(unsigned workers) {
+    cout << "Dumping Blocks by Physical Order:\n";
+    if (workers == 0) workers = defaultScanWorkers();
+    int blockCount = blockPool.getBlockCount();
+
+    if (workers == 1) {
+        BlockView view;
+        for (int RBN = 1; RBN <= blockCount; RBN++) {
+            if (pinBlockView(RBN, view)) {
+                printBlock(cout, RBN, view);
+                blockPool.unpin(RBN);
+            }
         }
-        cout << "\n";
+        return;
+    }
+
+    // Workers read the file through their own handles, so logged blocks must be in place
+    if (!blockPool.flush()) return;
+    vector<string> output(workers);
+    int roundBlocks = DUMP_ROUND_BLOCKS * static_cast<int>(workers);
+    for (int first = 1; first <= blockCount; first += roundBlocks) {
+        int last = min(blockCount, first + roundBlocks - 1);
+        for (string& text : output) text.clear();
+        bool read = parallelScan(blockPool.getFileName(), blockPool.getHeader(), first, last, workers,
+            [&output](unsigned worker, int RBN, const BlockView& view) {
+                ostringstream out;
+                printBlock(out, RBN, view);
+                output[worker] += out.str();
+            });
+        for (const string& text : output) cout << text;
+        if (!read) return;
     }
 }
 
@@ -171,121 +860,100 @@ void dumpPhysicalOrder() {
 void dumpLogicalOrder() {
     cout << "Dumping Blocks by Logical Order:\n";
     int currentRBN = listHeadRBN;  ///< Start from the logical list head
-    while (currentRBN != -1) {
-        const Block& block = blocks[currentRBN];
-        cout << "RBN: " << currentRBN << " ";
-        for (const string& record : block.records) {
-            cout << record << " " ;
+    int visited = 0;
+    BlockView view;
+    while (currentRBN != -1 && visited++ < blockPool.getBlockCount()) {
+        if (!pinBlockView(currentRBN, view)) {
+            break;
         }
-        cout << "\n";
-        currentRBN = block.successorRBN;  ///< Move to the next block in the chain
+        printBlock(cout, currentRBN, view);
+        blockPool.unpin(currentRBN);
+        currentRBN = view.getSuccessorRBN();  ///< Move to the next block in the chain
     }
 }
-/**
- * @brief Represents geographical location information for a zip code
- *
- * This struct stores detailed geographical data including state, 
- * zip code, latitude, and longitude coordinates
- */
-struct mostStorage {
-    std::string state, zip_code, county, other;
-    double latitude;
-    double longitude;
-};
 /**
  * @brief Finds and lists the extreme points (easternmost, westernmost, 
  *        northernmost, southernmost) for each state
  *
- * This function processes a collection of blocks containing location records,
- * identifying the extreme geographical points for each state based on 
- * longitude and latitude coordinates.
+ * Streams the active blocks through an ExtremesAggregator.
  * 
- * @details The function performs the following steps:
- * - Iterates through all blocks and their records
- * - Extracts state, ZIP code, latitude, and longitude information
- * - Tracks the extreme points for each state
- * - Stores the results in a map of state to extreme locations
- * - Prints out the extreme point ZIP codes for each state
- *
- * @note Assumes records are in a specific order:
- *       - Record 1: ZIP code
- *       - Record 3: State
- *       - Record 5: Latitude
- *       - Record 6: Longitude
- * 
- * @pre Requires a global `blocks` container with records
+ * @details With one worker the function:
+ * - Follows the successor chain from listHeadRBN, pinning one block at a time
+ * - Feeds each block's records to the aggregator, which keeps one accumulator
+ *   per state code, so memory use does not grow with the file
+ *
+ * With more workers the RBN range is split with parallelScan(); every worker feeds
+ * the active blocks of its slice to its own aggregator and the partial results are
+ * merged at the end. Either way the extreme point ZIP codes of each state are printed.
+ *
+ * @param workers Number of worker threads; 0 selects defaultScanWorkers().
+ *
+ * @pre Requires a block file opened through openBlockFile()
  * @post Prints extreme point information for each state
  */
-void listMost() {
-	int currentRBN = listHeadRBN;
-	int recordPart = 0;
-	int testnum = 0;
-	mostStorage current, easternmost, westernmost, northernmost, southernmost;
-	std::map<string, std::vector<mostStorage>> sorted_directions;
-
-
-	for (const auto& [RBN, block] : blocks) {
-		  bool initialized = false;
-	
-			for (const string& record : block.records) {
-					recordPart++;
-					if(recordPart == 1){
-					current.zip_code = record;
-					}
-
-					if(recordPart == 3){
-					current.state = record;
-					}
-			 
-				if(recordPart == 5){
-					current.latitude = std::stod(record);
-				}
-				if(recordPart == 6){
-					current.longitude = std::stod(record);
-					if (!initialized) {
-                    easternmost = current;
-                    westernmost = current;
-                    northernmost = current;
-                    southernmost = current;
-                    initialized = true;
-                }
-				if ( current.longitude < easternmost.longitude ) {
-					easternmost = current;
-				}
-				if ( current.longitude > westernmost.longitude ) {
-					westernmost = current;
-				}
-				if ( current.latitude > northernmost.latitude ) {
-					northernmost = current;
-				}
-				if ( current.latitude < southernmost.latitude ) {
-					southernmost = current;
-				}
-				recordPart=0;
-				sorted_directions[ current.state ] = { easternmost, westernmost, northernmost, southernmost };
-				}
-			
-			
-			
-			
-			 }
-							}
-				 
-            
-						
-		 
-		 
-	cout <<"State: "<< "Easternmost: " << "westernmost: "<< "northernnmost: "<< "southernnmost: " <<endl;
-	for (const auto& [state, locations] : sorted_directions) {
-        if (locations.size() == 4) {  // Ensure we have all 4 directional records
-				cout << state << ","
-				<< locations[0].zip_code << ","  // Easternmost
-                 << locations[1].zip_code << ","  // Westernmost
-                 << locations[2].zip_code << ","  // Northernmost 
-                 << locations[3].zip_code << "\n";  // Southernmost
+void listMost(unsigned workers) {
+	if (workers == 0) workers = defaultScanWorkers();
+	ExtremesAggregator extremes(blockPool.getHeader());
+
+	if (workers == 1) {
+		BlockView view;
+		int currentRBN = listHeadRBN;
+		int visited = 0;
+		while (currentRBN != -1 && visited++ < blockPool.getBlockCount()) {
+			if (!pinBlockView(currentRBN, view)) return;
+			extremes.addBlock(view);
+			blockPool.unpin(currentRBN);
+			currentRBN = view.getSuccessorRBN();
 		}
+		extremes.print(cout);
+		return;
+	}
+
+	// Workers read the file through their own handles, so logged blocks must be in place
+	if (!blockPool.flush()) return;
+	vector<ExtremesAggregator> partial(workers, extremes);
+	bool read = parallelScan(blockPool.getFileName(), blockPool.getHeader(), 1, blockPool.getBlockCount(), workers,
+		[&partial](unsigned worker, int, const BlockView& view) {
+			if (!view.isAvailable()) partial[worker].addBlock(view);
+		});
+	if (!read) return;
+	for (const ExtremesAggregator& part : partial) {
+		extremes.merge(part);
+	}
+	extremes.print(cout);
+}
+
+/**
+ * @brief Finds and lists the extreme points of one state, reading only the blocks
+ *        whose zone map says they hold records of that state.
+ *
+ * @param state Two-letter state abbreviation, e.g. "NY".
+ *
+ * @pre Requires a block file opened through openBlockFile()
+ * @post Prints the extreme points of the state and how many blocks were read
+ */
+void listMostOfState(const std::string& state) {
+	int code = stateCode(state);
+	if (code < 0) {
+		cerr << "Error: Unknown state: " << state << endl;
+		return;
 	}
+
+	ExtremesAggregator extremes(blockPool.getHeader());
+	BlockView view;
+	int read = 0;
+	for (int RBN = 1; RBN <= blockPool.getBlockCount(); RBN++) {
+		const ZoneMap* zone = blockPool.getZoneMap(RBN);
+		if (zone != nullptr && !zone->hasState(code)) continue;
+		if (!pinBlockView(RBN, view)) return;
+		if (!view.isAvailable()) extremes.addBlock(view);
+		blockPool.unpin(RBN);
+		read++;
+	}
+	extremes.print(cout, code);
+	cout << "Read " << read << " of " << blockPool.getBlockCount() << " blocks.\n";
 }
+
 /**
  * @brief Splits a string containing zip codes separated by "-z" delimiter
  * @param str Input string containing zip codes
@@ -325,164 +993,1118 @@ std::vector<std::string> splitZipLine(const std::string& str) {
 /**
  * @brief Retrieves a block by its Relative Block Number (RBN)
  * 
- * This function searches the global blocks map for a block with the specified RBN.
- * It returns a pointer to the block if found, or nullptr if the block does not exist.
+ * This function reads the block with the specified RBN through the global buffer pool,
+ * so repeated requests for the same block are served from memory.
  * 
  * @param requestedRBN The Relative Block Number of the block to retrieve
- * @return Block* Pointer to the block if found, nullptr otherwise
- * 
- * @note Uses the global `blocks` map to perform the lookup
- * @warning Returns nullptr if the block is not found
+ * @param block Receives a copy of the block
+ * @return bool True if the block was found, false otherwise
  * 
- * @see blocks
+ * @see blockPool
  * @see Block
  */
-Block* getBlockByRBN(int requestedRBN) {
-    // Check if the block exists in the global blocks map
-    auto it = blocks.find(requestedRBN);
-    
-    if (it != blocks.end()) {
-        // Block found, return a pointer to the block
-        return &(it->second);
-    } else {
-        // Block not found
-        std::cerr << "Block with RBN " << requestedRBN << " not found." << std::endl;
-        return nullptr;
+bool getBlockByRBN(int requestedRBN, Block& block) {
+    if (blockPool.getBlock(requestedRBN, block)) {
+        return true;
     }
+    // Block not found
+    std::cerr << "Block with RBN " << requestedRBN << " not found." << std::endl;
+    return false;
 }
 
 /**
- * @brief Searches for a specific zip code in the block file and index file
- * 
- * This function performs the following steps:
- * 1. Opens the index file and block file
- * 2. Searches for the given zip code in the index file
- * 3. If found, retrieves the corresponding block
- * 4. Parses the block records to extract and display matching record details
- * 
- * @param str The zip code to search for
- * @param indexName The name of the index file containing zip code to RBN mappings
+ * @brief Opens the global primary index on an index file unless it is already open on it.
+ *
+ * The index format follows the index schema of the header record (see makeKeyIndex())
+ * and the index is mapped read-only when the block file is.
+ *
+ * @param indexName Name of the index file.
+ * @return True if the primary index is open on indexName.
+ */
+static bool openPrimaryIndex(const std::string& indexName) {
+    if (primaryIndex && primaryIndex->isOpen() && primaryIndex->getFileName() == indexName) {
+        return true;
+    }
+    primaryIndex = makeKeyIndex(blockPool.getHeader().getIndexSchema());
+    return primaryIndex->open(indexName, blockPool.isMapped());
+}
+
+/**
+ * @brief Loads the Bloom filter saved next to an index file, once per index file.
+ *
+ * A missing filter is not an error; lookups then go straight to the index.
+ *
+ * @param indexName Name of the index file.
+ * @return The filter, or nullptr if the index has no usable filter.
+ */
+static const BloomFilter* openPrimaryFilter(const std::string& indexName) {
+    string filterName = bloomFileName(indexName);
+    if (primaryFilter.getFileName() != filterName) {
+        primaryFilter.load(filterName, blockPool.isMapped());
+    }
+    return primaryFilter.isLoaded() ? &primaryFilter : nullptr;
+}
+
+/**
+ * @brief Prints one zip code record on one line, latitude and longitude as numbers.
+ * @param view View of the block holding the record.
+ * @param record Record number within the block.
+ */
+static void printRecord(const BlockView& view, size_t record) {
+	cout << view.field(record, 0) << " " << view.field(record, 1) << " " << view.field(record, 2)
+		<< " " << view.field(record, 3) << " " << parseDouble(view.field(record, 4))
+		<< " " << parseDouble(view.field(record, 5)) << " " << endl;
+}
+
+/**
+ * @brief Searches for a specific zip code in the block file and index file
+ * 
+ * This function performs the following steps:
+ * 1. Rejects the zip code without reading the index or blocks if the Bloom filter
+ *    saved next to the index says it is absent
+ * 2. Opens the B+tree index file if it is not open yet
+ * 3. Descends the index to find the RBN of the block holding the zip code
+ * 4. If found, reads only the corresponding block through the buffer pool
+ * 5. Binary searches the block records through a BlockView and displays the matching record
+ * 
+ * @param str The zip code to search for
+ * @param indexName The name of the index file containing zip code to RBN mappings
  * 
- * @pre Requires a valid index file and block file to be present
+ * @pre Requires a valid index file and a block file opened through openBlockFile()
  * @post Prints the details of the matching record or a "not found" message
  * 
- * @note Uses mostStorage struct to store and display record information
- * @note Assumes a specific record structure within each block
+ * @note Fields are printed straight from the pinned buffer pool frame, without copies
  * 
- * @see mostStorage
- * @see Block
+ * @see BlockView
+ * @see KeyIndex
  */
-
 void search(const std::string& str, const std::string& indexName){
-	mostStorage current;
 	bool notfound = true;
-	std::string correct_line;
-	 std::ifstream file2(indexName); // Open the file add name later
-    if (!file2.is_open()) {
-        std::cerr << "Error opening file: index.txt " << std::endl;
-        return;
-    }
-	 std::ifstream file3("block.txt"); // Open the file add name later
-    if (!file3.is_open()) {
-        std::cerr << "Error opening file: block.txt " << std::endl;
-        return;
-    }
-	std::string strcopy = str;
-
-	std::string rbn, zipcode, line;
-	int recordPart = 0;
-	//int i = 5;
-	getline( file2, line );
-	line = "";
-    while ((file2 >> zipcode >> rbn) && !file2.eof()) {  // reads word by word
-        if(zipcode == str){
-			int block = std::stoi(rbn);
-            cout << "Zipcode:  " << zipcode << " is at "<< block <<endl;
-			Block* myBlock = getBlockByRBN(block);
-			for (const string& record : myBlock->records) {
-					recordPart++;
-					if(recordPart == 1){
-					current.zip_code = record;
-					
-					}
-					if(recordPart == 2){
-					current.other = record;
-					
-					}
-					if(recordPart == 3){
-					current.state = record;
-					}
-					if(recordPart == 4){
-					current.county = record;
-					
-					}
-				if(recordPart == 5){
-					current.latitude = std::stod(record);
-				}
-				if(recordPart == 6){
-					current.longitude = std::stod(record);
-					
-					if(current.zip_code == zipcode){
-						cout << current.zip_code << " " <<current.other << " "<<current.state << " "<<current.county 
-					<< " "<<current.latitude << " " <<current.longitude << " "<< endl;
-					notfound = false;
-					break;
-					}
-				//	current.longitude = std::stod(record);
-				/*	if (!initialized) {
-                    easternmost = current;
-                    westernmost = current;
-                    northernmost = current;
-                    southernmost = current;
-                    initialized = true;*/
-                
-
-				recordPart=0;
-			}
-				}
-			}
-			
-			
-		//	break;
-			}
-			
-			
-			
+	const BloomFilter* filter = openPrimaryFilter(indexName);
+	if (filter != nullptr && !filter->mayContain(str)) {
+		cout<< str << " was not found in the file."<<endl;
+		return;
+	}
+	if (!openPrimaryIndex(indexName)) {
+		return;
+	}
+	size_t keyField = blockPool.getHeader().getPrimaryKeyField();
+
+	int block = primaryIndex->find(str);
+	BlockView view;
+	if (block != -1 && pinBlockView(block, view)) {
+		cout << "Zipcode:  " << str << " is at "<< block <<endl;
+		long record = view.find(str, keyField);
+		if (record != -1) {
+			printRecord(view, record);
+			notfound = false;
+		}
+		blockPool.unpin(block);
+	}
+
 	if(notfound){
 			cout<< str << " was not found in the file."<<endl;
 			}
-			file2.close();
 }
 
+/**
+ * @brief Looks up many zip codes with one ordered pass over the index and the blocks.
+ *
+ * This function performs the following steps:
+ * 1. Sorts the keys in sequence set order and drops duplicates
+ * 2. Drops the keys the Bloom filter rules out, then resolves the rest to RBNs with
+ *    a single ordered pass over the B+tree
+ * 3. Pins each block that holds a requested key once, and answers every key it
+ *    holds from that one pinned frame (the keys of one block are adjacent in sorted order)
+ *
+ * @param keys Zip codes to look up, in any order.
+ * @param indexName Name of the index file, as recorded in the header record.
+ * @param visit Called once per distinct key in ascending order with a view of the block
+ *              holding the record and the record number, or with nullptr if the key is
+ *              not in the file.
+ *
+ * @pre Requires a valid index file and a block file opened through openBlockFile()
+ */
+void batchSearch(std::vector<std::string> keys, const std::string& indexName,
+                 const std::function<void(const std::string&, const BlockView*, size_t)>& visit) {
+    sort(keys.begin(), keys.end(), [](const string& a, const string& b) { return compareKeys(a, b) < 0; });
+    keys.erase(unique(keys.begin(), keys.end()), keys.end());
+
+    // Only keys that pass the Bloom filter are looked up in the index
+    const BloomFilter* filter = openPrimaryFilter(indexName);
+    vector<string> candidates;
+    vector<size_t> positions;
+    for (size_t i = 0; i < keys.size(); i++) {
+        if (filter == nullptr || filter->mayContain(keys[i])) {
+            candidates.push_back(keys[i]);
+            positions.push_back(i);
+        }
+    }
+
+    vector<int> rbns(keys.size(), -1);
+    if (!candidates.empty()) {
+        if (!openPrimaryIndex(indexName)) {
+            return;
+        }
+        size_t next = 0;
+        primaryIndex->findMany(candidates, [&](const string&, int RBN) { rbns[positions[next++]] = RBN; });
+    }
+
+    size_t keyField = blockPool.getHeader().getPrimaryKeyField();
+    BlockView view;
+    int pinnedRBN = -1;
+    size_t resume = 0;  ///< First record of the pinned block not yet passed
+    for (size_t i = 0; i < keys.size(); i++) {
+        if (rbns[i] != pinnedRBN) {
+            if (pinnedRBN != -1) blockPool.unpin(pinnedRBN);
+            pinnedRBN = -1;
+            if (rbns[i] == -1 || !pinBlockView(rbns[i], view)) {
+                visit(keys[i], nullptr, 0);
+                continue;
+            }
+            pinnedRBN = rbns[i];
+            resume = 0;
+        }
+
+        // Records are in key order, so the search for the next key resumes where this one stopped
+        while (resume < view.getRecordCount() && compareKeys(view.field(resume, keyField), keys[i]) < 0) {
+            resume++;
+        }
+        if (resume < view.getRecordCount() && view.field(resume, keyField) == keys[i]) {
+            visit(keys[i], &view, resume);
+        } else {
+            visit(keys[i], nullptr, 0);
+        }
+    }
+    if (pinnedRBN != -1) blockPool.unpin(pinnedRBN);
+}
+
+/**
+ * @brief Searches for several zip codes with batchSearch() and prints each record like search().
+ * @param keys Zip codes to look up, in any order.
+ * @param indexName Name of the index file, as recorded in the header record.
+ */
+void searchMany(const std::vector<std::string>& keys, const std::string& indexName) {
+    batchSearch(keys, indexName, [](const string& key, const BlockView* view, size_t record) {
+        if (view == nullptr) {
+            cout << key << " was not found in the file." << endl;
+            return;
+        }
+        printRecord(*view, record);
+    });
+}
 
 /**
- * @brief Creates a new block and inserts it into the global map.
- * 
- * This function initializes a new block with the provided details and inserts 
- * it into the `blocks` map. It also updates the global head pointers for the 
- * active and available block lists as needed.
+ * @brief Visits every record whose key lies in [lowKey, highKey], in key order.
+ *
+ * This function performs the following steps:
+ * 1. Finds the first indexed key not less than lowKey and the block holding it
+ * 2. Binary searches that block for the first record in range
+ * 3. Follows successorRBN links, pinning one block at a time, until a key
+ *    greater than highKey is reached, the chain ends or the visitor stops
+ *
+ * @param lowKey Smallest key to visit.
+ * @param highKey Largest key to visit.
+ * @param indexName Name of the index file, as recorded in the header record.
+ * @param visit Called with a view of the block and the record number; return false to stop.
+ * @return Number of times visit was called.
+ *
+ * @pre Requires a valid index file and a block file opened through openBlockFile()
+ */
+size_t rangeQuery(const std::string& lowKey, const std::string& highKey, const std::string& indexName,
+                  const std::function<bool(const BlockView&, size_t)>& visit) {
+    if (compareKeys(lowKey, highKey) > 0 || !openPrimaryIndex(indexName)) return 0;
+
+    int currentRBN = -1;
+    primaryIndex->scan(lowKey, [&currentRBN](const string&, int RBN) {
+        currentRBN = RBN;
+        return false;
+    });
+
+    size_t keyField = blockPool.getHeader().getPrimaryKeyField();
+    size_t visited = 0;
+    int blocks = 0;
+    bool first = true;
+    BlockView view;
+    while (currentRBN != -1 && blocks++ < blockPool.getBlockCount()) {
+        if (!pinBlockView(currentRBN, view)) break;
+        size_t record = first ? view.lowerBound(lowKey, keyField) : 0;
+        bool done = false;
+        first = false;
+        for (; record < view.getRecordCount() && !done; record++) {
+            done = compareKeys(view.field(record, keyField), highKey) > 0;
+            if (!done) {
+                visited++;
+                done = !visit(view, record);
+            }
+        }
+        blockPool.unpin(currentRBN);
+        currentRBN = done ? -1 : view.getSuccessorRBN();
+    }
+    return visited;
+}
+
+/**
+ * @brief Prints every record whose key lies in [lowKey, highKey] like search().
+ * @param lowKey Smallest key to print.
+ * @param highKey Largest key to print.
+ * @param indexName Name of the index file, as recorded in the header record.
+ */
+void printRange(const std::string& lowKey, const std::string& highKey, const std::string& indexName) {
+    size_t count = rangeQuery(lowKey, highKey, indexName, [](const BlockView& view, size_t record) {
+        printRecord(view, record);
+        return true;
+    });
+    cout << count << " records between " << lowKey << " and " << highKey << "." << endl;
+}
+
+/**
+ * @brief Loads the secondary index of a field unless it is already loaded.
+ * @param field Field number.
+ * @return The index, or nullptr if the field has none or its file cannot be read.
+ */
+static SecondaryIndex* openSecondaryIndex(size_t field) {
+    const HeaderRecord& header = blockPool.getHeader();
+    const auto& fields = header.getFields();
+    if (field >= fields.size() || !hasSecondaryIndex(fields[field])) return nullptr;
+    if (secondaryIndexes.size() < fields.size()) secondaryIndexes.resize(fields.size());
+
+    SecondaryIndex& index = secondaryIndexes[field];
+    string fileName = secondaryIndexFileName(header.getIndexFileName(), fields[field].name);
+    if (index.getFileName() != fileName) {
+        index.load(fileName);
+    }
+    return index.isLoaded() ? &index : nullptr;
+}
+
+/**
+ * @brief Loads the secondary index of every indexed field, so a mutation can update
+ *        them all once its blocks are written.
+ * @return False if an index file cannot be read.
+ */
+static bool openSecondaryIndexes() {
+    const HeaderRecord& header = blockPool.getHeader();
+    for (size_t field = 0; field < header.getFields().size(); field++) {
+        if (hasSecondaryIndex(header.getFields()[field]) && openSecondaryIndex(field) == nullptr) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Adds a record to, or removes it from, the secondary index of every indexed field.
+ *
+ * Only the loaded indexes change; saveSecondaryIndexes() writes them at the next checkpoint.
+ *
+ * @param record First field of the record.
+ * @param add True to add the record, false to remove it.
+ * @return False if an index could not be read.
+ */
+static bool updateSecondaryIndexes(vector<string>::const_iterator record, bool add) {
+    const HeaderRecord& header = blockPool.getHeader();
+    const string& key = record[header.getPrimaryKeyField()];
+    for (size_t field = 0; field < header.getFields().size(); field++) {
+        if (!hasSecondaryIndex(header.getFields()[field])) continue;
+        SecondaryIndex* index = openSecondaryIndex(field);
+        if (index == nullptr) return false;
+        if (add) index->add(record[field], key);
+        else index->remove(record[field], key);
+    }
+    return true;
+}
+
+/**
+ * @brief Prints every record whose field holds a value, using the field's secondary index.
+ *
+ * The secondary index gives the primary keys of the matching records; they are then
+ * resolved with batchSearch(), which reads every block holding matches only once.
+ *
+ * @param fieldName Name of an indexed field, e.g. "county".
+ * @param value Field value to match exactly, e.g. "Suffolk".
+ * @param indexName Name of the primary index file, as recorded in the header record.
+ *
+ * @pre Requires a block file opened through openBlockFile() and its indexes built
+ */
+void printByField(const std::string& fieldName, const std::string& value, const std::string& indexName) {
+    const auto& fields = blockPool.getHeader().getFields();
+    size_t field = 0;
+    while (field < fields.size() && fields[field].name != fieldName) field++;
+    if (field == fields.size() || !hasSecondaryIndex(fields[field])) {
+        cerr << "Error: Field " << fieldName << " has no secondary index" << endl;
+        return;
+    }
+    SecondaryIndex* index = openSecondaryIndex(field);
+    if (index == nullptr) return;
+
+    const vector<string>* keys = index->find(value);
+    size_t count = 0;
+    if (keys != nullptr) {
+        batchSearch(*keys, indexName, [&count](const string&, const BlockView* view, size_t record) {
+            if (view == nullptr) return;
+            printRecord(*view, record);
+            count++;
+        });
+    }
+    cout << count << " zip codes with " << fieldName << " " << value << "." << endl;
+}
+
+/**
+ * @brief Returns the milliseconds elapsed since a point in time.
+ */
+static double elapsedMs(chrono::steady_clock::time_point start) {
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * @brief Visits every record of the active blocks, following the successor chain.
+ * @param visit Called with the RBN, a view of the pinned block and the record number.
+ * @return False if a block could not be read.
+ */
+static bool scanActiveRecords(const function<void(int, const BlockView&, size_t)>& visit) {
+    BlockView view;
+    int currentRBN = listHeadRBN;
+    int visited = 0;
+    while (currentRBN != -1 && visited++ < blockPool.getBlockCount()) {
+        if (!pinBlockView(currentRBN, view)) return false;
+        for (size_t record = 0; record < view.getRecordCount(); record++) {
+            visit(currentRBN, view, record);
+        }
+        blockPool.unpin(currentRBN);
+        currentRBN = view.getSuccessorRBN();
+    }
+    return true;
+}
+
+/**
+ * @brief Builds spatialIndex from the active blocks unless it is already built.
+ * @return False if a block could not be read.
+ */
+static bool openSpatialIndex() {
+    if (spatialIndex.isBuilt()) return true;
+    const HeaderRecord& header = blockPool.getHeader();
+    size_t keyField = header.getPrimaryKeyField();
+    size_t latitudeField = fieldIndex(header, "latitude", 4);
+    size_t longitudeField = fieldIndex(header, "longitude", 5);
+
+    auto start = chrono::steady_clock::now();
+    vector<SpatialPoint> points;
+    bool read = scanActiveRecords([&](int RBN, const BlockView& view, size_t record) {
+        points.push_back({ string(view.field(record, keyField)), RBN,
+                           parseDouble(view.field(record, latitudeField)), parseDouble(view.field(record, longitudeField)) });
+    });
+    if (!read) return false;
+    spatialIndex.build(move(points));
+    cout << "Spatial index of " << spatialIndex.size() << " zip codes built in " << elapsedMs(start) << " ms." << endl;
+    return true;
+}
+
+/**
+ * @brief Answers a spatial query by computing the distance of every record in the active blocks.
+ *
+ * This is the brute-force baseline the k-d tree is timed against.
+ *
+ * @param latitude Latitude of the query location in degrees.
+ * @param longitude Longitude of the query location in degrees.
+ * @param k Number of closest records to keep, or 0 to keep every record within radiusKm.
+ * @param radiusKm Largest distance in kilometres when k is 0.
+ * @return Keys of the matching records, closest first (ties in key order).
+ */
+static vector<string> scanSpatial(double latitude, double longitude, size_t k, double radiusKm) {
+    const HeaderRecord& header = blockPool.getHeader();
+    size_t keyField = header.getPrimaryKeyField();
+    size_t latitudeField = fieldIndex(header, "latitude", 4);
+    size_t longitudeField = fieldIndex(header, "longitude", 5);
+    auto closer = [](const pair<double, string>& a, const pair<double, string>& b) {
+        return a.first != b.first ? a.first < b.first : compareKeys(a.second, b.second) < 0;
+    };
+
+    // With k > 0, matches is a max-heap of the k closest records seen so far
+    vector<pair<double, string>> matches;
+    scanActiveRecords([&](int, const BlockView& view, size_t record) {
+        double distance = greatCircleKm(latitude, longitude, parseDouble(view.field(record, latitudeField)),
+                                        parseDouble(view.field(record, longitudeField)));
+        if (k == 0) {
+            if (distance <= radiusKm) matches.emplace_back(distance, string(view.field(record, keyField)));
+            return;
+        }
+        pair<double, string> match(distance, string(view.field(record, keyField)));
+        if (matches.size() < k) {
+            matches.push_back(move(match));
+            push_heap(matches.begin(), matches.end(), closer);
+        } else if (closer(match, matches.front())) {
+            pop_heap(matches.begin(), matches.end(), closer);
+            matches.back() = move(match);
+            push_heap(matches.begin(), matches.end(), closer);
+        }
+    });
+    sort(matches.begin(), matches.end(), closer);
+
+    vector<string> keys;
+    for (const auto& match : matches) keys.push_back(match.second);
+    return keys;
+}
+
+/**
+ * @brief Prints the records of a spatial query with their distances, then the timings.
+ * @param matches Matches found through the k-d tree, closest first.
+ * @param indexMs Milliseconds the k-d tree query took.
+ * @param scanKeys Keys found by the brute-force scan, closest first.
+ * @param scanMs Milliseconds the brute-force scan took.
+ */
+static void printSpatialMatches(const vector<SpatialMatch>& matches, double indexMs,
+                                const vector<string>& scanKeys, double scanMs) {
+    size_t keyField = blockPool.getHeader().getPrimaryKeyField();
+    BlockView view;
+    bool same = matches.size() == scanKeys.size();
+    for (size_t i = 0; i < matches.size(); i++) {
+        const SpatialPoint& point = *matches[i].point;
+        same = same && point.key == scanKeys[i];
+        if (!pinBlockView(point.RBN, view)) continue;
+        long record = view.find(point.key, keyField);
+        if (record != -1) {
+            cout << matches[i].distanceKm << " km: ";
+            printRecord(view, record);
+        }
+        blockPool.unpin(point.RBN);
+    }
+    cout << matches.size() << " zip codes found in " << indexMs << " ms with the k-d tree; a scan of the active blocks took "
+         << scanMs << " ms" << (same ? " and found the same zip codes." : " and found different zip codes!") << endl;
+}
+
+/**
+ * @brief Prints the k zip codes closest to a location, closest first.
+ *
+ * The query goes through spatialIndex, which is built from the active blocks on first
+ * use. The same query is then answered by a brute-force scan of the active blocks and
+ * both latencies are reported.
+ *
+ * @param latitude Latitude of the location in degrees.
+ * @param longitude Longitude of the location in degrees.
+ * @param k Number of zip codes to print.
+ *
+ * @pre Requires a block file opened through openBlockFile()
+ */
+void printNearest(double latitude, double longitude, size_t k) {
+    if (!openSpatialIndex()) return;
+    auto start = chrono::steady_clock::now();
+    vector<SpatialMatch> matches = spatialIndex.nearest(latitude, longitude, k);
+    double indexMs = elapsedMs(start);
+
+    start = chrono::steady_clock::now();
+    vector<string> scanKeys = scanSpatial(latitude, longitude, k, 0);
+    printSpatialMatches(matches, indexMs, scanKeys, elapsedMs(start));
+}
+
+/**
+ * @brief Prints every zip code within a distance of a location, closest first.
+ *
+ * Like printNearest(), the query is answered through spatialIndex and timed against
+ * a brute-force scan of the active blocks.
+ *
+ * @param latitude Latitude of the location in degrees.
+ * @param longitude Longitude of the location in degrees.
+ * @param radiusKm Largest distance in kilometres.
+ *
+ * @pre Requires a block file opened through openBlockFile()
+ */
+void printWithinRadius(double latitude, double longitude, double radiusKm) {
+    if (!openSpatialIndex()) return;
+    auto start = chrono::steady_clock::now();
+    vector<SpatialMatch> matches = spatialIndex.within(latitude, longitude, radiusKm);
+    double indexMs = elapsedMs(start);
+
+    start = chrono::steady_clock::now();
+    vector<string> scanKeys = scanSpatial(latitude, longitude, 0, radiusKm);
+    printSpatialMatches(matches, indexMs, scanKeys, elapsedMs(start));
+}
+
+/**
+ * @brief Maps the place name trie saved next to an index file, rebuilding it first
+ *        from the active blocks if records changed since it was built.
+ *
+ * A missing trie file was deleted by the checkpoint of a run that changed records
+ * (see checkpointIndexes()), so it is rebuilt too.
+ *
+ * @param indexName Name of the index file.
+ * @return True if the trie is mapped.
+ */
+static bool openPlaceTrie(const std::string& indexName) {
+    string fileName = trieFileName(indexName);
+    if (!placeTrieStale && !placeTrie.isOpen() && !ifstream(fileName)) {
+        placeTrieStale = true;
+    }
+    if (!placeTrieStale) {
+        return (placeTrie.isOpen() && placeTrie.getFileName() == fileName) || placeTrie.open(fileName);
+    }
+
+    const HeaderRecord& header = blockPool.getHeader();
+    size_t keyField = header.getPrimaryKeyField();
+    size_t placeField = fieldIndex(header, "place_name", 1);
+    auto start = chrono::steady_clock::now();
+    vector<pair<string, string>> places;
+    bool read = scanActiveRecords([&](int, const BlockView& view, size_t record) {
+        places.emplace_back(string(view.field(record, placeField)), string(view.field(record, keyField)));
+    });
+    if (!read || !placeTrie.build(fileName, places)) return false;
+    placeTrieStale = false;
+    cout << "Place name trie of " << placeTrie.getNameCount() << " names rebuilt in " << elapsedMs(start) << " ms." << endl;
+    return true;
+}
+
+/**
+ * @brief Prints the k place names starting with a prefix that have the most zip codes.
+ *
+ * The completions come from the memory-mapped place name trie; each is printed with
+ * its zip codes, followed by the latency of the lookup in microseconds.
+ *
+ * @param prefix Start of the place name, in any case (e.g. "holts").
+ * @param k Number of completions to print.
+ * @param indexName Name of the index file, as recorded in the header record.
+ *
+ * @pre Requires a block file opened through openBlockFile() and its indexes built
+ */
+void printCompletions(const std::string& prefix, size_t k, const std::string& indexName) {
+    if (!openPlaceTrie(indexName)) return;
+    auto start = chrono::steady_clock::now();
+    vector<PrefixMatch> matches = placeTrie.complete(prefix, k);
+    double micros = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+
+    for (const PrefixMatch& match : matches) {
+        cout << match.name << " (" << match.keys.size() << (match.keys.size() == 1 ? " zip code):" : " zip codes):");
+        for (const string& key : match.keys) cout << " " << key;
+        cout << endl;
+    }
+    cout << matches.size() << " completions of \"" << prefix << "\" found in " << micros << " microseconds." << endl;
+}
+
+/**
+ * @brief Takes a block for reuse from the avail list, or the next RBN past the end of the file.
+ *
+ * The caller must write the returned block through the buffer pool before allocating another one.
+ *
+ * @return RBN of the block to use, or -1 on an I/O error.
+ */
+static int allocateBlock() {
+    HeaderRecord& header = blockPool.getHeader();
+    int RBN = header.getAvailListRBN();
+    if (RBN == -1) {
+        return blockPool.getBlockCount() + 1;
+    }
+
+    Block freeBlock;
+    if (!blockPool.getBlock(RBN, freeBlock)) {
+        return -1;
+    }
+    header.setAvailListRBN(freeBlock.successorRBN);
+    availHeadRBN = freeBlock.successorRBN;
+    return RBN;
+}
+
+/**
+ * @brief Finds the active block whose key range should receive a key.
+ *
+ * This is the block of the first indexed key not less than the new key, or the block
+ * of the largest key when the new key sorts after every indexed key.
+ *
+ * @param key Key to place.
+ * @return RBN of the block, or -1 if the sequence set has no records.
+ */
+static int findTargetBlock(const std::string& key) {
+    int target = -1;
+    primaryIndex->scan(key, [&](const std::string&, int RBN) {
+        target = RBN;
+        return false;
+    });
+    if (target == -1) {
+        std::string lastKey;
+        primaryIndex->last(lastKey, target);
+    }
+    return target;
+}
+
+/**
+ * @brief Brings the record and block counts of the header up to date after a mutation.
+ *
+ * The header image is logged with the blocks of the mutation, so the counts commit
+ * together with the records they count.
+ *
+ * @param recordChange Records added (1) or removed (-1) by the mutation.
+ * @return True if the header was written.
+ */
+static bool updateHeaderCounts(int recordChange) {
+    HeaderRecord& header = blockPool.getHeader();
+    header.setRecordCount(header.getRecordCount() + recordChange);
+    header.setBlockCount(blockPool.getBlockCount());
+    return blockPool.writeHeader();
+}
+
+/**
+ * @brief Tells whether a block fits in its slot of the open file, compressed if the
+ *        file is compressed.
+ * @param block Block to measure.
+ * @param header Header record of the block file.
+ * @return True if putBlock() can write the block.
+ */
+static bool fitsInBlock(const Block& block, const HeaderRecord& header) {
+    string image, stored;
+    return packBlock(block, header, image) && compressBlock(header, image, stored);
+}
+
+/**
+ * @brief Chooses where to split an overflowing block.
+ *
+ * The middle record is tried first, then the records next to it moving outwards,
+ * since compressed halves of equal record count may not both fit.
+ *
+ * @param block Overflowing block.
+ * @param header Header record of the block file.
+ * @param fieldCount Number of fields per record.
+ * @return Number of fields kept in the block, or 0 if no split gives two blocks that fit.
+ */
+static size_t splitPoint(const Block& block, const HeaderRecord& header, size_t fieldCount) {
+    long records = static_cast<long>(block.records.size() / fieldCount);
+    Block left = block, right = block;
+    for (long step = 0; step < records; step++) {
+        long split = records / 2 + (step % 2 == 0 ? step / 2 : -(step + 1) / 2);
+        if (split < 1 || split >= records) continue;
+        left.records.assign(block.records.begin(), block.records.begin() + split * fieldCount);
+        right.records.assign(block.records.begin() + split * fieldCount, block.records.end());
+        if (fitsInBlock(left, header) && fitsInBlock(right, header)) return split * fieldCount;
+    }
+    return 0;
+}
+
+/**
+ * @brief Writes a new record into the block whose key range covers it, splitting the
+ *        block if it overflows, and points the primary index at the record and at
+ *        every record that moved.
+ * @param fields Fields of the record.
+ * @return True if the blocks, the header and the primary index were written.
+ */
+static bool placeRecord(const vector<string>& fields) {
+    HeaderRecord& header = blockPool.getHeader();
+    size_t fieldCount = recordFieldCount(header);
+    size_t keyField = header.getPrimaryKeyField();
+    const string& key = fields[keyField];
+
+    Block block;
+    int targetRBN = findTargetBlock(key);
+    if (targetRBN == -1) {
+        // Empty sequence set, the record starts the active list
+        block.RBN = allocateBlock();
+        block.isAvailable = false;
+        block.predecessorRBN = -1;
+        block.successorRBN = -1;
+        block.records = fields;
+        if (block.RBN == -1 || !blockPool.putBlock(block)) return false;
+        header.setActiveListRBN(block.RBN);
+        listHeadRBN = block.RBN;
+        return blockPool.writeHeader() && primaryIndex->insert(key, block.RBN);
+    }
+    if (!getBlockByRBN(targetRBN, block)) {
+        return false;
+    }
+
+    // Insert the fields before the first record with a larger key
+    size_t pos = 0;
+    while (pos < block.records.size() && compareKeys(block.records[pos + keyField], key) < 0) {
+        pos += fieldCount;
+    }
+    block.records.insert(block.records.begin() + pos, fields.begin(), fields.end());
+
+    if (fitsInBlock(block, header)) {
+        return blockPool.putBlock(block) && primaryIndex->insert(key, block.RBN);
+    }
+
+    // The block overflowed: move the upper half of its records into a new block
+    size_t half = splitPoint(block, header, fieldCount);
+    if (half == 0) {
+        cerr << "Error: Block " << block.RBN << " cannot be split into two blocks that fit" << endl;
+        return false;
+    }
+    Block right;
+    right.RBN = allocateBlock();
+    if (right.RBN == -1) return false;
+    right.isAvailable = false;
+    right.records.assign(block.records.begin() + half, block.records.end());
+    right.predecessorRBN = block.RBN;
+    right.successorRBN = block.successorRBN;
+    block.records.resize(half);
+    block.successorRBN = right.RBN;
+
+    if (!blockPool.putBlock(right)) return false;
+    if (right.successorRBN != -1) {
+        Block next;
+        if (!getBlockByRBN(right.successorRBN, next)) return false;
+        next.predecessorRBN = right.RBN;
+        if (!blockPool.putBlock(next)) return false;
+    }
+    if (!blockPool.putBlock(block) || !blockPool.writeHeader()) return false;
+
+    // Re-point the index at the records that moved, including the new one if it moved
+    for (size_t i = keyField; i < right.records.size(); i += fieldCount) {
+        if (!primaryIndex->insert(right.records[i], right.RBN)) return false;
+    }
+    if (pos < half) {
+        return primaryIndex->insert(key, block.RBN);
+    }
+    return true;
+}
+
+
+/**
+ * @brief Inserts one record into the blocked sequence set in key order, without
+ *        committing its writes to the log.
+ *
+ * This function performs the following steps:
+ * 1. Rejects malformed records and keys that are already indexed
+ * 2. Finds the block whose key range covers the key through the index
+ * 3. Inserts the record fields in key order within that block (see placeRecord())
+ * 4. If the block overflows, moves its upper half into a block taken from the
+ *    avail list (or appended to the file) and links it in after the full block
+ * 5. Updates the index for the new record and for every record that moved
+ * 6. Adds the key to the Bloom filter and the record to the secondary indexes, once
+ *    the blocks are written
  * 
- * @param RBN Relative Block Number of the new block.
- * @param isAvailable Flag indicating whether the block is available (true) or active (false).
- * @param records List of records to store in the block.
- * @param predecessorRBN RBN of the predecessor block in the chain.
- * @param successorRBN RBN of the successor block in the chain.
+ * @param recordLine Comma separated fields of the record, primary key included.
+ * @return True if the record was inserted.
+ *
+ * @pre Requires a block file opened through openBlockFile() and its index built
+ */
+static bool applyInsert(const std::string& recordLine) {
+    if (blockPool.isMapped()) {
+        cerr << "Error: " << blockPool.getFileName() << " is open read-only" << endl;
+        return false;
+    }
+    HeaderRecord& header = blockPool.getHeader();
+    size_t fieldCount = recordFieldCount(header);
+    size_t keyField = header.getPrimaryKeyField();
+
+    vector<string> fields;
+    appendFields(recordLine, fields);
+    if (fields.size() != fieldCount || fields[keyField].empty()) {
+        cerr << "Error: Record must have " << fieldCount << " fields: " << recordLine << endl;
+        return false;
+    }
+    const string& key = fields[keyField];
+
+    if (!openPrimaryIndex(header.getIndexFileName())) {
+        return false;
+    }
+    const BloomFilter* filter = openPrimaryFilter(header.getIndexFileName());
+
+    // Keys equal under compareKeys() ("1006" and "01006") are the same key, which the
+    // Bloom filter and an exact find() would not see
+    bool duplicate = false;
+    primaryIndex->scan(key, [&](const string& indexed, int) {
+        duplicate = compareKeys(indexed, key) == 0;
+        return false;
+    });
+    if (duplicate) {
+        cerr << "Error: Zip code " << key << " is already in the file." << endl;
+        return false;
+    }
+    if (!openSecondaryIndexes()) return false;
+    spatialIndex.clear();
+    placeTrieStale = true;
+    if (!placeRecord(fields)) return false;
+
+    // Only a record the sequence set holds may reach the filter and the postings
+    if (filter != nullptr && !primaryFilter.add(key)) {
+        cerr << "Error: Could not add " << key << " to the Bloom filter" << endl;
+        return false;
+    }
+    return updateSecondaryIndexes(fields.begin(), true);
+}
+
+/**
+ * @brief Drops the writes of a mutation that failed partway (see BufferPool::rollback())
+ *        and resets the list heads from the restored header record.
+ *
+ * The index files are written directly rather than through the log, so entries of the
+ * dropped writes may have reached them. Once blocks were written, the restored blocks
+ * are therefore flushed and every index is rebuilt from them, as after a recovery.
+ * If that fails, indexesDiverged keeps the file stale until the next open rebuilds them.
  */
-void createBlock(int RBN, bool isAvailable, const vector<string>& records, int predecessorRBN, int successorRBN) {
+static void rollbackMutation() {
+    bool written = blockPool.rollback();
+    listHeadRBN = blockPool.getHeader().getActiveListRBN();
+    availHeadRBN = blockPool.getHeader().getAvailListRBN();
+    if (!written) return;
+
+    if (primaryIndex) primaryIndex->close();
+    primaryFilter.close();
+    secondaryIndexes.clear();
+    placeTrie.close();
+    spatialIndex.clear();
+    Index index;
+    if (!blockPool.flush()
+        || !index.processBlockData(blockPool.getFileName(), blockPool.getHeader().getIndexFileName(), indexBloomRate)) {
+        indexesDiverged = true;
+        return;
+    }
+    placeTrieStale = false;
+}
+
+/**
+ * @brief Inserts one record into the blocked sequence set in key order.
+ *
+ * The block and header writes of the insert are committed to the redo log as one
+ * mutation (see BufferPool::commit()), so a crash never leaves half a block split.
+ * An insert that fails partway is rolled back instead.
+ *
+ * @param recordLine Comma separated fields of the record, primary key included.
+ * @return True if the record was inserted.
+ *
+ * @pre Requires a block file opened through openBlockFile() and its index built
+ */
+bool insertRecord(const std::string& recordLine) {
+    if (!applyInsert(recordLine) || !updateHeaderCounts(1)) {
+        rollbackMutation();
+        return false;
+    }
+    return blockPool.commit();
+}
+
+/**
+ * @brief Counts the bytes the records of a block use in its on-disk image.
+ * @param block Block to measure.
+ * @param fieldCount Number of fields per record.
+ * @return Bytes of length prefixes and record text.
+ */
+static size_t recordBytes(const Block& block, size_t fieldCount) {
+    size_t bytes = 0;
+    for (size_t i = 0; i < block.records.size(); i++) {
+        bytes += block.records[i].size();
+        if (i % fieldCount == 0) bytes += 2;          // length prefix
+        else bytes += 1;                               // comma
+    }
+    return bytes;
+}
+
+/**
+ * @brief Puts a block at the head of the avail list and writes it.
+ * @param block Block to free; its records are dropped.
+ * @return True if the block was written.
+ */
+static bool freeBlock(Block& block) {
+    HeaderRecord& header = blockPool.getHeader();
+    block.isAvailable = true;
+    block.records.clear();
+    block.predecessorRBN = -1;
+    block.successorRBN = header.getAvailListRBN();
+    header.setAvailListRBN(block.RBN);
+    availHeadRBN = block.RBN;
+    return blockPool.putBlock(block);
+}
+
+/**
+ * @brief Writes back a block a record was removed from.
+ *
+ * If the block is still at least minBlockCapacity full it is written as is. Otherwise
+ * its successor (or predecessor for the last block) is picked as sibling and
+ * - the two blocks are merged when their records fit in one, freeing the right block
+ *   onto the avail list, or
+ * - the records of both blocks are redistributed, splitting at the record boundary
+ *   closest to the middle (variable-length records may leave one block a few bytes
+ *   under the minimum)
+ * and the index entries of every record that changed blocks are re-pointed.
+ *
+ * @param block Block without the removed record.
+ * @return True if the blocks, the header and the moved index entries were written.
+ */
+static bool rebalanceBlock(Block& block) {
+    HeaderRecord& header = blockPool.getHeader();
+    size_t fieldCount = recordFieldCount(header);
+    size_t keyField = header.getPrimaryKeyField();
+    size_t capacity = header.getBlockSize() - BLOCK_HEADER_SIZE;
+    size_t minBytes = static_cast<size_t>(capacity * header.getMinBlockCapacity());
+
+    if (recordBytes(block, fieldCount) >= minBytes) {
+        return blockPool.putBlock(block);
+    }
+
+    // Underfull: work with the block and its right neighbour (or left one for the last block)
+    Block left, right;
+    if (block.successorRBN != -1) {
+        left = block;
+        if (!getBlockByRBN(block.successorRBN, right)) return false;
+    } else if (block.predecessorRBN != -1) {
+        right = block;
+        if (!getBlockByRBN(block.predecessorRBN, left)) return false;
+    } else {
+        // Only block of the sequence set
+        if (!block.records.empty()) return blockPool.putBlock(block);
+        header.setActiveListRBN(-1);
+        listHeadRBN = -1;
+        return freeBlock(block) && blockPool.writeHeader();
+    }
+
+    Block merged = left;
+    merged.records.insert(merged.records.end(), right.records.begin(), right.records.end());
+    merged.successorRBN = right.successorRBN;
+    if (recordBytes(left, fieldCount) + recordBytes(right, fieldCount) <= capacity && fitsInBlock(merged, header)) {
+        // Merge the right block into the left one and free it
+        size_t moved = left.records.size();
+        left = move(merged);
+        if (right.successorRBN != -1) {
+            Block next;
+            if (!getBlockByRBN(right.successorRBN, next)) return false;
+            next.predecessorRBN = left.RBN;
+            if (!blockPool.putBlock(next)) return false;
+        }
+        if (!blockPool.putBlock(left) || !freeBlock(right) || !blockPool.writeHeader()) return false;
+
+        for (size_t i = moved + keyField; i < left.records.size(); i += fieldCount) {
+            if (!primaryIndex->insert(left.records[i], left.RBN)) return false;
+        }
+        return true;
+    }
+
+    // Redistribute: split the combined records where the two halves are closest in size
+    vector<string> combined(left.records);
+    combined.insert(combined.end(), right.records.begin(), right.records.end());
+    size_t leftCount = left.records.size();
+    size_t total = recordBytes(left, fieldCount) + recordBytes(right, fieldCount);
+
+    size_t split = fieldCount, leftBytes = 0;
+    for (size_t first = 0; first + fieldCount < combined.size(); first += fieldCount) {
+        size_t bytes = 2 + fieldCount - 1;
+        for (size_t i = first; i < first + fieldCount; i++) bytes += combined[i].size();
+        leftBytes += bytes;
+        // Stop at the record boundary closest to the middle
+        if (leftBytes * 2 >= total) {
+            split = (leftBytes * 2 - total <= bytes) ? first + fieldCount : first;
+            break;
+        }
+    }
+    if (split == 0) split = fieldCount;
+    left.records.assign(combined.begin(), combined.begin() + split);
+    right.records.assign(combined.begin() + split, combined.end());
+    if (!fitsInBlock(left, header) || !fitsInBlock(right, header)) {
+        // Compressed halves can outgrow a compressed block; keep the block underfull instead
+        return blockPool.putBlock(block);
+    }
+    if (!blockPool.putBlock(left) || !blockPool.putBlock(right)) return false;
+
+    // Records crossed the boundary in one direction only
+    for (size_t i = min(split, leftCount) + keyField; i < max(split, leftCount); i += fieldCount) {
+        if (!primaryIndex->insert(combined[i], split > leftCount ? left.RBN : right.RBN)) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Removes a record from a block, writes the block back (see rebalanceBlock())
+ *        and then drops the index entry of the record.
+ * @param block Block holding the record.
+ * @param pos Index of the first field of the record in block.records.
+ * @return True if the blocks, the header and the primary index were written.
+ */
+static bool removeRecord(Block& block, size_t pos) {
+    const HeaderRecord& header = blockPool.getHeader();
+    size_t fieldCount = recordFieldCount(header);
+    string key = block.records[pos + header.getPrimaryKeyField()];
+
+    block.records.erase(block.records.begin() + pos, block.records.begin() + pos + fieldCount);
+    return rebalanceBlock(block) && primaryIndex->erase(key);
+}
+
+/**
+ * @brief Deletes the record with a primary key from the blocked sequence set, without
+ *        committing its writes to the log.
+ *
+ * This function performs the following steps:
+ * 1. Finds the block of the key through the index
+ * 2. Removes the record, writes the block back, merging or redistributing it if it
+ *    fell under minBlockCapacity, and drops the index entry (see removeRecord())
+ * 3. Removes the record from the secondary indexes, once the blocks are written
+ *
+ * @param key Primary key of the record to delete.
+ * @return True if the record was found and deleted.
+ *
+ * @pre Requires a block file opened through openBlockFile() and its index built
+ */
+static bool applyDelete(const std::string& key) {
+    if (blockPool.isMapped()) {
+        cerr << "Error: " << blockPool.getFileName() << " is open read-only" << endl;
+        return false;
+    }
+    HeaderRecord& header = blockPool.getHeader();
+    size_t fieldCount = recordFieldCount(header);
+    size_t keyField = header.getPrimaryKeyField();
+
+    if (!openPrimaryIndex(header.getIndexFileName())) {
+        return false;
+    }
     Block block;
-    block.RBN = RBN;
-    block.isAvailable = isAvailable;
-    block.records = records;
-    block.predecessorRBN = predecessorRBN;
-    block.successorRBN = successorRBN;
+    int RBN = primaryIndex->find(key);
+    if (RBN == -1 || !getBlockByRBN(RBN, block)) {
+        cout << key << " was not found in the file." << endl;
+        return false;
+    }
 
-    blocks[RBN] = block;
+    size_t pos = 0;
+    while (pos < block.records.size() && block.records[pos + keyField] != key) {
+        pos += fieldCount;
+    }
+    if (pos >= block.records.size()) {
+        cerr << "Error: Index points " << key << " at block " << RBN << " but the record is not there" << endl;
+        return false;
+    }
+    vector<string> record(block.records.begin() + pos, block.records.begin() + pos + fieldCount);
+    if (!openSecondaryIndexes()) return false;
+    spatialIndex.clear();
+    placeTrieStale = true;
+    if (!removeRecord(block, pos)) return false;
+    return updateSecondaryIndexes(record.begin(), false);
+}
 
-    // Update the global head pointers
-    if (!isAvailable && listHeadRBN == -1) {
-        listHeadRBN = RBN;
+/**
+ * @brief Deletes the record with a primary key from the blocked sequence set.
+ *
+ * Like insertRecord(), the writes of the delete, merge or redistribution included,
+ * are committed to the redo log as one mutation, or rolled back if it fails partway.
+ *
+ * @param key Primary key of the record to delete.
+ * @return True if the record was found and deleted.
+ *
+ * @pre Requires a block file opened through openBlockFile() and its index built
+ */
+bool deleteRecord(const std::string& key) {
+    if (!applyDelete(key) || !updateHeaderCounts(-1)) {
+        rollbackMutation();
+        return false;
     }
-    if (isAvailable && availHeadRBN == -1) {
-        availHeadRBN = RBN;
+    return blockPool.commit();
+}
+
+/**
+ * @brief Inserts every record of a CSV file (after its title line) with insertRecord().
+ * @param csvFile Path to the CSV file.
+ * @return Number of records inserted.
+ */
+int insertRecordsFromFile(const std::string& csvFile) {
+    if (blockPool.isMapped()) {
+        cerr << "Error: " << blockPool.getFileName() << " is open read-only" << endl;
+        return 0;
+    }
+    ifstream inFile(csvFile);
+    if (!inFile.is_open()) {
+        cerr << "Error: Could not open input file: " << csvFile << endl;
+        return 0;
+    }
+
+    int inserted = 0;
+    string line;
+    getline(inFile, line); // Skip header
+    while (getline(inFile, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (!line.empty() && insertRecord(line)) {
+            inserted++;
+        }
     }
+    blockPool.flush();
+    return inserted;
 }
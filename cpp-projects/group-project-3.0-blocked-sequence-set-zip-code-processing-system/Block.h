@@ -15,7 +15,56 @@
 
 #include <vector>
 #include <string>
+#include <string_view>
 #include <map>
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <memory>
+#include "ZoneMap.h"
+#include "BloomFilter.h"
+#include "BlockCodec.h"
+
+class HeaderRecord;
+class BufferPool;
+class KeyIndex;
+class BlockView;
+
+/// Block size of new block files, in bytes.
+const size_t DEFAULT_BLOCK_SIZE = 512;
+
+/// Largest block size; fields are located by 16-bit offsets within a block.
+const size_t MAX_BLOCK_SIZE = 65536;
+
+/// Index file named in the header record of new block files.
+const char* const DEFAULT_INDEX_FILE = "index.idx";
+
+/// Index schema of new block files: string keys in a B+tree.
+const char* const DEFAULT_INDEX_SCHEMA = "key:string,rbn:int";
+
+/// Offset of the zone map inside the block header.
+const size_t BLOCK_ZONE_MAP_OFFSET = 16;
+
+/**
+ * @brief Size in bytes of the binary header at the start of every block.
+ *
+ * The block header holds, in host byte order: record count (int32),
+ * predecessor RBN (int32), successor RBN (int32), the avail flag (one byte
+ * followed by three bytes of padding) and the block's ZoneMap. The rest of the
+ * block holds the records, each written as a uint16 length followed by the comma
+ * separated record text.
+ *
+ * In a compressed block file the padding after the avail flag holds a codec flag and
+ * the uint16 length of the stored records (see compressBlock()).
+ */
+const size_t BLOCK_HEADER_SIZE = BLOCK_ZONE_MAP_OFFSET + ZONE_MAP_SIZE;
+
+/// Offset of the codec flag in the header of a compressed block: 1 if the records were
+/// compressed with the codec of the file, 0 if they are stored as they are.
+const size_t BLOCK_CODEC_FLAG_OFFSET = 13;
+
+/// Offset of the uint16 byte count of the stored records in the header of a compressed block.
+const size_t BLOCK_STORED_LENGTH_OFFSET = 14;
 
 /**
  * @struct Block
@@ -28,17 +77,25 @@
 struct Block {
     int RBN;                           ///< Relative Block Number (unique identifier for the block)
     bool isAvailable;                  ///< Flag indicating whether the block is available
-    std::vector<std::string> records;  ///< Records stored in the block
+    std::vector<std::string> records;  ///< Fields of the records stored in the block, record after record
     int predecessorRBN;                ///< RBN of the predecessor block in the chain
     int successorRBN;                  ///< RBN of the successor block in the chain
 };
 
-/** 
- * @brief Global map of blocks indexed by Relative Block Number (RBN).
- * 
- * This map stores all blocks, with the RBN as the key and the corresponding block as the value.
+/**
+ * @brief Buffer pool through which every block of the open block file is read.
+ *
+ * Blocks are read on demand when a lookup, dump or query needs them; see BufferPool.
  */
-extern std::map<int, Block> blocks;
+extern BufferPool blockPool;
+
+/**
+ * @brief Primary key index used by search() to find the block that holds a zip code.
+ *
+ * Opened on the index file named in the header record, in the format its index
+ * schema selects; see KeyIndex.
+ */
+extern std::unique_ptr<KeyIndex> primaryIndex;
 
 /** 
  * @brief Head of the active block list (RBN).
@@ -58,9 +115,12 @@ extern int availHeadRBN;
  * @brief Dumps blocks in physical order based on their RBNs.
  * 
  * This function iterates over all blocks in ascending order of their RBNs and prints their details.
- * Available blocks are explicitly marked.
+ * Available blocks are explicitly marked. With more than one worker, slices of the
+ * file are formatted in parallel and printed in RBN order.
+ *
+ * @param workers Number of worker threads; 0 selects one per hardware thread.
  */
-void dumpPhysicalOrder();
+void dumpPhysicalOrder(unsigned workers = 1);
 
 /**
  * @brief Dumps blocks in logical order starting from the active list head.
@@ -70,45 +130,381 @@ void dumpPhysicalOrder();
 void dumpLogicalOrder();
 
 /**
- * @brief Creates a new block and inserts it into the global map.
+ * @brief Opens a block file for on-demand block reads through the global buffer pool.
+ * 
+ * Only the header record is read here; blocks are read when first requested. In
+ * mapped mode the block file and the index are mapped read-only and lookups and
+ * dumps read the mapped pages directly.
  * 
- * @param RBN Relative Block Number of the new block.
- * @param isAvailable Flag indicating whether the block is available (true) or active (false).
- * @param records List of records to store in the block.
- * @param predecessorRBN RBN of the predecessor block in the chain.
- * @param successorRBN RBN of the successor block in the chain.
+ * A block file whose header record is stale was not closed by closeBlockFile(); it is
+ * first recovered from its redo log (see BufferPool::open()).
  * 
- * This function initializes a new block with the provided parameters and adds it to the global map.
+ * @param blockFile Path to the block file to open.
+ * @param frameCount Number of block frames the buffer pool may hold.
+ * @param mapped True to map the block file (and later the index) read-only.
+ * @param falsePositiveRate False positive rate of the Bloom filter the indexes are
+ *                          rebuilt with after a failed mutation.
+ * @return True if the block file was opened.
  */
-void createBlock(int RBN, bool isAvailable, const std::vector<std::string>& records, int predecessorRBN, int successorRBN);
+bool openBlockFile(const std::string& blockFile, size_t frameCount, bool mapped = false,
+                   double falsePositiveRate = DEFAULT_BLOOM_FPR);
 
 /**
- * @brief Parses a block file and populates the global map of blocks.
- * 
- * This function reads a block file, extracts block information, and populates the global `blocks` map.
- * 
- * @param blockFile Path to the block file to parse.
+ * @brief Checkpoints and closes the open block file and the indexes opened on it.
+ *
+ * Mutations still pending in the redo log are written in place, the stale flag of the
+ * header record is cleared and the log is deleted. Another block file can be opened
+ * afterwards.
  */
-void parseBlockFile(const std::string& blockFile);
+void closeBlockFile();
+
+/**
+ * @brief Retrieves a block by its Relative Block Number (RBN) through the buffer pool.
+ * @param requestedRBN The Relative Block Number of the block to retrieve.
+ * @param block Receives a copy of the block.
+ * @return True if the block exists, false otherwise.
+ */
+bool getBlockByRBN(int requestedRBN, Block& block);
 
 /**
  * @brief Creates a block file from an input CSV file.
  * 
  * This function reads an input CSV file, divides the data into blocks of a specified size, and writes the blocks to an output file.
+ * Every block occupies exactly BLOCK_SIZE bytes, so block RBN starts at byte `headerSize + (RBN - 1) * BLOCK_SIZE`.
+ * The zone maps of the blocks are also written to the sidecar file named by zoneMapFileName().
  * 
  * @param inputFile Path to the input CSV file.
  * @param outputFile Path to the output block file.
- * @param BLOCK_SIZE Maximum size of each block in bytes (default is 512).
+ * @param BLOCK_SIZE Size of each block in bytes, more than BLOCK_HEADER_SIZE and at most
+ *                   MAX_BLOCK_SIZE (default is DEFAULT_BLOCK_SIZE).
+ * @param indexSchema Index schema recorded in the header: "key:string,rbn:int" for a
+ *                    B+tree index, "key:zip5,rbn:int" for a direct-address index,
+ *                    "key:uint32,rbn:int" for a sorted array index.
  * @return True if successful, false otherwise.
  */
-bool createBlockFile(const std::string& inputFile, const std::string& outputFile, size_t BLOCK_SIZE = 512);
+bool createBlockFile(const std::string& inputFile, const std::string& outputFile, size_t BLOCK_SIZE = DEFAULT_BLOCK_SIZE,
+                     const std::string& indexSchema = DEFAULT_INDEX_SCHEMA);
+
+/// Fraction of each block's record space filled by a bulk load.
+const double DEFAULT_FILL_FACTOR = 1.0;
+
+/**
+ * @brief Bulk loads a CSV file sorted by key into a new block file and its indexes.
+ *
+ * Reads the CSV file once, packing records into blocks up to the fill factor and
+ * building the primary key index (in the format of the index schema), Bloom filter,
+ * secondary indexes and place name trie from the same records. The block file is not
+ * read back. Fails if the records are not in strictly increasing key order.
+ *
+ * The block size, fill factor and compression are recorded in the header record, and
+ * every reader of the file takes them from there.
+ *
+ * @param inputFile Path to the input CSV file.
+ * @param outputFile Path to the output block file.
+ * @param BLOCK_SIZE Size of each block in bytes (see createBlockFile()).
+ * @param indexSchema Index schema recorded in the header (see createBlockFile()).
+ * @param fillFactor Fraction of each block's record space filled, from the minimum block
+ *                   capacity (50%) up to 1; the rest is left for inserts.
+ * @param falsePositiveRate False positive rate the Bloom filter is sized for.
+ * @param indexFile Index file to create and name in the header record.
+ * @param compression Codec of the blocks (see findBlockCodec()); "none" with no
+ *                    compressed block size writes an uncompressed file.
+ * @param compressedBlockSize Bytes each block takes on disk, at most BLOCK_SIZE; 0 selects
+ *                    the codec's BlockCodec::defaultStoredSize() for a codec other than "none".
+ *                    A block is closed once its compressed records would no longer fit.
+ * @return True if the block file and every index were written.
+ */
+bool bulkLoad(const std::string& inputFile, const std::string& outputFile, size_t BLOCK_SIZE = DEFAULT_BLOCK_SIZE,
+              const std::string& indexSchema = DEFAULT_INDEX_SCHEMA, double fillFactor = DEFAULT_FILL_FACTOR,
+              double falsePositiveRate = DEFAULT_BLOOM_FPR, const std::string& indexFile = DEFAULT_INDEX_FILE,
+              const std::string& compression = DEFAULT_BLOCK_CODEC, size_t compressedBlockSize = 0);
+
+/**
+ * @brief Compares two primary keys in sequence set order.
+ *
+ * Keys made only of digits compare by numeric value (so "501" sorts before "1001"),
+ * any other keys compare as plain strings.
+ *
+ * @param a First key.
+ * @param b Second key.
+ * @return Negative, zero or positive as a is less than, equal to or greater than b.
+ */
+int compareKeys(std::string_view a, std::string_view b);
+
+/**
+ * @brief Number of fields per record declared by a header record.
+ *
+ * Falls back to the six zip code fields when the header carries no field metadata.
+ *
+ * @param header Header record of the block file.
+ * @return Number of fields per record.
+ */
+size_t recordFieldCount(const HeaderRecord& header);
+
+/**
+ * @brief Finds a field by name in the header field metadata.
+ * @param header Header record of the block file.
+ * @param name Field name, e.g. "state".
+ * @param fallback Field number to use when the header does not name the field.
+ * @return Field number.
+ */
+size_t fieldIndex(const HeaderRecord& header, const std::string& name, size_t fallback);
+
+/**
+ * @brief Writes the header record at the start of a block file and pads it to the header size.
+ * @param out Block file opened in binary mode.
+ * @param header Header record to write; its header size may be updated.
+ * @param allowGrow True if the header region may still be enlarged (only before blocks are written).
+ * @return True if the header was written.
+ */
+bool writeHeaderRegion(std::ostream& out, HeaderRecord& header, bool allowGrow);
+
+/**
+ * @brief Bytes one block takes in the block file: the compressed block size of a
+ *        compressed file, otherwise the block size.
+ * @param header Header record of the block file.
+ * @return Bytes per block on disk.
+ */
+size_t storedBlockSize(const HeaderRecord& header);
+
+/**
+ * @brief Computes the byte offset of a block in the block file.
+ * @param header Header record of the block file.
+ * @param RBN Relative Block Number of the block (first block is 1).
+ * @return Offset of the first byte of the block.
+ */
+long long blockOffset(const HeaderRecord& header, int RBN);
+
+/**
+ * @brief Counts the blocks stored in a block file from its size.
+ * @param header Header record of the block file.
+ * @param in Block file opened in binary mode.
+ * @return Number of blocks following the header.
+ */
+int countBlocks(const HeaderRecord& header, std::istream& in);
+
+/**
+ * @brief Encodes a block into its fixed-size image, zone map included.
+ *
+ * This is the on-disk image of an uncompressed file; compressBlock() turns it into
+ * the on-disk image of a compressed one.
+ *
+ * @param block Block to encode.
+ * @param header Header record giving the block size and the record fields.
+ * @param out Receives exactly blockSize bytes.
+ * @return False if the records do not fit in one block.
+ */
+bool packBlock(const Block& block, const HeaderRecord& header, std::string& out);
 
+/**
+ * @brief Turns a block image into the image stored in the block file.
+ *
+ * In a compressed file the block header is kept as it is, so zone maps and links can
+ * be read without decompressing, and the records after it are compressed with the
+ * codec of the file into the rest of the compressed block size. Records that the codec
+ * does not shrink are stored as they are. An uncompressed file stores the image itself.
+ *
+ * @param header Header record of the block file.
+ * @param image Block image of blockSize bytes from packBlock().
+ * @param stored Receives storedBlockSize() bytes.
+ * @return False if the records do not fit in the compressed block size.
+ */
+bool compressBlock(const HeaderRecord& header, const std::string& image, std::string& stored);
+
+/**
+ * @brief Turns an image stored in the block file back into the block image.
+ * @param header Header record of the block file.
+ * @param stored storedBlockSize() bytes read from the block file.
+ * @param image Receives blockSize bytes.
+ * @return False if the stored records are malformed.
+ */
+bool expandBlock(const HeaderRecord& header, const char* stored, char* image);
+
+/**
+ * @brief Decodes a fixed-size block image (see packBlock()).
+ * @param data Pointer to blockSize bytes of block data.
+ * @param blockSize Size of the block image in bytes.
+ * @param RBN Relative Block Number the image was read from.
+ * @param block Receives the decoded block.
+ * @return False if the image is malformed.
+ */
+bool unpackBlock(const char* data, size_t blockSize, int RBN, Block& block);
 
+/**
+ * @brief Reads one block from a block file with a single seek.
+ * @param in Block file opened in binary mode.
+ * @param header Header record of the block file.
+ * @param RBN Relative Block Number of the block to read.
+ * @param block Receives the decoded block.
+ * @return True if the block was read and decoded.
+ */
+bool readBlock(std::istream& in, const HeaderRecord& header, int RBN, Block& block);
 
-void listMost();
+/**
+ * @brief Writes one block in place in a block file.
+ * @param out Block file opened in binary mode.
+ * @param header Header record of the block file.
+ * @param block Block to write; its RBN selects the slot.
+ * @return True if the block fit and was written.
+ */
+bool writeBlock(std::ostream& out, const HeaderRecord& header, const Block& block);
+
+/**
+ * @brief Inserts one record into the blocked sequence set in key order.
+ *
+ * The record goes into the block whose key range covers its key. If the block
+ * overflows it is split in two; the new block is taken from the avail list before
+ * the file is extended. The B+tree index is updated for the new record and for
+ * every record moved by a split, and the key is added to the index's Bloom filter.
+ * The block and header writes are committed to the redo log as one mutation.
+ *
+ * @param recordLine Comma separated fields of the record, primary key included.
+ * @return True if the record was inserted, false if it is malformed, a duplicate or an I/O error occurred.
+ */
+bool insertRecord(const std::string& recordLine);
+
+/**
+ * @brief Inserts every record of a CSV file (after its title line) with insertRecord().
+ * @param csvFile Path to the CSV file.
+ * @return Number of records inserted.
+ */
+int insertRecordsFromFile(const std::string& csvFile);
+
+/**
+ * @brief Deletes the record with a primary key from the blocked sequence set.
+ *
+ * When the block drops below the header's minimum block capacity it borrows records
+ * from a neighbouring block, or merges with it when both fit in one block. A block
+ * emptied by a merge is pushed onto the avail list. The B+tree index entry of the
+ * deleted record is removed and moved records are re-pointed in place. The block
+ * and header writes are committed to the redo log as one mutation.
+ *
+ * @param key Primary key of the record to delete.
+ * @return True if the record was found and deleted.
+ */
+bool deleteRecord(const std::string& key);
+
+/**
+ * @brief Prints the easternmost, westernmost, northernmost and southernmost zip code
+ *        of each state in one streaming pass over the active blocks.
+ *
+ * With more than one worker the blocks are split across threads, each computing
+ * partial extremes that are merged at the end.
+ *
+ * @param workers Number of worker threads; 0 selects one per hardware thread.
+ */
+void listMost(unsigned workers = 1);
+
+/**
+ * @brief Prints the extreme zip codes of one state, reading only the blocks whose
+ *        zone map contains the state.
+ * @param state Two-letter state abbreviation, e.g. "NY".
+ */
+void listMostOfState(const std::string& state);
 
+/**
+ * @brief Looks up a zip code through the B+tree index and reads only the block that holds it.
+ * @param str Zip code to search for.
+ * @param indexName Name of the index file, as recorded in the header record.
+ */
 void search(const std::string& str, const std::string& indexName);
 
 std::vector<std::string> splitZipLine(const std::string& str);
 
+/**
+ * @brief Looks up many zip codes with one ordered pass over the index and the blocks.
+ *
+ * The keys are sorted with compareKeys() and duplicates are dropped. The index is
+ * walked once in key order (see KeyIndex::findMany) and every block that holds at
+ * least one requested key is read once, however many of the keys it holds.
+ *
+ * @param keys Zip codes to look up, in any order.
+ * @param indexName Name of the index file, as recorded in the header record.
+ * @param visit Called once per distinct key in ascending order with a view of the block
+ *              holding the record and the record number, or with nullptr if the key is
+ *              not in the file. The view is only valid during the call.
+ */
+void batchSearch(std::vector<std::string> keys, const std::string& indexName,
+                 const std::function<void(const std::string&, const BlockView*, size_t)>& visit);
+
+/**
+ * @brief Searches for several zip codes with batchSearch() and prints each record like search().
+ * @param keys Zip codes to look up, in any order.
+ * @param indexName Name of the index file, as recorded in the header record.
+ */
+void searchMany(const std::vector<std::string>& keys, const std::string& indexName);
+
+/**
+ * @brief Visits every record whose key lies in [lowKey, highKey], in key order.
+ *
+ * The index locates the block of the first key in range; from there the successor
+ * chain is followed one pinned block at a time, so a range is never materialized.
+ *
+ * @param lowKey Smallest key to visit.
+ * @param highKey Largest key to visit.
+ * @param indexName Name of the index file, as recorded in the header record.
+ * @param visit Called with a view of the block and the record number; return false to
+ *              stop. The view is only valid during the call.
+ * @return Number of times visit was called.
+ */
+size_t rangeQuery(const std::string& lowKey, const std::string& highKey, const std::string& indexName,
+                  const std::function<bool(const BlockView&, size_t)>& visit);
+
+/**
+ * @brief Prints every record whose key lies in [lowKey, highKey] like search().
+ * @param lowKey Smallest key to print.
+ * @param highKey Largest key to print.
+ * @param indexName Name of the index file, as recorded in the header record.
+ */
+void printRange(const std::string& lowKey, const std::string& highKey, const std::string& indexName);
+
+/**
+ * @brief Prints the k place names starting with a prefix that have the most zip codes.
+ *
+ * Completions come from the compressed place name trie saved next to the index (see
+ * PrefixTrie), which is memory-mapped and rebuilt after inserts or deletes.
+ *
+ * @param prefix Start of the place name, in any case (e.g. "holts").
+ * @param k Number of completions to print.
+ * @param indexName Name of the index file, as recorded in the header record.
+ */
+void printCompletions(const std::string& prefix, size_t k, const std::string& indexName);
+
+/**
+ * @brief Prints every record whose field holds a value, using the field's secondary index.
+ *
+ * Fields declared with SECONDARY_INDEX_TAG in their header type schema (place_name,
+ * state and county) have a secondary index mapping each value to the primary keys of
+ * its records; matches are printed in key order.
+ *
+ * @param fieldName Name of an indexed field, e.g. "county".
+ * @param value Field value to match exactly, e.g. "Suffolk".
+ * @param indexName Name of the primary index file, as recorded in the header record.
+ */
+void printByField(const std::string& fieldName, const std::string& value, const std::string& indexName);
+
+/**
+ * @brief Prints the k zip codes closest to a location, closest first.
+ *
+ * Uses an in-memory k-d tree over the record locations, built from the active blocks
+ * on first use and rebuilt after inserts and deletes. The build time, the query time
+ * and the time of the same query answered by a brute-force scan are printed.
+ *
+ * @param latitude Latitude of the location in degrees.
+ * @param longitude Longitude of the location in degrees.
+ * @param k Number of zip codes to print.
+ */
+void printNearest(double latitude, double longitude, size_t k);
+
+/**
+ * @brief Prints every zip code within a great-circle distance of a location, closest first.
+ *
+ * Uses the same k-d tree as printNearest() and reports the same timings.
+ *
+ * @param latitude Latitude of the location in degrees.
+ * @param longitude Longitude of the location in degrees.
+ * @param radiusKm Largest distance in kilometres.
+ */
+void printWithinRadius(double latitude, double longitude, double radiusKm);
+
 #endif // BLOCK_H
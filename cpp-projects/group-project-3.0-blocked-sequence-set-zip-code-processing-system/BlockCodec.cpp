@@ -0,0 +1,344 @@
+// CSCI 331 Group Project - Copyright © 2024 Blocked Sequence Set Zip Code Processing System
+#include "BlockCodec.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+using namespace std;
+
+/**
+ * @brief Compression counters of this process.
+ */
+CodecStats codecStats;
+
+/// Shortest match the LZ codec encodes.
+static const size_t LZ_MIN_MATCH = 4;
+
+/// Bits of the LZ codec's match hash; the table has 2^LZ_HASH_BITS entries.
+static const unsigned LZ_HASH_BITS = 12;
+
+/// Farthest back a match may start, set by the 16-bit offsets.
+static const size_t LZ_MAX_OFFSET = UINT16_MAX;
+
+/// Longest shared prefix the front codec records; its count is one byte.
+static const size_t FRONT_MAX_SHARED = 255;
+
+/// Suffix length byte that announces a 16-bit suffix length.
+static const unsigned char FRONT_LONG_SUFFIX = 255;
+
+/**
+ * @class NoCodec
+ * @brief Codec "none": copies the bytes unchanged.
+ */
+class NoCodec : public BlockCodec {
+public:
+    const char* getName() const override { return "none"; }
+    size_t defaultStoredSize(size_t blockSize) const override { return blockSize; }
+
+    size_t compress(const char* in, size_t size, char* out, size_t capacity) const override {
+        if (size > capacity) return 0;
+        memcpy(out, in, size);
+        return size;
+    }
+
+    size_t decompress(const char* in, size_t size, char* out, size_t capacity) const override {
+        return compress(in, size, out, capacity);
+    }
+};
+
+/**
+ * @class LzCodec
+ * @brief Codec "lz": LZ77 sequences of literals and back references.
+ *
+ * Each sequence is a token byte, whose high nibble is the literal count and low nibble
+ * the match length minus LZ_MIN_MATCH, followed by the literals, a 16-bit little-endian
+ * match offset and, when a nibble is 15, extra length bytes of 255 each ending with a
+ * smaller one. The last sequence has literals only.
+ */
+class LzCodec : public BlockCodec {
+public:
+    const char* getName() const override { return "lz"; }
+    size_t defaultStoredSize(size_t blockSize) const override { return blockSize / 2; }
+    size_t compress(const char* in, size_t size, char* out, size_t capacity) const override;
+    size_t decompress(const char* in, size_t size, char* out, size_t capacity) const override;
+};
+
+/**
+ * @brief Compresses bytes with a greedy parse, finding matches through a hash table of
+ *        the last position of every 4-byte prefix.
+ * @param in Bytes to compress.
+ * @param size Number of bytes to compress.
+ * @param out Buffer receiving the compressed bytes.
+ * @param capacity Bytes available in out.
+ * @return Bytes written, or 0 if they would not fit in capacity.
+ */
+size_t LzCodec::compress(const char* in, size_t size, char* out, size_t capacity) const {
+    const unsigned char* src = reinterpret_cast<const unsigned char*>(in);
+    unsigned char* dst = reinterpret_cast<unsigned char*>(out);
+    size_t op = 0;
+
+    // Writes one sequence; false if it would overflow the output
+    auto emit = [&](size_t literalStart, size_t literals, size_t offset, size_t matchLength) {
+        size_t extra = matchLength ? matchLength - LZ_MIN_MATCH : 0;
+        size_t bytes = 1 + literals + (literals >= 15 ? (literals - 15) / 255 + 1 : 0)
+                     + (matchLength ? 2 + (extra >= 15 ? (extra - 15) / 255 + 1 : 0) : 0);
+        if (op + bytes > capacity) return false;
+        auto putLength = [&](size_t length) {
+            for (length -= 15; length >= 255; length -= 255) dst[op++] = 255;
+            dst[op++] = static_cast<unsigned char>(length);
+        };
+        dst[op++] = static_cast<unsigned char>((min<size_t>(literals, 15) << 4) | (matchLength ? min<size_t>(extra, 15) : 0));
+        if (literals >= 15) putLength(literals);
+        memcpy(dst + op, src + literalStart, literals);
+        op += literals;
+        if (matchLength) {
+            dst[op++] = static_cast<unsigned char>(offset & 0xff);
+            dst[op++] = static_cast<unsigned char>(offset >> 8);
+            if (extra >= 15) putLength(extra);
+        }
+        return true;
+    };
+
+    int32_t table[1 << LZ_HASH_BITS];
+    for (int32_t& position : table) position = -1;
+
+    size_t anchor = 0;  ///< First byte not yet written
+    size_t ip = 0;
+    while (ip + LZ_MIN_MATCH <= size) {
+        uint32_t word;
+        memcpy(&word, src + ip, 4);
+        uint32_t hash = (word * 2654435761u) >> (32 - LZ_HASH_BITS);
+        int32_t candidate = table[hash];
+        table[hash] = static_cast<int32_t>(ip);
+        if (candidate < 0 || ip - candidate > LZ_MAX_OFFSET || memcmp(src + candidate, src + ip, LZ_MIN_MATCH) != 0) {
+            ip++;
+            continue;
+        }
+        size_t length = LZ_MIN_MATCH;
+        while (ip + length < size && src[candidate + length] == src[ip + length]) length++;
+        if (!emit(anchor, ip - anchor, ip - candidate, length)) return 0;
+        ip += length;
+        anchor = ip;
+    }
+    if (anchor < size && !emit(anchor, size - anchor, 0, 0)) return 0;
+    return op;
+}
+
+/**
+ * @brief Decompresses bytes written by compress(), checking every length and offset.
+ * @param in Compressed bytes.
+ * @param size Number of compressed bytes.
+ * @param out Buffer receiving the original bytes.
+ * @param capacity Bytes available in out.
+ * @return Bytes written, or 0 if the input is malformed or would overflow capacity.
+ */
+size_t LzCodec::decompress(const char* in, size_t size, char* out, size_t capacity) const {
+    const unsigned char* src = reinterpret_cast<const unsigned char*>(in);
+    size_t ip = 0, op = 0;
+
+    auto getLength = [&](size_t& length) {
+        unsigned char more;
+        do {
+            if (ip >= size) return false;
+            more = src[ip++];
+            length += more;
+        } while (more == 255);
+        return true;
+    };
+
+    while (ip < size) {
+        unsigned char token = src[ip++];
+        size_t literals = token >> 4;
+        if (literals == 15 && !getLength(literals)) return 0;
+        if (literals > size - ip || literals > capacity - op) return 0;
+        memcpy(out + op, src + ip, literals);
+        ip += literals;
+        op += literals;
+        if (ip == size) break;
+
+        if (size - ip < 2) return 0;
+        size_t offset = src[ip] | (static_cast<size_t>(src[ip + 1]) << 8);
+        ip += 2;
+        size_t length = token & 15;
+        if (length == 15 && !getLength(length)) return 0;
+        length += LZ_MIN_MATCH;
+        if (offset == 0 || offset > op || length > capacity - op) return 0;
+        if (offset >= length) {
+            memcpy(out + op, out + op - offset, length);
+            op += length;
+        } else {
+            // Byte by byte, since the match overlaps the bytes it produces
+            for (size_t i = 0; i < length; i++, op++) out[op] = out[op - offset];
+        }
+    }
+    return op;
+}
+
+/**
+ * @class FrontCodec
+ * @brief Codec "front": front coding of the length-prefixed records of a block.
+ *
+ * Each record is stored as the number of leading bytes it shares with the previous
+ * record (one byte), the length of the rest (one byte, or FRONT_LONG_SUFFIX followed
+ * by a 16-bit little-endian length) and the rest. The records of a block are in key
+ * order with the key first, so a zip code record shares most of its key with the one
+ * before it. A block is always expanded whole before it is searched, so there are no
+ * restart points: the first record of every block is stored in full.
+ */
+class FrontCodec : public BlockCodec {
+public:
+    const char* getName() const override { return "front"; }
+    size_t defaultStoredSize(size_t blockSize) const override { return blockSize - blockSize / 16; }
+    size_t compress(const char* in, size_t size, char* out, size_t capacity) const override;
+    size_t decompress(const char* in, size_t size, char* out, size_t capacity) const override;
+};
+
+/**
+ * @brief Front codes a run of records, each a 16-bit length followed by its text.
+ * @param in Records to compress.
+ * @param size Number of bytes of records.
+ * @param out Buffer receiving the front coded records.
+ * @param capacity Bytes available in out.
+ * @return Bytes written, or 0 if the records are malformed or would not fit in capacity.
+ */
+size_t FrontCodec::compress(const char* in, size_t size, char* out, size_t capacity) const {
+    size_t ip = 0, op = 0;
+    size_t previous = 0, previousLength = 0;  ///< Text of the previous record
+    while (ip < size) {
+        uint16_t length;
+        if (size - ip < 2) return 0;
+        memcpy(&length, in + ip, 2);
+        ip += 2;
+        if (length > size - ip) return 0;
+
+        size_t shared = 0;
+        while (shared < previousLength && shared < length && shared < FRONT_MAX_SHARED
+               && in[previous + shared] == in[ip + shared]) {
+            shared++;
+        }
+        size_t rest = length - shared;
+        size_t bytes = 2 + (rest >= FRONT_LONG_SUFFIX ? 2 : 0) + rest;
+        if (bytes > capacity - op) return 0;
+        out[op++] = static_cast<char>(shared);
+        if (rest < FRONT_LONG_SUFFIX) {
+            out[op++] = static_cast<char>(rest);
+        } else {
+            out[op++] = static_cast<char>(FRONT_LONG_SUFFIX);
+            out[op++] = static_cast<char>(rest & 0xff);
+            out[op++] = static_cast<char>(rest >> 8);
+        }
+        memcpy(out + op, in + ip + shared, rest);
+        op += rest;
+
+        previous = ip;
+        previousLength = length;
+        ip += length;
+    }
+    return op;
+}
+
+/**
+ * @brief Rebuilds the records written by compress(), checking every length.
+ * @param in Front coded records.
+ * @param size Number of front coded bytes.
+ * @param out Buffer receiving the records.
+ * @param capacity Bytes available in out.
+ * @return Bytes written, or 0 if the input is malformed or would overflow capacity.
+ */
+size_t FrontCodec::decompress(const char* in, size_t size, char* out, size_t capacity) const {
+    const unsigned char* src = reinterpret_cast<const unsigned char*>(in);
+    size_t ip = 0, op = 0;
+    size_t previous = 0, previousLength = 0;  ///< Text of the previous record in out
+    while (ip < size) {
+        if (size - ip < 2) return 0;
+        size_t shared = src[ip];
+        size_t rest = src[ip + 1];
+        ip += 2;
+        if (rest == FRONT_LONG_SUFFIX) {
+            if (size - ip < 2) return 0;
+            rest = src[ip] | (static_cast<size_t>(src[ip + 1]) << 8);
+            ip += 2;
+        }
+        size_t length = shared + rest;
+        if (shared > previousLength || rest > size - ip || length > UINT16_MAX || length + 2 > capacity - op) return 0;
+
+        uint16_t storedLength = static_cast<uint16_t>(length);
+        memcpy(out + op, &storedLength, 2);
+        op += 2;
+        memcpy(out + op, out + previous, shared);
+        memcpy(out + op + shared, src + ip, rest);
+        ip += rest;
+
+        previous = op;
+        previousLength = length;
+        op += length;
+    }
+    return op;
+}
+
+/// Every codec, in the order blockCodecNames() lists them.
+static const NoCodec noCodec;
+static const LzCodec lzCodec;
+static const FrontCodec frontCodec;
+static const BlockCodec* const codecs[] = { &noCodec, &lzCodec, &frontCodec };
+
+/**
+ * @brief Looks up a codec by name.
+ * @param name Codec name from the header record or the command line; empty means "none".
+ * @return The codec, or nullptr if no codec has that name.
+ */
+const BlockCodec* findBlockCodec(const string& name) {
+    if (name.empty()) return &noCodec;
+    for (const BlockCodec* codec : codecs) {
+        if (name == codec->getName()) return codec;
+    }
+    return nullptr;
+}
+
+/**
+ * @brief Lists the codec names for messages, e.g. "none, lz, front".
+ */
+string blockCodecNames() {
+    string names;
+    for (const BlockCodec* codec : codecs) {
+        if (!names.empty()) names += ", ";
+        names += codec->getName();
+    }
+    return names;
+}
+
+/**
+ * @brief Resets every counter.
+ */
+void CodecStats::reset() {
+    decompressedBlocks = 0;
+    rawBytes = 0;
+    storedBytes = 0;
+    decompressNanos = 0;
+}
+
+/**
+ * @brief Record bytes per stored byte of the blocks counted so far (1 if none).
+ */
+double CodecStats::getRatio() const {
+    unsigned long long stored = storedBytes;
+    return stored ? static_cast<double>(rawBytes) / stored : 1.0;
+}
+
+/**
+ * @brief Mean microseconds spent decompressing one block (0 if none).
+ */
+double CodecStats::getDecompressMicros() const {
+    unsigned long long blocks = decompressedBlocks;
+    return blocks ? decompressNanos / 1000.0 / blocks : 0.0;
+}
+
+/**
+ * @brief Prints the block count, the compression ratio and the decompression cost.
+ * @param out Stream to print to.
+ */
+void CodecStats::print(ostream& out) const {
+    out << "Blocks decompressed: " << decompressedBlocks << ", Compression ratio: " << getRatio()
+        << ", Decompression: " << getDecompressMicros() << " us per block\n";
+}
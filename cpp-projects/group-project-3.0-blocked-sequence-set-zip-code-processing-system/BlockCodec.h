@@ -0,0 +1,123 @@
+// CSCI 331 Group Project - Copyright © 2024 Blocked Sequence Set Zip Code Processing System
+/**
+ * @file BlockCodec.h
+ * @brief Declaration of the codecs that compress the records of a block on disk.
+ *
+ * A block file may store every block in a compressed slot smaller than the block size
+ * (see compressBlock()). The codec is named in the header record and looked up with
+ * findBlockCodec(); blocks are always decompressed to their full block size before any
+ * reader sees them, so the buffer pool, BlockView and the indexes are unchanged.
+ *
+ * Codecs:
+ *  - "none": stores the records as they are.
+ *  - "lz":   byte-oriented LZ77 in the style of LZ4, with a hash table of 4-byte
+ *            matches, 16-bit offsets and no entropy coding. Zip code records repeat
+ *            their state, county and place names, which it finds within a block.
+ *  - "front": front coding; each record keeps only the bytes after the prefix it
+ *            shares with the record before it, typically the leading key digits.
+ */
+
+#ifndef BLOCK_CODEC_H
+#define BLOCK_CODEC_H
+
+#include <atomic>
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+
+/// Codec of new block files.
+const char* const DEFAULT_BLOCK_CODEC = "none";
+
+/**
+ * @class BlockCodec
+ * @brief Compresses and decompresses a run of bytes that fits in one block.
+ *
+ * Codecs are stateless and may be used by several threads at once.
+ */
+class BlockCodec {
+public:
+    virtual ~BlockCodec() {}
+
+    /**
+     * @brief Returns the name recorded in the header record.
+     */
+    virtual const char* getName() const = 0;
+
+    /**
+     * @brief Returns the bytes a block takes on disk unless the load chooses otherwise.
+     * @param blockSize Size of the block image in bytes.
+     */
+    virtual size_t defaultStoredSize(size_t blockSize) const = 0;
+
+    /**
+     * @brief Compresses bytes into a buffer.
+     * @param in Bytes to compress.
+     * @param size Number of bytes to compress.
+     * @param out Buffer receiving the compressed bytes.
+     * @param capacity Bytes available in out.
+     * @return Bytes written, or 0 if they would not fit in capacity.
+     */
+    virtual size_t compress(const char* in, size_t size, char* out, size_t capacity) const = 0;
+
+    /**
+     * @brief Decompresses bytes written by compress().
+     * @param in Compressed bytes.
+     * @param size Number of compressed bytes.
+     * @param out Buffer receiving the original bytes.
+     * @param capacity Bytes available in out.
+     * @return Bytes written, or 0 if the input is malformed or would overflow capacity.
+     */
+    virtual size_t decompress(const char* in, size_t size, char* out, size_t capacity) const = 0;
+};
+
+/**
+ * @brief Looks up a codec by name.
+ * @param name Codec name from the header record or the command line; empty means "none".
+ * @return The codec, or nullptr if no codec has that name.
+ */
+const BlockCodec* findBlockCodec(const std::string& name);
+
+/**
+ * @brief Lists the codec names for messages, e.g. "none, lz, front".
+ */
+std::string blockCodecNames();
+
+/**
+ * @brief Counters of the blocks decompressed by this process.
+ *
+ * The counters are atomic because parallelScan() workers decompress blocks concurrently.
+ */
+struct CodecStats {
+    std::atomic<unsigned long long> decompressedBlocks{0};  ///< Blocks decompressed for reading
+    std::atomic<unsigned long long> rawBytes{0};            ///< Record bytes of those blocks
+    std::atomic<unsigned long long> storedBytes{0};         ///< Bytes the same records take on disk
+    std::atomic<unsigned long long> decompressNanos{0};     ///< Time spent decompressing
+
+    /**
+     * @brief Resets every counter.
+     */
+    void reset();
+
+    /**
+     * @brief Record bytes per stored byte of the blocks counted so far (1 if none).
+     */
+    double getRatio() const;
+
+    /**
+     * @brief Mean microseconds spent decompressing one block (0 if none).
+     */
+    double getDecompressMicros() const;
+
+    /**
+     * @brief Prints the block count, the compression ratio and the decompression cost.
+     * @param out Stream to print to.
+     */
+    void print(std::ostream& out) const;
+};
+
+/**
+ * @brief Compression counters of this process.
+ */
+extern CodecStats codecStats;
+
+#endif // BLOCK_CODEC_H
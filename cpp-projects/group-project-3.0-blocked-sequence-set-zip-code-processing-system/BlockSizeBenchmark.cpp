@@ -0,0 +1,157 @@
+// CSCI 331 Group Project - Copyright © 2024 Blocked Sequence Set Zip Code Processing System
+#include "BlockSizeBenchmark.h"
+#include "Block.h"
+#include "BlockCodec.h"
+#include "BlockView.h"
+#include "BloomFilter.h"
+#include "BufferPool.h"
+#include "HeaderRecord.h"
+#include "ParallelScan.h"
+#include "PrefixTrie.h"
+#include "SecondaryIndex.h"
+#include "WriteAheadLog.h"
+#include "ZoneMap.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+
+using namespace std;
+
+/**
+ * @brief Returns the milliseconds elapsed since a point in time.
+ */
+static double elapsedMs(chrono::steady_clock::time_point start) {
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * @brief Returns the size of a file in bytes, or 0 if it cannot be opened.
+ */
+static long long fileBytes(const string& fileName) {
+    ifstream in(fileName, ios::binary | ios::ate);
+    return in.is_open() ? static_cast<long long>(in.tellg()) : 0;
+}
+
+/**
+ * @brief Deletes a scratch block file and every file saved next to it or its index.
+ */
+static void removeScratchFiles(const string& blockFile, const string& indexFile, const HeaderRecord& header) {
+    for (const string& name : { blockFile, zoneMapFileName(blockFile), logFileName(blockFile), indexFile,
+                                bloomFileName(indexFile), trieFileName(indexFile) }) {
+        remove(name.c_str());
+    }
+    for (const FieldMetadata& field : header.getFields()) {
+        if (hasSecondaryIndex(field)) remove(secondaryIndexFileName(indexFile, field.name).c_str());
+    }
+}
+
+/**
+ * @brief Measures bulk loads, lookups and scans over a range of block sizes.
+ *
+ * For each block size this function:
+ * 1. Bulk loads the input into a scratch block file and times the load
+ * 2. Opens it with BENCHMARK_POOL_BYTES of buffer pool frames and times a parallel scan
+ *    of every block, collecting the keys on the way
+ * 3. Times BENCHMARK_LOOKUPS lookups of keys drawn with a fixed seed, each through
+ *    batchSearch() like option 5
+ * 4. Closes the file and deletes the scratch files
+ *
+ * The compression ratio and decompression time are those of the blocks read by the
+ * scan and the lookups; an uncompressed file reports a ratio of 1.
+ *
+ * @param inputFile CSV file in key order to load.
+ * @param blockSizes Block sizes to measure, in bytes.
+ * @param indexSchema Index schema of the scratch files.
+ * @param fillFactor Fill factor of the loads.
+ * @param compression Codec of the loads, with the default compressed block size.
+ * @param workers Scan worker threads; 0 selects one per hardware thread.
+ * @param out Stream the results are printed to.
+ * @return False if a load or a scan failed.
+ */
+bool benchmarkBlockSizes(const string& inputFile, const vector<size_t>& blockSizes,
+                         const string& indexSchema, double fillFactor, const string& compression,
+                         unsigned workers, ostream& out) {
+    if (workers == 0) workers = defaultScanWorkers();
+    out << "Block size benchmark of " << inputFile << " (fill factor " << fillFactor << ", compression "
+        << compression << ", " << BENCHMARK_POOL_BYTES / 1024 << " KiB buffer pool, " << workers << " scan threads)\n";
+    out << setw(10) << "block" << setw(10) << "build ms" << setw(9) << "blocks" << setw(11) << "file KiB"
+        << setw(11) << "index KiB" << setw(12) << "lookup us" << setw(10) << "p99 us"
+        << setw(10) << "scan MB/s" << setw(14) << "scan rec/s" << setw(8) << "ratio" << setw(12) << "decomp us"
+        << "\n";
+
+    for (size_t blockSize : blockSizes) {
+        string blockFile = "bench_" + to_string(blockSize) + ".dat";
+        string indexFile = "bench_" + to_string(blockSize) + ".idx";
+
+        // 1. Load; the load's own messages are dropped
+        auto start = chrono::steady_clock::now();
+        streambuf* console = cout.rdbuf(nullptr);
+        bool loaded = bulkLoad(inputFile, blockFile, blockSize, indexSchema, fillFactor, DEFAULT_BLOOM_FPR, indexFile,
+                               compression);
+        cout.rdbuf(console);
+        double buildMs = elapsedMs(start);
+        if (!loaded || !openBlockFile(blockFile, max<size_t>(BENCHMARK_POOL_BYTES / blockSize, 8))) {
+            HeaderRecord header;
+            header.readHeader(blockFile);
+            removeScratchFiles(blockFile, indexFile, header);
+            cerr << "Error: Could not load " << inputFile << " with " << blockSize << " byte blocks" << endl;
+            return false;
+        }
+        HeaderRecord header = blockPool.getHeader();
+        size_t keyField = header.getPrimaryKeyField();
+
+        // 2. Scan every block, keeping the keys for the lookups
+        codecStats.reset();
+        vector<vector<string>> keys(workers);
+        start = chrono::steady_clock::now();
+        bool scanned = parallelScan(blockFile, header, 1, blockPool.getBlockCount(), workers,
+                                    [&](unsigned worker, int, const BlockView& view) {
+            if (view.isAvailable()) return;
+            for (size_t r = 0; r < view.getRecordCount(); r++) {
+                keys[worker].emplace_back(view.field(r, keyField));
+            }
+        });
+        double scanMs = elapsedMs(start);
+        vector<string> allKeys;
+        for (auto& slice : keys) allKeys.insert(allKeys.end(), slice.begin(), slice.end());
+
+        // 3. Point lookups of random keys, the same keys for every block size
+        vector<double> latencies;
+        mt19937 random(331);
+        for (size_t i = 0; scanned && !allKeys.empty() && i < BENCHMARK_LOOKUPS; i++) {
+            string key = allKeys[random() % allKeys.size()];
+            auto lookupStart = chrono::steady_clock::now();
+            batchSearch({ key }, indexFile, [](const string&, const BlockView*, size_t) {});
+            latencies.push_back(elapsedMs(lookupStart) * 1000);
+        }
+        sort(latencies.begin(), latencies.end());
+        double meanUs = 0;
+        for (double latency : latencies) meanUs += latency;
+        if (!latencies.empty()) meanUs /= latencies.size();
+        double p99Us = latencies.empty() ? 0 : latencies[latencies.size() * 99 / 100];
+
+        long long blockBytes = fileBytes(blockFile);
+        long long scannedBytes = static_cast<long long>(blockPool.getBlockCount()) * storedBlockSize(header);
+        int blockCount = blockPool.getBlockCount();
+        closeBlockFile();
+        long long indexBytes = fileBytes(indexFile);
+        removeScratchFiles(blockFile, indexFile, header);
+        if (!scanned) {
+            cerr << "Error: Could not scan " << blockFile << endl;
+            return false;
+        }
+
+        double scanSeconds = max(scanMs, 0.001) / 1000;
+        out << setw(10) << blockSize << fixed << setprecision(1) << setw(10) << buildMs << setw(9) << blockCount
+            << setw(11) << blockBytes / 1024 << setw(11) << indexBytes / 1024 << setprecision(2)
+            << setw(12) << meanUs << setw(10) << p99Us << setprecision(1)
+            << setw(10) << scannedBytes / scanSeconds / 1e6 << setprecision(0)
+            << setw(14) << allKeys.size() / scanSeconds << setprecision(2) << setw(8) << codecStats.getRatio()
+            << setw(12) << codecStats.getDecompressMicros() << defaultfloat << setprecision(6) << "\n";
+    }
+    return true;
+}
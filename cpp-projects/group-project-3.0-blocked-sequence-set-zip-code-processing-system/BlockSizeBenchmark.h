@@ -0,0 +1,50 @@
+// CSCI 331 Group Project - Copyright © 2024 Blocked Sequence Set Zip Code Processing System
+/**
+ * @file BlockSizeBenchmark.h
+ * @brief Declaration of the block size benchmark run by `--benchmark`.
+ *
+ * For every block size the input CSV file is bulk loaded into a scratch block file
+ * ("bench_4096.dat" with index "bench_4096.idx"), which is then scanned and searched
+ * through the same code paths as the menu options and deleted again. The buffer pool
+ * gets the same number of bytes for every block size, so larger blocks get fewer frames.
+ */
+
+#ifndef BLOCK_SIZE_BENCHMARK_H
+#define BLOCK_SIZE_BENCHMARK_H
+
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+/// Point lookups timed per block size.
+const size_t BENCHMARK_LOOKUPS = 10000;
+
+/// Bytes of buffer pool frames per block size (64 frames of 512 bytes).
+const size_t BENCHMARK_POOL_BYTES = 64 * 512;
+
+/**
+ * @brief Measures bulk loads, lookups and scans over a range of block sizes.
+ *
+ * Prints one line per block size: build time, block count, block file and index file
+ * sizes, mean and 99th percentile point lookup latency (Bloom filter, index and block,
+ * as in option 5), full scan throughput with parallelScan(), and the compression ratio
+ * and mean decompression time per block of the blocks read.
+ *
+ * @param inputFile CSV file in key order to load.
+ * @param blockSizes Block sizes to measure, in bytes.
+ * @param indexSchema Index schema of the scratch files.
+ * @param fillFactor Fill factor of the loads.
+ * @param compression Codec of the loads (see findBlockCodec()); unless it is "none", each
+ *                    block takes the codec's default stored size on disk.
+ * @param workers Scan worker threads; 0 selects one per hardware thread.
+ * @param out Stream the results are printed to.
+ * @return False if a load or a scan failed.
+ *
+ * @pre No block file is open; the benchmark opens and closes its own.
+ */
+bool benchmarkBlockSizes(const std::string& inputFile, const std::vector<size_t>& blockSizes,
+                         const std::string& indexSchema, double fillFactor, const std::string& compression,
+                         unsigned workers, std::ostream& out);
+
+#endif // BLOCK_SIZE_BENCHMARK_H
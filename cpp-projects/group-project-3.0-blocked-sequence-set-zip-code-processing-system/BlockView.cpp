@@ -0,0 +1,116 @@
+// CSCI 331 Group Project - Copyright © 2024 Blocked Sequence Set Zip Code Processing System
+#include "BlockView.h"
+#include "Block.h"
+#include <cstdlib>
+#include <cstring>
+
+using namespace std;
+
+BlockView::BlockView()
+    : data(nullptr)
+    , fieldCount(0)
+    , recordCount(0)
+    , predecessorRBN(-1)
+    , successorRBN(-1)
+    , available(false) {}
+
+/**
+ * @brief Points the view at a block image and precomputes its field offsets.
+ *
+ * Walks the length-prefixed records once and records the offset and length of each
+ * comma separated field. The slice table keeps its capacity between calls.
+ *
+ * @param data Pointer to blockSize bytes of block data.
+ * @param blockSize Size of the block image in bytes.
+ * @param fieldCount Number of fields per record.
+ * @return False if the image is malformed or a record has the wrong number of fields.
+ */
+bool BlockView::reset(const char* data, size_t blockSize, size_t fieldCount) {
+    this->data = data;
+    this->fieldCount = fieldCount;
+    recordCount = 0;
+    slices.clear();
+    if (blockSize < BLOCK_HEADER_SIZE || blockSize > UINT16_MAX + 1 || fieldCount == 0) return false;
+
+    int32_t count, predecessor, successor;
+    memcpy(&count, data, 4);
+    memcpy(&predecessor, data + 4, 4);
+    memcpy(&successor, data + 8, 4);
+    predecessorRBN = predecessor;
+    successorRBN = successor;
+    available = data[12] != 0;
+
+    size_t pos = BLOCK_HEADER_SIZE;
+    for (int32_t i = 0; i < count; i++) {
+        if (pos + 2 > blockSize) return false;
+        uint16_t length;
+        memcpy(&length, data + pos, 2);
+        pos += 2;
+        size_t end = pos + length;
+        if (end > blockSize) return false;
+
+        size_t start = pos;
+        for (size_t f = 0; f < fieldCount; f++) {
+            const void* comma = f + 1 < fieldCount ? memchr(data + start, ',', end - start) : nullptr;
+            size_t stop = comma ? static_cast<const char*>(comma) - data : end;
+            if (f + 1 < fieldCount && !comma) return false;
+            slices.push_back({ static_cast<uint16_t>(start), static_cast<uint16_t>(stop - start) });
+            start = stop + 1;
+        }
+        pos = end;
+        recordCount++;
+    }
+    return true;
+}
+
+/**
+ * @brief Returns the comma separated text of one record.
+ * @param record Record number within the block, from 0.
+ * @return Slice of the block buffer holding the record text.
+ */
+string_view BlockView::record(size_t record) const {
+    const Slice& first = slices[record * fieldCount];
+    const Slice& last = slices[record * fieldCount + fieldCount - 1];
+    return string_view(data + first.offset, last.offset + last.length - first.offset);
+}
+
+/**
+ * @brief Finds the first record whose key is not less than a key.
+ * @param key Key to look for.
+ * @param keyField Field number of the primary key.
+ * @return Record number, equal to getRecordCount() if every key is smaller.
+ */
+size_t BlockView::lowerBound(string_view key, size_t keyField) const {
+    size_t low = 0, high = recordCount;
+    while (low < high) {
+        size_t mid = (low + high) / 2;
+        if (compareKeys(field(mid, keyField), key) < 0) low = mid + 1;
+        else high = mid;
+    }
+    return low;
+}
+
+/**
+ * @brief Finds a record by key with a binary search (records are in key order).
+ * @param key Key to look for.
+ * @param keyField Field number of the primary key.
+ * @return Record number, or -1 if no record has the key.
+ */
+long BlockView::find(string_view key, size_t keyField) const {
+    size_t record = lowerBound(key, keyField);
+    if (record < recordCount && field(record, keyField) == key) return static_cast<long>(record);
+    return -1;
+}
+
+/**
+ * @brief Parses a decimal field without allocating.
+ * @param text Field text such as "-72.6227".
+ * @return The value, or 0 if the text is not a number.
+ */
+double parseDouble(string_view text) {
+    char buffer[64];
+    size_t length = text.size() < sizeof(buffer) - 1 ? text.size() : sizeof(buffer) - 1;
+    memcpy(buffer, text.data(), length);
+    buffer[length] = '\0';
+    return strtod(buffer, nullptr);
+}
@@ -0,0 +1,105 @@
+// CSCI 331 Group Project - Copyright © 2024 Blocked Sequence Set Zip Code Processing System
+/**
+ * @file BlockView.h
+ * @brief Declaration of the BlockView class, a zero-copy reader over a raw block image.
+ *
+ * A BlockView does not own the block bytes. It decodes the binary block header and
+ * records where every field starts, so records and fields can be handed out as
+ * std::string_view slices of the block buffer without allocating per record.
+ */
+
+#ifndef BLOCK_VIEW_H
+#define BLOCK_VIEW_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+/**
+ * @class BlockView
+ * @brief Read-only view of the records of one block image.
+ *
+ * The view stays valid only as long as the block bytes it was reset on, e.g. while
+ * the buffer pool frame holding them is pinned. Reusing one view for many blocks
+ * reuses its field offset table, so scanning a file allocates only once.
+ */
+class BlockView {
+public:
+    BlockView();
+
+    /**
+     * @brief Points the view at a block image and precomputes its field offsets.
+     * @param data Pointer to blockSize bytes of block data.
+     * @param blockSize Size of the block image in bytes.
+     * @param fieldCount Number of fields per record.
+     * @return False if the image is malformed or a record has the wrong number of fields.
+     */
+    bool reset(const char* data, size_t blockSize, size_t fieldCount);
+
+    /**
+     * @brief Returns one field of one record.
+     * @param record Record number within the block, from 0.
+     * @param field Field number within the record, from 0.
+     * @return Slice of the block buffer holding the field text.
+     */
+    std::string_view field(size_t record, size_t field) const {
+        const Slice& slice = slices[record * fieldCount + field];
+        return std::string_view(data + slice.offset, slice.length);
+    }
+
+    /**
+     * @brief Returns the comma separated text of one record.
+     * @param record Record number within the block, from 0.
+     * @return Slice of the block buffer holding the record text.
+     */
+    std::string_view record(size_t record) const;
+
+    /**
+     * @brief Finds a record by key with a binary search (records are in key order).
+     * @param key Key to look for.
+     * @param keyField Field number of the primary key.
+     * @return Record number, or -1 if no record has the key.
+     */
+    long find(std::string_view key, size_t keyField) const;
+
+    /**
+     * @brief Finds the first record whose key is not less than a key.
+     * @param key Key to look for.
+     * @param keyField Field number of the primary key.
+     * @return Record number, equal to getRecordCount() if every key is smaller.
+     */
+    size_t lowerBound(std::string_view key, size_t keyField) const;
+
+    size_t getRecordCount() const { return recordCount; }
+    size_t getFieldCount() const { return fieldCount; }
+    int getPredecessorRBN() const { return predecessorRBN; }
+    int getSuccessorRBN() const { return successorRBN; }
+    bool isAvailable() const { return available; }
+
+private:
+    /**
+     * @brief Position of one field inside the block buffer.
+     */
+    struct Slice {
+        uint16_t offset;  ///< Offset of the first byte from the start of the block
+        uint16_t length;  ///< Length of the field in bytes
+    };
+
+    const char* data;            ///< Block image the view reads from
+    size_t fieldCount;           ///< Number of fields per record
+    size_t recordCount;          ///< Number of records in the block
+    int predecessorRBN;          ///< Predecessor RBN from the block header
+    int successorRBN;            ///< Successor RBN from the block header
+    bool available;              ///< Avail flag from the block header
+    std::vector<Slice> slices;   ///< Field positions, record after record
+};
+
+/**
+ * @brief Parses a decimal field without allocating.
+ * @param text Field text such as "-72.6227".
+ * @return The value, or 0 if the text is not a number.
+ */
+double parseDouble(std::string_view text);
+
+#endif // BLOCK_VIEW_H
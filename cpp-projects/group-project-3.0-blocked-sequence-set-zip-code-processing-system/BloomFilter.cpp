@@ -0,0 +1,190 @@
+// CSCI 331 Group Project - Copyright © 2024 Blocked Sequence Set Zip Code Processing System
+#include "BloomFilter.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+using namespace std;
+
+/// Identifies a Bloom filter file.
+static const char BLOOM_MAGIC[4] = { 'B', 'L', 'M', '1' };
+
+/// Bytes before the bit array: magic, hash count (uint32), bit count and key count (uint64).
+static const size_t BLOOM_HEADER_SIZE = 24;
+
+BloomFilter::BloomFilter()
+    : hashCount(0)
+    , keyCount(0) {}
+
+/**
+ * @brief Starts an empty filter sized for a number of keys and a false positive rate.
+ *
+ * Uses the usual optimum m = -n ln(p) / ln(2)^2 bits and k = m/n ln(2) hashes.
+ *
+ * @param expectedKeys Number of keys the filter will hold.
+ * @param falsePositiveRate Wanted probability that an absent key passes, in (0, 1).
+ */
+void BloomFilter::create(size_t expectedKeys, double falsePositiveRate) {
+    close();
+    if (!(falsePositiveRate > 0 && falsePositiveRate < 1)) falsePositiveRate = DEFAULT_BLOOM_FPR;
+    double keys = static_cast<double>(max<size_t>(expectedKeys, 1));
+    double bitCount = ceil(-keys * log(falsePositiveRate) / (log(2.0) * log(2.0)));
+    bits.assign(static_cast<size_t>(ceil(bitCount / 8)), 0);
+    hashCount = static_cast<uint32_t>(max(1.0, round(getBitCount() / keys * log(2.0))));
+}
+
+/**
+ * @brief Computes the two base hashes of a key for double hashing.
+ *
+ * FNV-1a over the key, with leading zeros of all-digit keys skipped, then a
+ * 64-bit finalizer for the second hash. Hash i is first + i * second.
+ *
+ * @param key Key to hash.
+ * @param first Receives the first base hash.
+ * @param second Receives the second base hash (odd).
+ */
+void BloomFilter::hashKey(string_view key, uint64_t& first, uint64_t& second) {
+    bool digits = !key.empty() && key.find_first_not_of("0123456789") == string_view::npos;
+    if (digits) {
+        size_t start = key.find_first_not_of('0');
+        key.remove_prefix(start == string_view::npos ? key.size() : start);
+    }
+
+    uint64_t hash = 14695981039346656037ULL;
+    for (char c : key) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ULL;
+    }
+    first = hash;
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    hash ^= hash >> 33;
+    second = hash | 1;
+}
+
+/**
+ * @brief Adds a key; a filter loaded for writing also updates its file.
+ * @param key Key to add.
+ * @return False if the file could not be updated.
+ */
+bool BloomFilter::add(string_view key) {
+    if (bits.empty()) return false;
+    uint64_t first, second, bitCount = getBitCount();
+    hashKey(key, first, second);
+    for (uint32_t i = 0; i < hashCount; i++) {
+        uint64_t bit = (first + i * second) % bitCount;
+        uint8_t mask = static_cast<uint8_t>(1u << (bit % 8));
+        if (bits[bit / 8] & mask) continue;
+        bits[bit / 8] |= mask;
+        if (file.is_open()) {
+            file.seekp(BLOOM_HEADER_SIZE + bit / 8);
+            file.put(static_cast<char>(bits[bit / 8]));
+        }
+    }
+    keyCount++;
+    if (!file.is_open()) return true;
+    file.seekp(16);
+    file.write(reinterpret_cast<const char*>(&keyCount), 8);
+    file.flush();
+    return file.good();
+}
+
+/**
+ * @brief Tests a key.
+ * @param key Key to test.
+ * @return False if the key was certainly never added; true if it may have been.
+ */
+bool BloomFilter::mayContain(string_view key) const {
+    if (bits.empty()) return true;
+    uint64_t first, second, bitCount = getBitCount();
+    hashKey(key, first, second);
+    for (uint32_t i = 0; i < hashCount; i++) {
+        uint64_t bit = (first + i * second) % bitCount;
+        if ((bits[bit / 8] & (1u << (bit % 8))) == 0) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Writes the filter to a file.
+ * @param fileName Path of the filter file.
+ * @return True if the file was written.
+ */
+bool BloomFilter::save(const string& fileName) {
+    ofstream out(fileName, ios::binary | ios::trunc);
+    if (!out.is_open()) {
+        cerr << "Error: Could not create Bloom filter file: " << fileName << endl;
+        return false;
+    }
+    char head[BLOOM_HEADER_SIZE];
+    uint64_t bitCount = getBitCount();
+    memcpy(head, BLOOM_MAGIC, 4);
+    memcpy(head + 4, &hashCount, 4);
+    memcpy(head + 8, &bitCount, 8);
+    memcpy(head + 16, &keyCount, 8);
+    out.write(head, sizeof(head));
+    out.write(reinterpret_cast<const char*>(bits.data()), bits.size());
+    return out.good();
+}
+
+/**
+ * @brief Reads a filter written by save().
+ * @param fileName Path of the filter file.
+ * @param readOnly True to read the filter without keeping the file open.
+ * @return False if the file is missing or malformed; the filter is then empty.
+ */
+bool BloomFilter::load(const string& fileName, bool readOnly) {
+    close();
+    this->fileName = fileName;
+    file.open(fileName, readOnly ? ios::in | ios::binary : ios::in | ios::out | ios::binary);
+    if (!file.is_open()) return false;
+
+    char head[BLOOM_HEADER_SIZE];
+    uint64_t bitCount;
+    if (!file.read(head, sizeof(head)) || memcmp(head, BLOOM_MAGIC, 4) != 0) {
+        cerr << "Error: " << fileName << " is not a Bloom filter file" << endl;
+        close();
+        this->fileName = fileName;
+        return false;
+    }
+    memcpy(&hashCount, head + 4, 4);
+    memcpy(&bitCount, head + 8, 8);
+    memcpy(&keyCount, head + 16, 8);
+    bits.resize(bitCount / 8);
+    if (bitCount == 0 || bitCount % 8 != 0 || hashCount == 0 ||
+        !file.read(reinterpret_cast<char*>(bits.data()), bits.size())) {
+        cerr << "Error: Bloom filter file " << fileName << " is truncated" << endl;
+        close();
+        this->fileName = fileName;
+        return false;
+    }
+    if (readOnly) file.close();
+    return true;
+}
+
+/**
+ * @brief Drops the filter, closes its file and forgets its name.
+ */
+void BloomFilter::close() {
+    if (file.is_open()) file.close();
+    file.clear();
+    fileName.clear();
+    bits.clear();
+    hashCount = 0;
+    keyCount = 0;
+}
+
+/**
+ * @brief Names the Bloom filter file of an index file ("index.idx" -> "index.bloom").
+ * @param indexName Path of the index file.
+ * @return Path of the filter file.
+ */
+string bloomFileName(const string& indexName) {
+    size_t dot = indexName.find_last_of('.');
+    size_t slash = indexName.find_last_of("/\\");
+    if (dot == string::npos || (slash != string::npos && dot < slash)) return indexName + ".bloom";
+    return indexName.substr(0, dot) + ".bloom";
+}
@@ -0,0 +1,105 @@
+// CSCI 331 Group Project - Copyright © 2024 Blocked Sequence Set Zip Code Processing System
+/**
+ * @file BloomFilter.h
+ * @brief Declaration of the BloomFilter class kept next to the primary key index.
+ *
+ * The filter answers "definitely not in the file" for most absent keys, so lookups of
+ * missing zip codes do not have to read the index or the block file. It is built
+ * together with the index and stored beside it (index.idx -> index.bloom).
+ */
+
+#ifndef BLOOM_FILTER_H
+#define BLOOM_FILTER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/// False positive rate used when none is requested.
+const double DEFAULT_BLOOM_FPR = 0.01;
+
+/**
+ * @class BloomFilter
+ * @brief Bit array with k hash functions over the primary keys of a block file.
+ *
+ * Keys are hashed in the form compareKeys() treats as equal, so "00501" and "501"
+ * hash alike. Keys cannot be removed; deleted keys only cost a false positive.
+ */
+class BloomFilter {
+public:
+    BloomFilter();
+
+    /**
+     * @brief Starts an empty filter sized for a number of keys and a false positive rate.
+     * @param expectedKeys Number of keys the filter will hold.
+     * @param falsePositiveRate Wanted probability that an absent key passes, in (0, 1).
+     */
+    void create(size_t expectedKeys, double falsePositiveRate);
+
+    /**
+     * @brief Adds a key; a filter loaded for writing also updates its file.
+     * @param key Key to add.
+     * @return False if the file could not be updated.
+     */
+    bool add(std::string_view key);
+
+    /**
+     * @brief Tests a key.
+     * @param key Key to test.
+     * @return False if the key was certainly never added; true if it may have been.
+     */
+    bool mayContain(std::string_view key) const;
+
+    /**
+     * @brief Writes the filter to a file.
+     * @param fileName Path of the filter file.
+     * @return True if the file was written.
+     */
+    bool save(const std::string& fileName);
+
+    /**
+     * @brief Reads a filter written by save().
+     *
+     * Unless readOnly is set the file stays open, so add() can update it in place.
+     *
+     * @param fileName Path of the filter file.
+     * @param readOnly True to read the filter without keeping the file open.
+     * @return False if the file is missing or malformed; the filter is then empty.
+     */
+    bool load(const std::string& fileName, bool readOnly = false);
+
+    /**
+     * @brief Drops the filter, closes its file and forgets its name.
+     */
+    void close();
+
+    bool isLoaded() const { return !bits.empty(); }
+    const std::string& getFileName() const { return fileName; }
+    uint64_t getBitCount() const { return bits.size() * 8; }
+    uint32_t getHashCount() const { return hashCount; }
+    uint64_t getKeyCount() const { return keyCount; }
+
+private:
+    /**
+     * @brief Computes the two base hashes of a key for double hashing.
+     */
+    static void hashKey(std::string_view key, uint64_t& first, uint64_t& second);
+
+    std::string fileName;        ///< Path of the filter file, empty if none
+    std::fstream file;           ///< Filter file kept open for add(), if any
+    std::vector<uint8_t> bits;   ///< Bit array, bit i in byte i / 8
+    uint32_t hashCount;          ///< Number of hash functions (k)
+    uint64_t keyCount;           ///< Number of keys added
+};
+
+/**
+ * @brief Names the Bloom filter file of an index file ("index.idx" -> "index.bloom").
+ * @param indexName Path of the index file.
+ * @return Path of the filter file.
+ */
+std::string bloomFileName(const std::string& indexName);
+
+#endif // BLOOM_FILTER_H
@@ -0,0 +1,572 @@
+// CSCI 331 Group Project - Copyright © 2024 Blocked Sequence Set Zip Code Processing System
+#include "BufferPool.h"
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+
+using namespace std;
+
+/**
+ * @brief Creates an empty buffer pool.
+ * @param frameCount Number of block frames the pool may hold (at least 1).
+ */
+BufferPool::BufferPool(size_t frameCount)
+    : blockCount(0)
+    , hits(0)
+    , misses(0)
+    , evictions(0)
+    , logging(false)
+    , committedBlockCount(0)
+    , groupCommit(DEFAULT_GROUP_COMMIT)
+    , recovered(false) {
+    setFrameCount(frameCount);
+}
+
+/**
+ * @brief Checkpoints and closes the open block file.
+ */
+BufferPool::~BufferPool() {
+    close();
+}
+
+/**
+ * @brief Opens a block file, reading its header record.
+ * @param blockFile Path to the block file.
+ * @param mapped True to map the file read-only instead of reading it into frames.
+ * @return True if the file and its header could be read.
+ */
+bool BufferPool::open(const string& blockFile, bool mapped) {
+    close();
+    recovered = false;
+    if (!header.readHeader(blockFile)) {
+        cerr << "Error: Could not read header of block file: " << blockFile << endl;
+        return false;
+    }
+    if (header.getStaleFlag() && !recover(blockFile)) {
+        return false;
+    }
+
+    if (mapped) {
+        if (!mapping.open(blockFile)) return false;
+        fileName = blockFile;
+        long long size = static_cast<long long>(mapping.getSize());
+        long long blockSize = static_cast<long long>(storedBlockSize(header));
+        if (size > header.getHeaderSize() && blockSize > 0) {
+            blockCount = static_cast<int>((size - header.getHeaderSize()) / blockSize);
+        }
+        markCommitted();
+        return loadZoneMaps();
+    }
+
+    file.open(blockFile, ios::in | ios::out | ios::binary);
+    if (!file.is_open()) {
+        cerr << "Error: Could not open block file: " << blockFile << endl;
+        return false;
+    }
+
+    fileName = blockFile;
+    blockCount = countBlocks(header, file);
+    markCommitted();
+    return loadZoneMaps();
+}
+
+/**
+ * @brief Writes back the committed images of the log of a stale block file.
+ *
+ * The images of every mutation whose commit record reached the log are written in
+ * place, which redoes in-place writes a crash may have cut short. The zone map file
+ * is deleted so open() rebuilds it from the recovered blocks. A log that cannot be
+ * replayed is kept, and the file stays stale, so the mutations it holds are not lost.
+ *
+ * @param blockFile Path to the block file.
+ * @return True if the block file is no longer stale.
+ */
+bool BufferPool::recover(const string& blockFile) {
+    fstream out(blockFile, ios::in | ios::out | ios::binary);
+    if (!out.is_open()) {
+        cerr << "Error: Could not open block file for recovery: " << blockFile << endl;
+        return false;
+    }
+    string logName = logFileName(blockFile);
+    long replayed = WriteAheadLog::replay(logName, header.getHeaderSize(), [&](int RBN, const string& image) {
+        out.seekp(RBN == 0 ? 0 : blockOffset(header, RBN));
+        out.write(image.data(), image.size());
+        return out.good();
+    });
+    out.flush();
+    if (replayed < 0 || !out.good() || !syncFile(blockFile) || !header.readHeader(blockFile)) {
+        cerr << "Error: Could not replay " << logName << " into " << blockFile << endl;
+        return false;
+    }
+
+    header.setStaleFlag(false);
+    if (!writeHeaderRegion(out, header, false) || !out.flush() || !syncFile(blockFile)) {
+        cerr << "Error: Could not clear the stale flag of " << blockFile << endl;
+        return false;
+    }
+    out.close();
+    remove(logName.c_str());
+    remove(zoneMapFileName(blockFile).c_str());
+    recovered = true;
+    cout << "Recovered " << blockFile << ": replayed " << replayed << " committed mutations from " << logName << ".\n";
+    return true;
+}
+
+/**
+ * @brief Loads the zone maps from the sidecar file, rebuilding it from the block
+ *        headers when it is missing or does not match the block file.
+ *
+ * A mapped pool rebuilds the zone maps in memory only.
+ *
+ * @return True if every zone map could be loaded.
+ */
+bool BufferPool::loadZoneMaps() {
+    string zoneFileName = zoneMapFileName(fileName);
+    if (!readZoneMapFile(zoneFileName, zoneMaps) || static_cast<int>(zoneMaps.size()) != blockCount) {
+        zoneMaps.assign(blockCount, ZoneMap());
+        vector<char> image(BLOCK_HEADER_SIZE);
+        for (int RBN = 1; RBN <= blockCount; RBN++) {
+            const char* data;
+            if (mapping.isOpen()) {
+                data = mapping.getData() + blockOffset(header, RBN);
+            } else {
+                file.clear();
+                file.seekg(blockOffset(header, RBN));
+                if (!file.read(image.data(), image.size())) {
+                    cerr << "Error: Could not read block " << RBN << " of " << fileName << endl;
+                    return false;
+                }
+                data = image.data();
+            }
+            zoneMaps[RBN - 1].decode(data + BLOCK_ZONE_MAP_OFFSET);
+        }
+        if (!mapping.isOpen() && !writeZoneMapFile(zoneFileName, zoneMaps)) return false;
+    }
+
+    if (!mapping.isOpen()) {
+        zoneFile.open(zoneFileName, ios::in | ios::out | ios::binary);
+        if (!zoneFile.is_open()) {
+            cerr << "Error: Could not open zone map file: " << zoneFileName << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Updates the zone map of one block in memory and in the sidecar file.
+ * @param RBN Relative Block Number of the block.
+ * @param image Block image the zone map is read from.
+ * @return True if the sidecar file was updated.
+ */
+bool BufferPool::storeZoneMap(int RBN, const char* image) {
+    if (RBN > static_cast<int>(zoneMaps.size())) zoneMaps.resize(RBN);
+    zoneMaps[RBN - 1].decode(image + BLOCK_ZONE_MAP_OFFSET);
+
+    zoneFile.clear();
+    zoneFile.seekp(ZONE_FILE_HEADER_SIZE + static_cast<long long>(RBN - 1) * ZONE_MAP_SIZE);
+    zoneFile.write(image + BLOCK_ZONE_MAP_OFFSET, ZONE_MAP_SIZE);
+    int32_t count = static_cast<int32_t>(zoneMaps.size());
+    zoneFile.seekp(4);
+    zoneFile.write(reinterpret_cast<const char*>(&count), 4);
+    zoneFile.flush();
+    return zoneFile.good();
+}
+
+/**
+ * @brief Checkpoints and closes the block file and drops every frame.
+ */
+void BufferPool::close() {
+    // A failed checkpoint leaves the file stale and its log on disk for the next open()
+    if (logging) checkpoint();
+    logging = false;
+    if (file.is_open()) file.close();
+    if (zoneFile.is_open()) zoneFile.close();
+    zoneFile.clear();
+    zoneMaps.clear();
+    mapping.close();
+    file.clear();
+    fileName.clear();
+    blockCount = 0;
+    setFrameCount(frames.size());
+}
+
+/**
+ * @brief Changes the number of frames, dropping every cached frame.
+ * @param frameCount New number of frames (at least 1).
+ */
+void BufferPool::setFrameCount(size_t frameCount) {
+    if (frameCount == 0) frameCount = 1;
+
+    frames.assign(frameCount, Frame());
+    lruList.clear();
+    frameOf.clear();
+    for (size_t i = 0; i < frames.size(); i++) {
+        frames[i].RBN = -1;
+        frames[i].pinCount = 0;
+        frames[i].lru = lruList.insert(lruList.end(), i);
+    }
+}
+
+/**
+ * @brief Marks a frame as the most recently used one.
+ * @param index Frame index.
+ */
+void BufferPool::touch(size_t index) {
+    lruList.splice(lruList.begin(), lruList, frames[index].lru);
+}
+
+/**
+ * @brief Finds the frame for a block, loading it on a miss.
+ *
+ * On a miss the least recently used frame without pins is reused; empty frames
+ * sit at the end of the LRU list and are taken first.
+ *
+ * @param RBN Relative Block Number of the block.
+ * @param load False to claim a frame without reading the file.
+ * @return Frame index, or -1 if the block cannot be cached.
+ */
+long BufferPool::findFrame(int RBN, bool load) {
+    if (!isOpen() || RBN < 1 || (load && RBN > blockCount)) return -1;
+
+    auto cached = frameOf.find(RBN);
+    if (cached != frameOf.end()) {
+        hits++;
+        touch(cached->second);
+        return static_cast<long>(cached->second);
+    }
+
+    // Pick the least recently used frame that nobody has pinned
+    auto victim = lruList.end();
+    for (auto it = lruList.rbegin(); it != lruList.rend(); ++it) {
+        if (frames[*it].pinCount == 0) {
+            victim = prev(it.base());
+            break;
+        }
+    }
+    if (victim == lruList.end()) {
+        cerr << "Error: Every buffer pool frame is pinned" << endl;
+        return -1;
+    }
+
+    size_t index = *victim;
+    Frame& frame = frames[index];
+    if (frame.RBN != -1) {
+        evictions++;
+        frameOf.erase(frame.RBN);
+        frame.RBN = -1;
+    }
+
+    frame.data.resize(header.getBlockSize());
+    auto pending = staged.find(RBN);
+    const char* stored = nullptr;
+    if (load && pending != staged.end()) {
+        // Not written in place yet
+        misses++;
+        stored = pending->second.data();
+    } else if (load && mapping.isOpen()) {
+        misses++;
+        stored = mapping.getData() + blockOffset(header, RBN);
+    } else if (load) {
+        misses++;
+        bool compressed = header.getCompressedBlockSize() > 0;
+        storedImage.resize(storedBlockSize(header));
+        file.clear();
+        file.seekg(blockOffset(header, RBN));
+        if (!file.read(compressed ? storedImage.data() : frame.data.data(), storedImage.size())) {
+            cerr << "Error: Could not read block " << RBN << " of " << fileName << endl;
+            return -1;
+        }
+        if (compressed) stored = storedImage.data();
+    }
+    if (stored != nullptr && !expandBlock(header, stored, frame.data.data())) {
+        cerr << "Error: Block " << RBN << " of " << fileName << " could not be decompressed" << endl;
+        return -1;
+    }
+
+    frame.RBN = RBN;
+    frameOf[RBN] = index;
+    touch(index);
+    return static_cast<long>(index);
+}
+
+/**
+ * @brief Pins a block in a frame, reading it from the file on a miss.
+ * @param RBN Relative Block Number of the block.
+ * @return Pointer to the blockSize bytes of the block image, or nullptr on failure.
+ */
+const char* BufferPool::pin(int RBN) {
+    if (mapping.isOpen() && header.getCompressedBlockSize() <= 0) {
+        if (RBN < 1 || RBN > blockCount) return nullptr;
+        hits++;
+        return mapping.getData() + blockOffset(header, RBN);
+    }
+    long index = findFrame(RBN, true);
+    if (index < 0) return nullptr;
+    frames[index].pinCount++;
+    return frames[index].data.data();
+}
+
+/**
+ * @brief Releases a pin taken with pin().
+ *
+ * Mapped blocks of an uncompressed file are never evicted, so there is nothing to
+ * release for them.
+ *
+ * @param RBN Relative Block Number of the block.
+ */
+void BufferPool::unpin(int RBN) {
+    auto cached = frameOf.find(RBN);
+    if (cached != frameOf.end() && frames[cached->second].pinCount > 0) {
+        frames[cached->second].pinCount--;
+    }
+}
+
+/**
+ * @brief Reads a block through the pool and decodes it.
+ * @param RBN Relative Block Number of the block.
+ * @param block Receives the decoded block.
+ * @return True if the block exists and could be decoded.
+ */
+bool BufferPool::getBlock(int RBN, Block& block) {
+    const char* data = pin(RBN);
+    if (data == nullptr) return false;
+    bool decoded = unpackBlock(data, header.getBlockSize(), RBN, block);
+    unpin(RBN);
+    return decoded;
+}
+
+/**
+ * @brief Writes a block through the pool into its frame and the redo log.
+ * @param block Block to write; its RBN selects the slot.
+ * @return True if the block was logged.
+ */
+bool BufferPool::putBlock(const Block& block) {
+    if (mapping.isOpen()) {
+        cerr << "Error: " << fileName << " is open read-only" << endl;
+        return false;
+    }
+    string image, stored;
+    if (!packBlock(block, header, image) || !compressBlock(header, image, stored)) {
+        cerr << "Error: Block " << block.RBN << " does not fit in " << storedBlockSize(header) << " bytes" << endl;
+        return false;
+    }
+    if (block.RBN < 1 || block.RBN > blockCount + 1 || !beginLogging()) return false;
+
+    if (uncommitted.find(block.RBN) == uncommitted.end()) {
+        auto pending = staged.find(block.RBN);
+        uncommitted[block.RBN] = pending != staged.end() ? pending->second : string();
+    }
+    long index = findFrame(block.RBN, false);
+    if (index >= 0) {
+        memcpy(frames[index].data.data(), image.data(), image.size());
+    }
+
+    log.append(block.RBN, stored);
+    if (block.RBN > blockCount) blockCount = block.RBN;
+    if (!storeZoneMap(block.RBN, image.data())) {
+        cerr << "Error: Could not update the zone map of block " << block.RBN << endl;
+        return false;
+    }
+    staged[block.RBN] = move(stored);
+    return true;
+}
+
+/**
+ * @brief Logs the header record of the open file, staged like putBlock().
+ * @return True if the header was logged.
+ */
+bool BufferPool::writeHeader() {
+    if (mapping.isOpen()) {
+        cerr << "Error: " << fileName << " is open read-only" << endl;
+        return false;
+    }
+    if (!file.is_open() || !beginLogging()) return false;
+    ostringstream image;
+    if (!writeHeaderRegion(image, header, false)) return false;
+    stagedHeader = image.str();
+    log.append(0, stagedHeader);
+    return true;
+}
+
+/**
+ * @brief Marks the header record stale on disk and starts a new log, before the
+ *        first write since the file was opened or checkpointed.
+ *
+ * The stale flag reaches the disk before any image is written in place, so a crash
+ * from here until checkpoint() leaves a file that open() recovers.
+ *
+ * @return True if the header and the empty log are on disk.
+ */
+bool BufferPool::beginLogging() {
+    if (logging) return true;
+
+    // The header in memory may already hold changes of the mutation under way, which
+    // must only reach the file through the log, so the header on disk is marked instead
+    HeaderRecord written;
+    file.flush();
+    bool marked = written.readHeader(fileName);
+    written.setStaleFlag(true);
+    header.setStaleFlag(true);
+    file.clear();
+    marked = marked && writeHeaderRegion(file, written, false) && file.flush() && syncFile(fileName);
+    if (!marked || !log.open(logFileName(fileName), static_cast<int>(storedBlockSize(header)), header.getHeaderSize())) {
+        cerr << "Error: Could not start the log of " << fileName << endl;
+        return false;
+    }
+    logging = true;
+    return true;
+}
+
+/**
+ * @brief Ends a mutation: logs a commit record for the writes made since the last one.
+ *
+ * Once the group commit size of mutations is pending, flush() runs, and once the log
+ * has grown past LOG_CHECKPOINT_BYTES, checkpoint() starts it over.
+ *
+ * @return True unless a flush or checkpoint failed.
+ */
+bool BufferPool::commit() {
+    markCommitted();
+    if (!logging) return true;
+    log.commit();
+    if (log.getPendingCommits() < groupCommit) return true;
+    if (!flush()) return false;
+    return log.getFileSize() < LOG_CHECKPOINT_BYTES || checkpoint();
+}
+
+/**
+ * @brief Drops the writes of a mutation that failed partway, instead of committing them.
+ *
+ * A block keeps its staged image from an earlier mutation, or else the image in the
+ * file; either is what findFrame() reads once its frame is dropped. Blocks appended
+ * by the mutation are forgotten.
+ *
+ * @return True if blocks had been written since the last commit.
+ */
+bool BufferPool::rollback() {
+    bool written = !uncommitted.empty();
+    for (const auto& write : uncommitted) {
+        auto cached = frameOf.find(write.first);
+        if (cached != frameOf.end()) {
+            frames[cached->second].RBN = -1;
+            lruList.splice(lruList.end(), lruList, frames[cached->second].lru);
+            frameOf.erase(cached);
+        }
+        if (write.second.empty()) staged.erase(write.first);
+        else staged[write.first] = write.second;
+    }
+
+    blockCount = committedBlockCount;
+    if (static_cast<int>(zoneMaps.size()) > blockCount) zoneMaps.resize(blockCount);
+    for (const auto& write : uncommitted) {
+        long index = write.first <= blockCount ? findFrame(write.first, true) : -1;
+        if (index >= 0) storeZoneMap(write.first, frames[index].data.data());
+    }
+
+    bool stale = header.getStaleFlag();
+    header = committedHeader;
+    header.setStaleFlag(stale);
+    stagedHeader = committedStagedHeader;
+    log.rollback();
+    uncommitted.clear();
+    return written;
+}
+
+/**
+ * @brief Syncs the log, then writes every staged image in place.
+ *
+ * Writes not yet closed by commit() are committed first. Images go out in RBN order;
+ * the block file itself is only synced by checkpoint(), since the log can redo them.
+ *
+ * @return True if the log was synced and the images were written.
+ */
+bool BufferPool::flush() {
+    if (!logging) return true;
+    log.commit();
+    if (!log.sync()) return false;
+
+    file.clear();
+    for (const auto& image : staged) {
+        file.seekp(blockOffset(header, image.first));
+        file.write(image.second.data(), image.second.size());
+    }
+    if (!stagedHeader.empty()) {
+        file.seekp(0);
+        file.write(stagedHeader.data(), stagedHeader.size());
+    }
+    file.flush();
+    if (!file.good()) {
+        cerr << "Error: Could not write the logged blocks of " << fileName << endl;
+        return false;
+    }
+    staged.clear();
+    stagedHeader.clear();
+    markCommitted();
+    return true;
+}
+
+/**
+ * @brief Flushes, syncs the block file, clears the stale flag and deletes the log.
+ * @return True if the block file is complete without its log.
+ */
+bool BufferPool::checkpoint() {
+    if (!logging) return true;
+    if (!flush() || !syncFile(fileName)) return false;
+    if (checkpointHook && !checkpointHook()) return false;
+    header.setStaleFlag(false);
+    file.clear();
+    if (!writeHeaderRegion(file, header, false) || !file.flush() || !syncFile(fileName)) {
+        cerr << "Error: Could not clear the stale flag of " << fileName << endl;
+        return false;
+    }
+    log.remove();
+    logging = false;
+    return true;
+}
+
+/**
+ * @brief Remembers the header record and the block count as the state rollback()
+ *        returns to, once the writes before it are committed.
+ */
+void BufferPool::markCommitted() {
+    uncommitted.clear();
+    committedHeader = header;
+    committedStagedHeader = stagedHeader;
+    committedBlockCount = blockCount;
+}
+
+/**
+ * @brief Resets the hit, miss and eviction counters.
+ */
+void BufferPool::resetStats() {
+    hits = 0;
+    misses = 0;
+    evictions = 0;
+    codecStats.reset();
+}
+
+/**
+ * @brief Prints the frame count and the hit, miss and eviction counters.
+ * @param out Stream to print to.
+ */
+void BufferPool::printStats(ostream& out) const {
+    unsigned long long requests = hits + misses;
+    if (header.getCompressedBlockSize() > 0) {
+        out << "Compressed with " << header.getCompression() << ": " << header.getBlockSize() << " byte blocks in "
+            << header.getCompressedBlockSize() << " bytes on disk, ";
+        codecStats.print(out);
+    }
+    if (mapping.isOpen() && header.getCompressedBlockSize() <= 0) {
+        out << "Mapped read-only: " << mapping.getSize() << " bytes, Block reads: " << hits << "\n";
+        return;
+    }
+    out << "Frames: " << frames.size()
+        << ", Hits: " << hits
+        << ", Misses: " << misses
+        << ", Evictions: " << evictions
+        << ", Hit rate: " << (requests ? 100.0 * hits / requests : 0.0) << "%\n";
+    out << "Log: " << log.getCommits() << " commits, " << log.getSyncs() << " syncs (group commit of "
+        << groupCommit << ")\n";
+}
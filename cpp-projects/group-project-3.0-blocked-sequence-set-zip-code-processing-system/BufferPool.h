@@ -0,0 +1,306 @@
+// CSCI 331 Group Project - Copyright © 2024 Blocked Sequence Set Zip Code Processing System
+/**
+ * @file BufferPool.h
+ * @brief Declaration of the BufferPool class that caches fixed-size blocks of a block file.
+ *
+ * Blocks are read on demand into a fixed number of frames. When every frame is in use,
+ * the least recently used unpinned frame is evicted. Hit, miss and eviction counters
+ * are kept so the frame count can be sized for a workload.
+ *
+ * The pool also keeps the zone map of every block in memory, loaded from the sidecar
+ * file at open and kept in step with it by putBlock().
+ *
+ * A pool can instead be opened read-only on a memory mapping of the block file; pins
+ * then point straight into the mapped pages and no frames are used.
+ *
+ * Frames always hold block images of the full block size. The blocks of a compressed
+ * file (see compressBlock()) are decompressed as they are read into a frame, from the
+ * file, the mapping or the staged images alike, and the log and the staged images hold
+ * the compressed images that are written in place.
+ *
+ * Writes go through a redo log (see WriteAheadLog): putBlock() and writeHeader() log
+ * the new image and keep it staged in memory, and staged images are written in place
+ * only after the log holding them has been synced. The header record is marked stale
+ * before the first in-place write and unmarked by checkpoint(); opening a stale file
+ * replays its log first.
+ */
+
+#ifndef BUFFER_POOL_H
+#define BUFFER_POOL_H
+
+#include <cstddef>
+#include <fstream>
+#include <functional>
+#include <list>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "Block.h"
+#include "HeaderRecord.h"
+#include "MappedFile.h"
+#include "WriteAheadLog.h"
+#include "ZoneMap.h"
+
+/// Number of frames used when no frame count is requested.
+const size_t DEFAULT_POOL_FRAMES = 64;
+
+/**
+ * @class BufferPool
+ * @brief Fixed-size cache of block images with LRU eviction.
+ *
+ * Callers either copy a decoded block out with getBlock(), or pin a frame with pin(),
+ * read the raw block image it returns and release it with unpin(). A pinned frame is
+ * never evicted. Writes go through putBlock(), which updates the frame and the file.
+ */
+class BufferPool {
+public:
+    /**
+     * @brief Creates an empty buffer pool.
+     * @param frameCount Number of block frames the pool may hold (at least 1).
+     */
+    explicit BufferPool(size_t frameCount = DEFAULT_POOL_FRAMES);
+
+    /**
+     * @brief Checkpoints and closes the open block file.
+     */
+    ~BufferPool();
+
+    /**
+     * @brief Opens a block file, reading its header record.
+     *
+     * Any previously opened file is closed and all frames are dropped. A mapped pool
+     * is read-only: putBlock() and writeHeader() fail, and pin() returns a pointer into
+     * the mapping that stays valid until the pool is closed.
+     *
+     * A file whose header record is stale was not checkpointed; the committed images
+     * of its log are written back first and its zone map file is rebuilt.
+     *
+     * @param blockFile Path to the block file.
+     * @param mapped True to map the file read-only instead of reading it into frames.
+     * @return True if the file and its header could be read.
+     */
+    bool open(const std::string& blockFile, bool mapped = false);
+
+    /**
+     * @brief Checkpoints and closes the block file and drops every frame.
+     */
+    void close();
+
+    /**
+     * @brief Changes the number of frames, dropping every cached frame.
+     * @param frameCount New number of frames (at least 1).
+     */
+    void setFrameCount(size_t frameCount);
+
+    /**
+     * @brief Pins a block in a frame, reading it from the file on a miss.
+     * @param RBN Relative Block Number of the block.
+     * @return Pointer to the blockSize bytes of the block image, or nullptr on failure.
+     */
+    const char* pin(int RBN);
+
+    /**
+     * @brief Releases a pin taken with pin().
+     * @param RBN Relative Block Number of the block.
+     */
+    void unpin(int RBN);
+
+    /**
+     * @brief Reads a block through the pool and decodes it.
+     * @param RBN Relative Block Number of the block.
+     * @param block Receives the decoded block.
+     * @return True if the block exists and could be decoded.
+     */
+    bool getBlock(int RBN, Block& block);
+
+    /**
+     * @brief Writes a block through the pool into its frame and the redo log.
+     *
+     * The image is staged until the next flush() writes it in place. Writing one past
+     * the last block extends the file.
+     *
+     * @param block Block to write; its RBN selects the slot.
+     * @return True if the block was logged.
+     */
+    bool putBlock(const Block& block);
+
+    /**
+     * @brief Returns the zone map of a block without reading the block.
+     * @param RBN Relative Block Number of the block.
+     * @return Zone map, or nullptr if there is no such block.
+     */
+    const ZoneMap* getZoneMap(int RBN) const {
+        return RBN >= 1 && RBN <= static_cast<int>(zoneMaps.size()) ? &zoneMaps[RBN - 1] : nullptr;
+    }
+
+    /**
+     * @brief Logs the header record of the open file, staged like putBlock().
+     * @return True if the header was logged.
+     */
+    bool writeHeader();
+
+    /**
+     * @brief Ends a mutation: logs a commit record for the writes made since the last one.
+     *
+     * Once the group commit size of mutations is pending, flush() runs, and once the
+     * log has grown past LOG_CHECKPOINT_BYTES, checkpoint() starts it over.
+     *
+     * @return True unless a flush or checkpoint failed.
+     */
+    bool commit();
+
+    /**
+     * @brief Drops the writes of a mutation that failed partway, instead of committing them.
+     *
+     * The blocks written since the last commit() get back their committed images, in
+     * the frames and zone maps too, the header record in memory gets back its committed
+     * fields and the uncommitted images are dropped from the log.
+     *
+     * @return True if blocks had been written since the last commit.
+     */
+    bool rollback();
+
+    /**
+     * @brief Syncs the log, then writes every staged image in place.
+     *
+     * Writes not yet closed by commit() are committed first.
+     *
+     * @return True if the log was synced and the images were written.
+     */
+    bool flush();
+
+    /**
+     * @brief Flushes, syncs the block file, clears the stale flag and deletes the log.
+     *
+     * The checkpoint hook runs before the flag is cleared, so files derived from the
+     * block file are written while a crash would still rebuild them.
+     *
+     * @return True if the block file is complete without its log.
+     */
+    bool checkpoint();
+
+    /**
+     * @brief Sets a function checkpoint() runs before it clears the stale flag.
+     * @param hook Function returning false to fail the checkpoint (empty for none).
+     */
+    void setCheckpointHook(std::function<bool()> hook) { checkpointHook = std::move(hook); }
+
+    /**
+     * @brief Sets the number of mutations grouped into one log sync.
+     * @param mutations Mutations per sync (at least 1; 1 syncs every mutation).
+     */
+    void setGroupCommit(size_t mutations) { groupCommit = mutations == 0 ? 1 : mutations; }
+
+    /**
+     * @brief Resets the hit, miss and eviction counters.
+     */
+    void resetStats();
+
+    /**
+     * @brief Prints the frame count and the hit, miss and eviction counters.
+     * @param out Stream to print to.
+     */
+    void printStats(std::ostream& out) const;
+
+    bool isOpen() const { return file.is_open() || mapping.isOpen(); }
+    bool isMapped() const { return mapping.isOpen(); }
+    bool wasRecovered() const { return recovered; }
+    const std::string& getFileName() const { return fileName; }
+    const HeaderRecord& getHeader() const { return header; }
+    HeaderRecord& getHeader() { return header; }
+    int getBlockCount() const { return blockCount; }
+    size_t getFrameCount() const { return frames.size(); }
+    unsigned long long getHits() const { return hits; }
+    unsigned long long getMisses() const { return misses; }
+    unsigned long long getEvictions() const { return evictions; }
+
+private:
+    /**
+     * @brief One cached block image.
+     */
+    struct Frame {
+        int RBN;                          ///< Block held by the frame, -1 if empty
+        int pinCount;                     ///< Number of outstanding pins
+        std::vector<char> data;           ///< Block image, blockSize bytes
+        std::list<size_t>::iterator lru;  ///< Position in the LRU list
+    };
+
+    /**
+     * @brief Finds the frame for a block, loading it on a miss.
+     * @param RBN Relative Block Number of the block.
+     * @param load False to claim a frame without reading the file.
+     * @return Frame index, or -1 if the block cannot be cached.
+     */
+    long findFrame(int RBN, bool load);
+
+    /**
+     * @brief Loads the zone maps from the sidecar file, rebuilding it from the block
+     *        headers when it is missing or does not match the block file.
+     * @return True if every zone map could be loaded.
+     */
+    bool loadZoneMaps();
+
+    /**
+     * @brief Updates the zone map of one block in memory and in the sidecar file.
+     * @param RBN Relative Block Number of the block.
+     * @param image Block image the zone map is read from.
+     * @return True if the sidecar file was updated.
+     */
+    bool storeZoneMap(int RBN, const char* image);
+
+    /**
+     * @brief Marks the header record stale on disk and starts a new log, before the
+     *        first write since the file was opened or checkpointed.
+     * @return True if the header and the empty log are on disk.
+     */
+    bool beginLogging();
+
+    /**
+     * @brief Writes back the committed images of the log of a stale block file.
+     * @param blockFile Path to the block file.
+     * @return True if the block file is no longer stale.
+     */
+    bool recover(const std::string& blockFile);
+
+    /**
+     * @brief Marks a frame as the most recently used one.
+     * @param index Frame index.
+     */
+    void touch(size_t index);
+
+    /**
+     * @brief Remembers the header record and the block count as the state rollback()
+     *        returns to, once the writes before it are committed.
+     */
+    void markCommitted();
+
+    std::string fileName;                       ///< Path of the open block file
+    std::fstream file;                          ///< Open block file
+    MappedFile mapping;                         ///< Read-only mapping of the block file, if mapped
+    std::fstream zoneFile;                      ///< Open sidecar zone map file (not when mapped)
+    std::vector<ZoneMap> zoneMaps;              ///< Zone map per block, RBN 1 first
+    HeaderRecord header;                        ///< Header record of the open block file
+    int blockCount;                             ///< Number of blocks in the file
+    std::vector<Frame> frames;                  ///< Frame table
+    std::list<size_t> lruList;                  ///< Frame indices, most recently used first
+    std::unordered_map<int, size_t> frameOf;    ///< RBN to frame index for cached blocks
+    unsigned long long hits;                    ///< Requests served from a frame
+    unsigned long long misses;                  ///< Requests that read the file
+    unsigned long long evictions;               ///< Cached blocks dropped to make room
+    WriteAheadLog log;                          ///< Redo log of the writes since the last checkpoint
+    bool logging;                               ///< True once the header is marked stale and the log started
+    std::map<int, std::string> staged;          ///< Logged stored images not yet written in place, by RBN
+    std::vector<char> storedImage;              ///< Read buffer for one compressed block
+    std::string stagedHeader;                   ///< Logged header region not yet written in place
+    std::map<int, std::string> uncommitted;     ///< Staged image each block written since the last commit replaced ("" if none)
+    HeaderRecord committedHeader;               ///< Header record as of the last commit
+    std::string committedStagedHeader;          ///< stagedHeader as of the last commit
+    int committedBlockCount;                    ///< blockCount as of the last commit
+    size_t groupCommit;                         ///< Mutations per log sync
+    std::function<bool()> checkpointHook;       ///< Run by checkpoint() before the stale flag is cleared
+    bool recovered;                             ///< True if open() replayed a log
+};
+
+#endif // BUFFER_POOL_H
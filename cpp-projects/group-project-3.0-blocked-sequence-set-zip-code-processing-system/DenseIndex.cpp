@@ -0,0 +1,243 @@
+// CSCI 331 Group Project - Copyright © 2024 Blocked Sequence Set Zip Code Processing System
+#include "DenseIndex.h"
+#include <cstring>
+#include <iostream>
+
+using namespace std;
+
+/// Identifies an index file written by DenseIndex.
+static const char DENSE_MAGIC[4] = { 'D', 'I', 'X', '1' };
+
+/// Bytes before the first slot of a dense index file.
+static const size_t DENSE_HEADER_SIZE = 16;
+
+DenseIndex::DenseIndex()
+    : slots(nullptr)
+    , entryCount(0) {}
+
+/**
+ * @brief Returns the dense index slot of a key.
+ * @param key Key such as "501" or "00501".
+ * @return Slot number, or -1 if the key is not a zip code below DENSE_INDEX_SLOTS.
+ */
+int denseSlot(const string& key) {
+    if (key.empty()) return -1;
+    long value = 0;
+    for (char c : key) {
+        if (c < '0' || c > '9') return -1;
+        value = value * 10 + (c - '0');
+        if (value >= DENSE_INDEX_SLOTS) return -1;
+    }
+    return static_cast<int>(value);
+}
+
+/**
+ * @brief Reads one slot.
+ * @param slot Slot number.
+ * @return RBN stored in the slot, -1 if absent.
+ */
+int32_t DenseIndex::slotValue(int slot) const {
+    int32_t RBN;
+    memcpy(&RBN, slots + static_cast<size_t>(slot) * 4, 4);
+    return RBN;
+}
+
+/**
+ * @brief Builds a new index file in one pass over the entries.
+ * @param fileName Path of the index file to create.
+ * @param entries Key and RBN pairs; every key must be a zip code.
+ * @param pageSize Unused; the file has no pages.
+ * @return True if the index was written; it is left open on the new file.
+ */
+bool DenseIndex::build(const string& fileName, const vector<pair<string, int>>& entries, int) {
+    close();
+    vector<int32_t> table(DENSE_INDEX_SLOTS, -1);
+    int count = 0;
+    for (const auto& entry : entries) {
+        int slot = denseSlot(entry.first);
+        if (slot < 0) {
+            cerr << "Error: Key " << entry.first << " is not a 5-digit zip code" << endl;
+            return false;
+        }
+        if (table[slot] == -1) count++;
+        table[slot] = entry.second;
+    }
+
+    ofstream out(fileName, ios::binary | ios::trunc);
+    if (!out.is_open()) {
+        cerr << "Error: Could not create index file: " << fileName << endl;
+        return false;
+    }
+    char head[DENSE_HEADER_SIZE] = {};
+    int32_t slotCount = DENSE_INDEX_SLOTS, entries32 = count;
+    memcpy(head, DENSE_MAGIC, 4);
+    memcpy(head + 4, &slotCount, 4);
+    memcpy(head + 8, &entries32, 4);
+    out.write(head, sizeof(head));
+    out.write(reinterpret_cast<const char*>(table.data()), table.size() * 4);
+    out.close();
+    if (!out) {
+        cerr << "Error: Could not write index file: " << fileName << endl;
+        return false;
+    }
+    return open(fileName);
+}
+
+/**
+ * @brief Opens an existing index file, reading the slots or mapping them read-only.
+ * @param fileName Path of the index file.
+ * @param mapped True to map the file read-only; insert() and erase() then fail.
+ * @return True if the file holds a dense index.
+ */
+bool DenseIndex::open(const string& fileName, bool mapped) {
+    close();
+    size_t size = DENSE_HEADER_SIZE + static_cast<size_t>(DENSE_INDEX_SLOTS) * 4;
+    const char* data;
+    if (mapped) {
+        if (!mapping.open(fileName)) return false;
+        data = mapping.getSize() >= size ? mapping.getData() : nullptr;
+    } else {
+        file.open(fileName, ios::in | ios::out | ios::binary);
+        if (!file.is_open()) {
+            cerr << "Error: Could not open index file: " << fileName << endl;
+            return false;
+        }
+        loaded.resize(size / 4);
+        data = file.read(reinterpret_cast<char*>(loaded.data()), size) ? reinterpret_cast<const char*>(loaded.data()) : nullptr;
+    }
+
+    int32_t slotCount = 0, count = 0;
+    if (data != nullptr) {
+        memcpy(&slotCount, data + 4, 4);
+        memcpy(&count, data + 8, 4);
+    }
+    if (data == nullptr || memcmp(data, DENSE_MAGIC, 4) != 0 || slotCount != DENSE_INDEX_SLOTS) {
+        cerr << "Error: " << fileName << " is not a dense zip code index file" << endl;
+        close();
+        return false;
+    }
+
+    this->fileName = fileName;
+    slots = data + DENSE_HEADER_SIZE;
+    entryCount = count;
+    return true;
+}
+
+/**
+ * @brief Closes the index file.
+ */
+void DenseIndex::close() {
+    if (file.is_open()) file.close();
+    file.clear();
+    mapping.close();
+    loaded.clear();
+    fileName.clear();
+    slots = nullptr;
+    entryCount = 0;
+}
+
+/**
+ * @brief Looks up the RBN stored for a key with one array load.
+ * @param key Key to look up.
+ * @return RBN of the block holding the key, or -1 if the key is not indexed.
+ */
+int DenseIndex::find(const string& key) {
+    int slot = denseSlot(key);
+    if (!isOpen() || slot < 0) return -1;
+    return slotValue(slot);
+}
+
+/**
+ * @brief Finds the largest indexed zip code.
+ * @param key Receives the largest zip code.
+ * @param RBN Receives the RBN stored for it.
+ * @return False if the index is empty.
+ */
+bool DenseIndex::last(string& key, int& RBN) {
+    if (!isOpen()) return false;
+    for (int slot = DENSE_INDEX_SLOTS - 1; slot >= 0; slot--) {
+        if (slotValue(slot) != -1) {
+            key = to_string(slot);
+            RBN = slotValue(slot);
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Writes one slot and the entry count through to the index file.
+ * @param slot Slot number.
+ * @return True if the file was updated.
+ */
+bool DenseIndex::writeSlot(int slot) {
+    int32_t count = entryCount;
+    file.clear();
+    file.seekp(DENSE_HEADER_SIZE + static_cast<long long>(slot) * 4);
+    file.write(slots + static_cast<size_t>(slot) * 4, 4);
+    file.seekp(8);
+    file.write(reinterpret_cast<const char*>(&count), 4);
+    file.flush();
+    return file.good();
+}
+
+/**
+ * @brief Inserts a zip code, or replaces the RBN of one that is already indexed.
+ * @param key Key to insert.
+ * @param RBN Relative Block Number of the block holding the key.
+ * @return True if the index was updated.
+ */
+bool DenseIndex::insert(const string& key, int RBN) {
+    if (!isOpen()) return false;
+    if (mapping.isOpen()) {
+        cerr << "Error: " << fileName << " is open read-only" << endl;
+        return false;
+    }
+    int slot = denseSlot(key);
+    if (slot < 0) {
+        cerr << "Error: Key " << key << " cannot be indexed" << endl;
+        return false;
+    }
+    if (loaded[DENSE_HEADER_SIZE / 4 + slot] == -1) entryCount++;
+    loaded[DENSE_HEADER_SIZE / 4 + slot] = RBN;
+    return writeSlot(slot);
+}
+
+/**
+ * @brief Removes a zip code.
+ * @param key Key to remove.
+ * @return True if the key was indexed and has been removed.
+ */
+bool DenseIndex::erase(const string& key) {
+    if (!isOpen()) return false;
+    if (mapping.isOpen()) {
+        cerr << "Error: " << fileName << " is open read-only" << endl;
+        return false;
+    }
+    int slot = denseSlot(key);
+    if (slot < 0 || loaded[DENSE_HEADER_SIZE / 4 + slot] == -1) return false;
+    loaded[DENSE_HEADER_SIZE / 4 + slot] = -1;
+    entryCount--;
+    return writeSlot(slot);
+}
+
+/**
+ * @brief Visits zip codes in ascending order starting at the first one not less than low.
+ * @param low Smallest key to visit; keys that are not zip codes visit nothing.
+ * @param visit Called with each zip code and RBN; return false to stop the scan.
+ */
+void DenseIndex::scan(const string& low, const function<bool(const string&, int)>& visit) {
+    int slot = denseSlot(low);
+    if (!isOpen() || slot < 0) return;
+    for (; slot < DENSE_INDEX_SLOTS; slot++) {
+        int32_t RBN = slotValue(slot);
+        if (RBN != -1 && !visit(to_string(slot), RBN)) return;
+    }
+}
+
+/**
+ * @brief Describes the index, e.g. "direct-address table of 100000 slots".
+ */
+string DenseIndex::describe() const {
+    return "direct-address table of " + to_string(DENSE_INDEX_SLOTS) + " slots";
+}
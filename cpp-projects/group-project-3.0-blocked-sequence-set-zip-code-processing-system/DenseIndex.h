@@ -0,0 +1,74 @@
+// CSCI 331 Group Project - Copyright © 2024 Blocked Sequence Set Zip Code Processing System
+/**
+ * @file DenseIndex.h
+ * @brief Declaration of the DenseIndex class, a direct-address index for 5-digit zip codes.
+ *
+ * The index file is a 16-byte header (magic "DIX1", slot count, entry count, reserved)
+ * followed by one int32 RBN per possible zip code 00000-99999, -1 for absent zip codes.
+ * Looking a zip code up is a single array load.
+ */
+
+#ifndef DENSE_INDEX_H
+#define DENSE_INDEX_H
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "KeyIndex.h"
+#include "MappedFile.h"
+
+/// Number of slots of a dense index, one per 5-digit zip code.
+const int DENSE_INDEX_SLOTS = 100000;
+
+/**
+ * @class DenseIndex
+ * @brief Flat array of RBNs indexed by the numeric value of a zip code.
+ *
+ * Only all-digit keys below DENSE_INDEX_SLOTS can be indexed; "00501" and "501" share
+ * a slot, as compareKeys() treats them as equal. Scans report keys without leading zeros.
+ */
+class DenseIndex : public KeyIndex {
+public:
+    DenseIndex();
+
+    bool build(const std::string& fileName, const std::vector<std::pair<std::string, int>>& entries, int pageSize) override;
+    bool open(const std::string& fileName, bool mapped = false) override;
+    void close() override;
+    int find(const std::string& key) override;
+    bool last(std::string& key, int& RBN) override;
+    bool insert(const std::string& key, int RBN) override;
+    bool erase(const std::string& key) override;
+    void scan(const std::string& low, const std::function<bool(const std::string&, int)>& visit) override;
+    std::string describe() const override;
+
+    bool isOpen() const override { return slots != nullptr; }
+    const std::string& getFileName() const override { return fileName; }
+    int getEntryCount() const override { return entryCount; }
+
+private:
+    /**
+     * @brief Writes one slot and the entry count through to the index file.
+     * @param slot Slot number.
+     * @return True if the file was updated.
+     */
+    bool writeSlot(int slot);
+
+    int32_t slotValue(int slot) const;
+
+    std::string fileName;           ///< Path of the open index file
+    std::fstream file;              ///< Open index file, when not mapped
+    MappedFile mapping;             ///< Read-only mapping of the index file, if mapped
+    std::vector<int32_t> loaded;    ///< Slots read from the file, when not mapped
+    const char* slots;              ///< First slot, in the mapping or in loaded
+    int entryCount;                 ///< Number of indexed keys
+};
+
+/**
+ * @brief Returns the dense index slot of a key.
+ * @param key Key such as "501" or "00501".
+ * @return Slot number, or -1 if the key is not a zip code below DENSE_INDEX_SLOTS.
+ */
+int denseSlot(const std::string& key);
+
+#endif // DENSE_INDEX_H
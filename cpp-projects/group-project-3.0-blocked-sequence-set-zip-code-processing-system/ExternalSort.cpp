@@ -0,0 +1,222 @@
+// CSCI 331 Group Project - Copyright © 2024 Blocked Sequence Set Zip Code Processing System
+#include "ExternalSort.h"
+#include "Block.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <queue>
+#include <string_view>
+
+using namespace std;
+
+/// Largest read buffer given to one run while merging.
+static const size_t MERGE_BUFFER_LIMIT = 1024 * 1024;
+
+/**
+ * @brief Names the sorted copy of a CSV file ("feed.csv" -> "feed.sorted.csv").
+ * @param inputFile Path of the CSV file.
+ * @return Path of the sorted file.
+ */
+string sortedFileName(const string& inputFile) {
+    size_t dot = inputFile.find_last_of('.');
+    size_t slash = inputFile.find_last_of("/\\");
+    if (dot == string::npos || (slash != string::npos && dot < slash)) return inputFile + ".sorted";
+    return inputFile.substr(0, dot) + ".sorted" + inputFile.substr(dot);
+}
+
+/**
+ * @brief Returns one field of a CSV record without copying it.
+ * @param record Comma separated record text.
+ * @param field Field number.
+ * @return The field, or an empty view if the record has fewer fields.
+ */
+static string_view fieldOf(const string& record, size_t field) {
+    size_t start = 0;
+    for (size_t f = 0; f < field; f++) {
+        size_t comma = record.find(',', start);
+        if (comma == string::npos) return string_view();
+        start = comma + 1;
+    }
+    size_t end = record.find(',', start);
+    return string_view(record).substr(start, end == string::npos ? string::npos : end - start);
+}
+
+ExternalSort::ExternalSort(size_t memoryBudget, size_t keyField)
+    : memoryBudget(memoryBudget)
+    , keyField(keyField)
+    , recordCount(0)
+    , runCount(0)
+    , mergePasses(0) {}
+
+/**
+ * @brief Names a run file of a sort ("block.sorted.csv", 3 -> "block.sorted.csv.3.run").
+ */
+string ExternalSort::runFileName(const string& outputFile, size_t run) const {
+    return outputFile + "." + to_string(run) + ".run";
+}
+
+/**
+ * @brief Sorts a chunk of records by key and writes it to a run file.
+ *
+ * Runs on a background thread while the next chunk is read.
+ *
+ * @param records Records to sort; they are reordered.
+ * @param runFile Path of the run file to create.
+ * @return True if the run file was written.
+ */
+bool ExternalSort::writeRun(vector<string>& records, const string& runFile) const {
+    stable_sort(records.begin(), records.end(), [this](const string& a, const string& b) {
+        return compareKeys(fieldOf(a, keyField), fieldOf(b, keyField)) < 0;
+    });
+    ofstream out(runFile, ios::binary | ios::trunc);
+    for (const string& record : records) {
+        out << record << '\n';
+    }
+    if (!out.good()) {
+        cerr << "Error: Could not write sort run file: " << runFile << endl;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Merges sorted run files into one sorted file with a heap of their first records.
+ *
+ * Records with equal keys are taken from the earlier run first, so the merge is stable.
+ *
+ * @param runFiles Run files in input order.
+ * @param outputFile Path of the merged file to create.
+ * @param title Title line written first, or empty for an intermediate run.
+ * @return True if the merged file was written.
+ */
+bool ExternalSort::mergeRuns(const vector<string>& runFiles, const string& outputFile, const string& title) const {
+    size_t bufferSize = min(MERGE_BUFFER_LIMIT, max<size_t>(memoryBudget / (runFiles.size() + 1), 4096));
+    vector<unique_ptr<ifstream>> inputs;
+    vector<vector<char>> buffers(runFiles.size(), vector<char>(bufferSize));
+    vector<string> heads(runFiles.size());
+
+    auto later = [this, &heads](size_t a, size_t b) {
+        int order = compareKeys(fieldOf(heads[a], keyField), fieldOf(heads[b], keyField));
+        return order != 0 ? order > 0 : a > b;
+    };
+    priority_queue<size_t, vector<size_t>, decltype(later)> heap(later);
+
+    for (size_t r = 0; r < runFiles.size(); r++) {
+        inputs.push_back(make_unique<ifstream>());
+        inputs[r]->rdbuf()->pubsetbuf(buffers[r].data(), buffers[r].size());
+        inputs[r]->open(runFiles[r], ios::binary);
+        if (!inputs[r]->is_open()) {
+            cerr << "Error: Could not open sort run file: " << runFiles[r] << endl;
+            return false;
+        }
+        if (getline(*inputs[r], heads[r])) heap.push(r);
+    }
+
+    ofstream out(outputFile, ios::binary | ios::trunc);
+    if (!title.empty()) out << title << '\n';
+    while (!heap.empty() && out.good()) {
+        size_t r = heap.top();
+        heap.pop();
+        out << heads[r] << '\n';
+        if (getline(*inputs[r], heads[r])) heap.push(r);
+    }
+    for (size_t r = 0; r < runFiles.size(); r++) {
+        if (inputs[r]->bad()) {
+            cerr << "Error: Could not read sort run file: " << runFiles[r] << endl;
+            return false;
+        }
+    }
+    if (!out.good()) {
+        cerr << "Error: Could not write sorted file: " << outputFile << endl;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Sorts a CSV file into a new file, copying its title line first.
+ *
+ * Chunks of records are read up to half the memory budget. Each full chunk is handed
+ * to a background thread that sorts it and writes it as a run, while this thread reads
+ * the next chunk; the next hand-off waits for the previous run to be written. The runs
+ * are then merged SORT_MERGE_FAN_IN at a time until one pass can produce the output.
+ * Empty lines and carriage returns are dropped.
+ *
+ * @param inputFile Path of the CSV file to sort.
+ * @param outputFile Path of the sorted file to create.
+ * @return True if the sorted file was written.
+ */
+bool ExternalSort::sort(const string& inputFile, const string& outputFile) {
+    recordCount = 0;
+    runCount = 0;
+    mergePasses = 0;
+
+    ifstream in(inputFile, ios::binary);
+    if (!in.is_open()) {
+        cerr << "Error: Could not open input file: " << inputFile << endl;
+        return false;
+    }
+    string title;
+    getline(in, title);
+    if (!title.empty() && title.back() == '\r') title.pop_back();
+
+    const size_t chunkLimit = max<size_t>(memoryBudget / 2, 1);  ///< Bytes of records per run
+    vector<string> created;        ///< Every run file, deleted at the end
+    vector<string> runFiles;       ///< Runs still to be merged, in input order
+    vector<string> chunk;          ///< Records of the run being read
+    size_t chunkBytes = 0;
+    future<bool> writing;          ///< Run being sorted and written in the background
+    bool ok = true;
+
+    auto startRun = [&]() {
+        if (writing.valid()) ok = writing.get() && ok;
+        runFiles.push_back(runFileName(outputFile, runCount++));
+        created.push_back(runFiles.back());
+        writing = async(launch::async, [this](vector<string> records, string runFile) {
+            return writeRun(records, runFile);
+        }, move(chunk), runFiles.back());
+        chunk = vector<string>();
+        chunkBytes = 0;
+    };
+
+    string line;
+    while (ok && getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty()) continue;
+        chunkBytes += line.size() + sizeof(string);
+        chunk.push_back(move(line));
+        recordCount++;
+        if (chunkBytes >= chunkLimit) startRun();
+    }
+    if (ok && (!chunk.empty() || runFiles.empty())) startRun();
+    if (writing.valid()) ok = writing.get() && ok;
+    if (in.bad()) {
+        cerr << "Error: Could not read input file: " << inputFile << endl;
+        ok = false;
+    }
+
+    // Merge groups of runs until a single pass can merge the rest into the output
+    while (ok && runFiles.size() > SORT_MERGE_FAN_IN) {
+        vector<string> merged;
+        for (size_t first = 0; ok && first < runFiles.size(); first += SORT_MERGE_FAN_IN) {
+            vector<string> group(runFiles.begin() + first,
+                                 runFiles.begin() + min(first + SORT_MERGE_FAN_IN, runFiles.size()));
+            merged.push_back(runFileName(outputFile, runCount++));
+            created.push_back(merged.back());
+            ok = mergeRuns(group, merged.back(), string());
+            for (const string& run : group) remove(run.c_str());
+        }
+        runFiles = move(merged);
+        mergePasses++;
+    }
+    if (ok) {
+        ok = mergeRuns(runFiles, outputFile, title);
+        mergePasses++;
+    }
+
+    for (const string& run : created) remove(run.c_str());
+    return ok;
+}
@@ -0,0 +1,74 @@
+// CSCI 331 Group Project - Copyright © 2024 Blocked Sequence Set Zip Code Processing System
+/**
+ * @file ExternalSort.h
+ * @brief Declaration of the ExternalSort class, which sorts a CSV file by key within a
+ *        fixed memory budget.
+ *
+ * The records after the title line are read in chunks of half the budget. Each chunk is
+ * sorted and written to a run file on a background thread while the next chunk is read,
+ * so at most two chunks are in memory. The runs are then merged with a heap, at most
+ * SORT_MERGE_FAN_IN at a time; larger run counts take more merge passes. Records with
+ * equal keys keep their input order.
+ */
+
+#ifndef EXTERNAL_SORT_H
+#define EXTERNAL_SORT_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/// Memory budget of a sort, in bytes.
+const size_t DEFAULT_SORT_MEMORY = 64 * 1024 * 1024;
+
+/// Runs merged together by one merge pass.
+const size_t SORT_MERGE_FAN_IN = 64;
+
+/**
+ * @brief Names the sorted copy of a CSV file ("feed.csv" -> "feed.sorted.csv").
+ * @param inputFile Path of the CSV file.
+ * @return Path of the sorted file.
+ */
+std::string sortedFileName(const std::string& inputFile);
+
+/**
+ * @class ExternalSort
+ * @brief Sorts the records of a CSV file by one field in compareKeys() order.
+ */
+class ExternalSort {
+public:
+    /**
+     * @brief Creates a sort.
+     * @param memoryBudget Bytes of records held in memory at once.
+     * @param keyField Field number of the key.
+     */
+    explicit ExternalSort(size_t memoryBudget = DEFAULT_SORT_MEMORY, size_t keyField = 0);
+
+    /**
+     * @brief Sorts a CSV file into a new file, copying its title line first.
+     *
+     * Run files are created next to the output file and deleted when the sort ends.
+     *
+     * @param inputFile Path of the CSV file to sort.
+     * @param outputFile Path of the sorted file to create.
+     * @return True if the sorted file was written.
+     */
+    bool sort(const std::string& inputFile, const std::string& outputFile);
+
+    size_t getRecordCount() const { return recordCount; }
+    size_t getRunCount() const { return runCount; }
+    size_t getMergePasses() const { return mergePasses; }
+
+private:
+    bool writeRun(std::vector<std::string>& records, const std::string& runFile) const;
+    bool mergeRuns(const std::vector<std::string>& runFiles, const std::string& outputFile, const std::string& title) const;
+    std::string runFileName(const std::string& outputFile, size_t run) const;
+
+    size_t memoryBudget;   ///< Bytes of records held in memory at once
+    size_t keyField;       ///< Field number of the key
+    size_t recordCount;    ///< Records sorted by the last sort()
+    size_t runCount;       ///< Runs written by the last sort(), merge passes included
+    size_t mergePasses;    ///< Merge passes of the last sort()
+};
+
+#endif // EXTERNAL_SORT_H
@@ -4,6 +4,15 @@
 #include <sstream>
 #include <iostream>
 #include <iomanip>
+#include <cstring>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 /**
  * @brief Default constructor for HeaderRecord
@@ -15,8 +24,10 @@ HeaderRecord::HeaderRecord()
     , recordSizeBytes(-1)
     , blockSize(512)  // Default block size of 512 bytes
     , minBlockCapacity(0.5)  // Default 50% minimum capacity
-    , recordCount(40933) // Record count of input data
-    , blockCount(3679) 
+    , fillFactor(1.0)        // Blocks filled completely by the initial load
+    , compressedBlockSize(0) // Blocks stored uncompressed
+    , recordCount(0) // Set by the writer of the block file
+    , blockCount(0)
     , fieldCount(6) // Default 6 as all used zipcode data has 6 peramiters
     , primaryKeyField(0)
     , availListRBN(-1)
@@ -25,6 +36,7 @@ HeaderRecord::HeaderRecord()
     fileStructureType = "blocked_sequence_set";
     version = "1.0";
     sizeFormatType = "ASCII";
+    compression = "none";
 }
 
 /**
@@ -40,66 +52,199 @@ void HeaderRecord::addField(const std::string& name, const std::string& schema)
     fieldCount = fields.size();
 }
 
+/**
+ * @brief Computes the checksum of a header image (32-bit FNV-1a, checksum field zeroed)
+ *
+ * @param image Header image
+ * @return Checksum to store in, or compare with, image.checksum
+ */
+static uint32_t headerChecksum(HeaderImage image) {
+    image.checksum = 0;
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&image);
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < sizeof(image); i++) {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * @brief Copies a text value into a fixed-width, NUL padded slot of a header image
+ *
+ * @param slot Destination slot
+ * @param size Bytes of the slot
+ * @param value Text to copy
+ * @param what Name of the value, for the error message
+ * @return true if the value fits the slot
+ */
+static bool putText(char* slot, size_t size, const std::string& value, const char* what) {
+    if (value.size() > size) {
+        std::cerr << "Error: Header " << what << " \"" << value << "\" is longer than " << size << " bytes" << std::endl;
+        return false;
+    }
+    memcpy(slot, value.data(), value.size());
+    return true;
+}
+
+/**
+ * @brief Reads a fixed-width, NUL padded text slot of a header image
+ */
+static std::string getText(const char* slot, size_t size) {
+    return std::string(slot, strnlen(slot, size));
+}
+
 /**
  * @brief Writes the header information to an already open file stream
  * 
- * @param file Reference to an open output file stream
- * @return true if successful, false otherwise
+ * The header is written as one HeaderImage, with the record and block counts set by
+ * the writer of the file.
+ *
+ * @param file Reference to an open output stream
+ * @return true if successful, false if a value does not fit the layout
  */
-bool HeaderRecord::writeHeader(std::ofstream& file) {
-    if (!file.is_open()) {
+bool HeaderRecord::writeHeader(std::ostream& file) {
+    if (!file) {
         std::cerr << "Error: File stream is not open" << std::endl;
         return false;
     }
+    if (fields.size() > HEADER_MAX_FIELDS) {
+        std::cerr << "Error: A header describes at most " << HEADER_MAX_FIELDS << " fields" << std::endl;
+        return false;
+    }
 
-    // Lambda to write length-indicated field
-    auto writeField = [&file](const std::string& value) {
-        std::string lengthStr = std::to_string(value.length());
-        if (lengthStr.length() < 2) lengthStr = "0" + lengthStr;
-        file << lengthStr << value << ",";
-    };
-
-    // Write main header fields
-    writeField(fileStructureType);
-    writeField(version);
-    writeField(std::to_string(headerSize));
-    writeField(std::to_string(recordSizeBytes));
-    writeField(sizeFormatType);
-    writeField(std::to_string(blockSize));
-    writeField(std::to_string(static_cast<int>(minBlockCapacity * 100)));
-    writeField(indexFileName);
-    writeField(indexFileSchema);
-    writeField(std::to_string(recordCount));
-    writeField(std::to_string(blockCount));
-    writeField(std::to_string(fieldCount));
-    writeField(std::to_string(primaryKeyField));
-    writeField(std::to_string(availListRBN));
-    writeField(std::to_string(activeListRBN));
-    file << (isStale ? "1" : "0") << "\n";
-
-    // Write field metadata
-    for (const auto& field : fields) {
-        writeField(field.name);
-        writeField(field.typeSchema);
-        file << "\n";
+    HeaderImage image;
+    memset(&image, 0, sizeof(image));
+    memcpy(image.magic, HEADER_MAGIC, sizeof(image.magic));
+    image.layoutVersion = HEADER_LAYOUT_VERSION;
+    image.fieldCount = static_cast<uint16_t>(fields.size());
+    image.headerSize = headerSize;
+    image.blockSize = blockSize;
+    image.recordSizeBytes = recordSizeBytes;
+    image.minBlockCapacity = static_cast<int32_t>(minBlockCapacity * 100);
+    image.fillFactor = static_cast<int32_t>(fillFactor * 100 + 0.5);
+    image.compressedBlockSize = compressedBlockSize;
+    image.recordCount = recordCount;
+    image.blockCount = blockCount;
+    image.primaryKeyField = primaryKeyField;
+    image.availListRBN = availListRBN;
+    image.activeListRBN = activeListRBN;
+    image.flags = isStale ? 1 : 0;
+
+    bool fits = putText(image.fileStructureType, sizeof(image.fileStructureType), fileStructureType, "file structure type")
+        && putText(image.version, sizeof(image.version), version, "version")
+        && putText(image.sizeFormatType, sizeof(image.sizeFormatType), sizeFormatType, "size format type")
+        && putText(image.indexFileName, sizeof(image.indexFileName), indexFileName, "index file name")
+        && putText(image.indexSchema, sizeof(image.indexSchema), indexFileSchema, "index schema")
+        && putText(image.compression, sizeof(image.compression), compression, "compression");
+    for (size_t f = 0; fits && f < fields.size(); f++) {
+        fits = putText(image.fields[f].name, sizeof(image.fields[f].name), fields[f].name, "field name")
+            && putText(image.fields[f].typeSchema, sizeof(image.fields[f].typeSchema), fields[f].typeSchema, "field type");
     }
+    if (!fits) return false;
 
+    image.checksum = headerChecksum(image);
+    file.write(reinterpret_cast<const char*>(&image), sizeof(image));
+    return file.good();
+}
+
+/**
+ * @brief Reads the first bytes of a file with one positioned read
+ *
+ * @param filename Name of the file to read from
+ * @param buffer Receives the bytes
+ * @param size Bytes wanted
+ * @return Bytes read, or -1 if the file could not be opened
+ */
+static long readPrefix(const std::string& filename, void* buffer, size_t size) {
+#ifdef _WIN32
+    int fd = _open(filename.c_str(), _O_RDONLY | _O_BINARY);
+    if (fd < 0) return -1;
+    long got = _read(fd, buffer, static_cast<unsigned>(size));
+    _close(fd);
+#else
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) return -1;
+    long got = static_cast<long>(pread(fd, buffer, size, 0));
+    ::close(fd);
+#endif
+    return got;
+}
+
+/**
+ * @brief Reads the header information of a file with one pread of a HeaderImage
+ *
+ * Every value sits at a fixed offset of the image, so nothing is parsed. A file that
+ * does not start with HEADER_MAGIC is read as a length-indicated ASCII header.
+ *
+ * @param filename Name of the file to read from
+ * @return true if successful, false otherwise
+ */
+bool HeaderRecord::readHeader(const std::string& filename) {
+    HeaderImage image;
+    long got = readPrefix(filename, &image, sizeof(image));
+    if (got < 0) {
+        std::cerr << "Error: Unable to open file for reading: " << filename << std::endl;
+        return false;
+    }
+    if (got < static_cast<long>(sizeof(image.magic)) || memcmp(image.magic, HEADER_MAGIC, sizeof(image.magic)) != 0) {
+        return readTextHeader(filename);
+    }
+    if (got < static_cast<long>(sizeof(image)) || image.layoutVersion < 1 || image.layoutVersion > HEADER_LAYOUT_VERSION
+        || image.fieldCount > HEADER_MAX_FIELDS || headerChecksum(image) != image.checksum) {
+        std::cerr << "Error: " << filename << " has a damaged or unsupported header (layout version "
+                  << image.layoutVersion << ")" << std::endl;
+        return false;
+    }
+
+    fileStructureType = getText(image.fileStructureType, sizeof(image.fileStructureType));
+    version = getText(image.version, sizeof(image.version));
+    headerSize = image.headerSize;
+    recordSizeBytes = image.recordSizeBytes;
+    sizeFormatType = getText(image.sizeFormatType, sizeof(image.sizeFormatType));
+    blockSize = image.blockSize;
+    minBlockCapacity = image.minBlockCapacity / 100.0;
+    fillFactor = image.fillFactor > 0 ? image.fillFactor / 100.0 : 1.0;
+    compressedBlockSize = image.compressedBlockSize;
+    compression = getText(image.compression, sizeof(image.compression));
+    if (compression.empty()) compression = "none";
+    indexFileName = getText(image.indexFileName, sizeof(image.indexFileName));
+    indexFileSchema = getText(image.indexSchema, sizeof(image.indexSchema));
+    recordCount = image.recordCount;
+    blockCount = image.blockCount;
+    fieldCount = image.fieldCount;
+    primaryKeyField = image.primaryKeyField;
+    availListRBN = image.availListRBN;
+    activeListRBN = image.activeListRBN;
+    isStale = (image.flags & 1) != 0;
+
+    fields.clear();
+    for (int f = 0; f < fieldCount; f++) {
+        FieldMetadata metadata;
+        metadata.name = getText(image.fields[f].name, sizeof(image.fields[f].name));
+        metadata.typeSchema = getText(image.fields[f].typeSchema, sizeof(image.fields[f].typeSchema));
+        fields.push_back(metadata);
+    }
     return true;
 }
 
 /**
- * @brief Reads and parses header information from a file
+ * @brief Reads and parses a length-indicated ASCII header, the layout used before HeaderImage
  * 
  * @param filename Name of the file to read from
  * @return true if successful, false otherwise
  */
-bool HeaderRecord::readHeader(const std::string& filename) {
+bool HeaderRecord::readTextHeader(const std::string& filename) {
     std::ifstream file(filename);
     if (!file.is_open()) {
         std::cerr << "Error: Unable to open file for reading: " << filename << std::endl;
         return false;
     }
 
+    // Text headers predate block compression and fill factors
+    fillFactor = 1.0;
+    compression = "none";
+    compressedBlockSize = 0;
+
     std::string line;
     if (std::getline(file, line)) {
         std::stringstream ss(line);
@@ -2,9 +2,68 @@
 #ifndef HEADER_RECORD_H
 #define HEADER_RECORD_H
 
+#include <cstdint>
+#include <iosfwd>
 #include <string>
 #include <vector>
 
+/// Identifies the binary header layout at the start of a block file.
+const char HEADER_MAGIC[4] = { 'B', 'S', 'S', 'H' };
+
+/// Version of the binary header layout written by HeaderRecord::writeHeader().
+const uint16_t HEADER_LAYOUT_VERSION = 2;
+
+/// Most fields a binary header can describe (8 in layout version 1).
+const size_t HEADER_MAX_FIELDS = 7;
+
+/**
+ * @brief One field description in the binary header, NUL padded.
+ */
+struct HeaderFieldImage {
+    char name[16];        ///< Name of the field
+    char typeSchema[26];  ///< Type and format of the field
+};
+
+/**
+ * @brief Binary header layout: one fixed-size struct read with a single pread.
+ *
+ * Integers are little-endian and every offset is fixed. Text fields are NUL padded and
+ * need no terminator when full. The checksum is the 32-bit FNV-1a hash of the image
+ * with the checksum field zeroed. The image is followed by zero padding up to
+ * headerSize.
+ *
+ * Layout version 2 took the last field slot of version 1 for the compression fields;
+ * version 1 images with at most 7 fields hold zeros there and read as uncompressed.
+ */
+struct HeaderImage {
+    char magic[4];                 ///< HEADER_MAGIC (offset 0)
+    uint16_t layoutVersion;        ///< HEADER_LAYOUT_VERSION (offset 4)
+    uint16_t fieldCount;           ///< Fields per record (offset 6)
+    int32_t headerSize;            ///< Bytes of the header region (offset 8)
+    int32_t blockSize;             ///< Bytes per block (offset 12)
+    int32_t recordSizeBytes;       ///< Bytes of the record size integers (offset 16)
+    int32_t minBlockCapacity;      ///< Minimum block capacity in percent (offset 20)
+    int32_t recordCount;           ///< Records in the active blocks (offset 24)
+    int32_t blockCount;            ///< Blocks in the file, avail list included (offset 28)
+    int32_t primaryKeyField;       ///< Ordinal number of the primary key field (offset 32)
+    int32_t availListRBN;          ///< Head of the avail list, -1 if empty (offset 36)
+    int32_t activeListRBN;         ///< Head of the active list, -1 if empty (offset 40)
+    uint32_t flags;                ///< Bit 0: stale (offset 44)
+    uint32_t checksum;             ///< FNV-1a of the image with this field zero (offset 48)
+    char fileStructureType[24];    ///< (offset 52)
+    char version[8];               ///< (offset 76)
+    char sizeFormatType[8];        ///< (offset 84)
+    char indexFileName[40];        ///< (offset 92)
+    char indexSchema[40];          ///< (offset 132)
+    int32_t fillFactor;            ///< Initial block fill in percent, 0 if not recorded (offset 172)
+    HeaderFieldImage fields[HEADER_MAX_FIELDS];  ///< (offset 176)
+    char compression[10];          ///< Codec of the compressed blocks (offset 470)
+    int32_t compressedBlockSize;   ///< Bytes per block on disk, 0 if uncompressed (offset 480)
+    char reserved[28];             ///< Zero (offset 484)
+};
+
+static_assert(sizeof(HeaderImage) == 512, "the binary header layout is 512 bytes");
+
 /**
  * @brief Metadata structure for field information in the header
  */
@@ -25,14 +84,18 @@ public:
     HeaderRecord();
     
     /**
-     * @brief Writes the header information to a file
-     * @param file ofstream of the file to write to
-     * @return true if successful, false otherwise
+     * @brief Writes the header information to a file as a binary HeaderImage
+     * @param file Open stream of the file to write to
+     * @return true if successful, false if a value does not fit the layout
      */
-    bool writeHeader(std::ofstream& file);
+    bool writeHeader(std::ostream& file);
     
     /**
-     * @brief Reads and parses header information from a file
+     * @brief Reads the header information of a file with one pread of a HeaderImage
+     *
+     * Files written before the binary layout, whose header is length-indicated ASCII
+     * text, are still read.
+     *
      * @param filename Name of the file to read from
      * @return true if successful, false otherwise
      */
@@ -41,30 +104,49 @@ public:
     // Setters
     void setFileStructureType(const std::string& type) { fileStructureType = type; }
     void setVersion(const std::string& ver) { version = ver; }
+    void setHeaderSize(int size) { headerSize = size; }
     void setBlockSize(int size) { blockSize = size; }
     void setMinBlockCapacity(double capacity) { minBlockCapacity = capacity; }
+    void setFillFactor(double factor) { fillFactor = factor; }
+    void setCompression(const std::string& codec) { compression = codec; }
+    void setCompressedBlockSize(int size) { compressedBlockSize = size; }
     void setIndexFileName(const std::string& name) { indexFileName = name; }
     void setIndexSchema(const std::string& schema) { indexFileSchema = schema; }
     void setPrimaryKeyField(int field) { primaryKeyField = field; }
     void setAvailListRBN(int rbn) { availListRBN = rbn; }
     void setActiveListRBN(int rbn) { activeListRBN = rbn; }
     void setStaleFlag(bool flag) { isStale = flag; }
+    void setRecordCount(int count) { recordCount = count; }
+    void setBlockCount(int count) { blockCount = count; }
     void addField(const std::string& name, const std::string& schema);
     
     // Getters
     std::string getFileStructureType() const { return fileStructureType; }
     std::string getVersion() const { return version; }
+    int getHeaderSize() const { return headerSize; }
     int getBlockSize() const { return blockSize; }
     double getMinBlockCapacity() const { return minBlockCapacity; }
+    double getFillFactor() const { return fillFactor; }
+    std::string getCompression() const { return compression; }
+    int getCompressedBlockSize() const { return compressedBlockSize; }
     std::string getIndexFileName() const { return indexFileName; }
     std::string getIndexSchema() const { return indexFileSchema; }
     int getPrimaryKeyField() const { return primaryKeyField; }
     int getAvailListRBN() const { return availListRBN; }
     int getActiveListRBN() const { return activeListRBN; }
     bool getStaleFlag() const { return isStale; }
+    int getRecordCount() const { return recordCount; }
+    int getBlockCount() const { return blockCount; }
     const std::vector<FieldMetadata>& getFields() const { return fields; }
     
 private:
+    /**
+     * @brief Reads a length-indicated ASCII header, the layout used before HeaderImage
+     * @param filename Name of the file to read from
+     * @return true if successful, false otherwise
+     */
+    bool readTextHeader(const std::string& filename);
+
     std::string fileStructureType;     ///< Type of file structure
     std::string version;               ///< Version of the file structure
     int headerSize;                    ///< Size of the header record in bytes
@@ -72,6 +154,9 @@ private:
     std::string sizeFormatType;        ///< Format type for sizes (ASCII/binary)
     int blockSize;                     ///< Size of each block in bytes
     double minBlockCapacity;           ///< Minimum block capacity (default 50%)
+    double fillFactor;                 ///< Fraction of each block filled by the initial load
+    std::string compression;           ///< Codec of the compressed blocks
+    int compressedBlockSize;           ///< Bytes per block on disk, 0 if the blocks are not compressed
     std::string indexFileName;         ///< Name of the index file
     std::string indexFileSchema;       ///< Schema information for the index file
     int recordCount;                   ///< Total number of records
@@ -1,5 +1,11 @@
 // CSCI 331 Group Project - Copyright © 2024 Blocked Sequence Set Zip Code Processing System
 #include "Index.h"
+#include "Block.h"
+#include "HeaderRecord.h"
+#include "KeyIndex.h"
+#include "BloomFilter.h"
+#include "SecondaryIndex.h"
+#include "PrefixTrie.h"
 #include <iostream>
 #include <fstream>
 #include <sstream>
@@ -25,66 +31,144 @@ vector<string> Index::split( const string& line, char delimiter ) {
 }
 
 /**
- * @brief Processes block data from an input file and organizes it into an output file.
+ * @brief Builds the primary key index of a block file.
  *
- * This method reads data from an input file, extracts and processes relevant information,
- * and writes the results into an output file. Each valid block and zip code pair is stored
- * in the output file in the format "Block,Zip Code".
+ * This method reads the header of a block file, follows the active block chain from
+ * its head and collects the primary key and RBN of every record. Because the chain is
+ * in key order, the collected entries are already sorted. The indexes are then built
+ * from them by save().
  *
  * @param inputFileName The name of the input file containing block data.
- * @param outputFileName The name of the output file where processed data will be saved.
+ * @param outputFileName The name of the index file to create.
+ * @param falsePositiveRate False positive rate the Bloom filter is sized for.
+ * @return True if the blocks were read and every index was saved.
  */
-void Index::processBlockData( const string& inputFileName, const string& outputFileName ) {
-  ifstream inputFile( inputFileName );
+bool Index::processBlockData( const string& inputFileName, const string& outputFileName, double falsePositiveRate ) {
+  HeaderRecord fileHeader;
+  if ( !fileHeader.readHeader( inputFileName ) ) {
+    cerr << "Error: Could not read header of " << inputFileName << endl;
+    return false;
+  }
+
+  ifstream inputFile( inputFileName, ios::binary );
   if ( !inputFile.is_open() ) {
     cerr << "Error: Could not open " << inputFileName << endl;
-    return;
+    return false;
   }
 
-  ofstream outputFile( outputFileName );
-  if ( !outputFile.is_open() ) {
-    cerr << "Error: Could not open " << outputFileName << endl;
-    return;
+  begin( fileHeader );
+  int blockCount = countBlocks( fileHeader, inputFile );
+  int visited = 0;
+  Block block;
+  for ( int rbn = fileHeader.getActiveListRBN(); rbn != -1 && visited < blockCount; rbn = block.successorRBN ) {
+    if ( !readBlock( inputFile, fileHeader, rbn, block ) ) {
+      cerr << "Error: Could not read block " << rbn << " of " << inputFileName << endl;
+      return false;
+    }
+    visited++;
+    addBlock( block );
   }
+  inputFile.close();
+  return save( outputFileName, falsePositiveRate );
+}
 
-  outputFile << "Block,Zip Code\n";
-  string line;
-  getline( inputFile, line );
-  line = "";
-  while ( getline( inputFile, line ) ) {
-    if ( line.empty() ) continue;
+/**
+ * @brief Starts collecting the index entries of a block file, dropping earlier ones.
+ *
+ * @param header Header record of the block file; its fields and index schema are kept.
+ */
+void Index::begin( const HeaderRecord& header ) {
+  this->header = header;
+  fieldCount = recordFieldCount( header );
+  keyField = header.getPrimaryKeyField();
+  placeField = fieldIndex( header, "place_name", 1 );
+  entries.clear();
+  secondaryEntries.assign( header.getFields().size(), {} );
+  places.clear();
+}
 
-    // Check if the line contains a colon; if not, skip it
-    size_t colonPos = line.find( ':' );
-    if ( colonPos == string::npos ) {
-      // If no colon, perform additional validation
-      vector<string> fields = split( line, ',' );
-      if ( fields.size() < 2 || !isdigit( fields[ 0 ][ 0 ] ) ) {
-        // Skip malformed lines
-        continue;
+/**
+ * @brief Collects the primary key, place name and indexed field values of the records
+ *        of one active block.
+ *
+ * @param block Block whose records are added; blocks arrive in sequence set order.
+ */
+void Index::addBlock( const Block& block ) {
+  const auto& fields = header.getFields();
+  for ( size_t i = keyField; i < block.records.size(); i += fieldCount ) {
+    if ( !block.records[ i ].empty() ) {
+      entries.push_back( { block.records[ i ], block.RBN } );
+      if ( i - keyField + placeField < block.records.size() ) {
+        places.push_back( { block.records[ i - keyField + placeField ], block.records[ i ] } );
       }
-    }
-    else {
-      // Process lines with valid block:data format
-      string block = line.substr( 0, colonPos ); // Block number
-      string data = line.substr( colonPos + 1 ); // Rest of the data
-
-      // Split data into fields
-      vector<string> fields = split( data, ',' );
-
-      // Extract zip codes (skip 5 fields for each)
-      for ( size_t i = 0; i < fields.size(); i += 6 ) {
-        if ( !fields[ i ].empty() && isdigit( fields[ i ][ 0 ] ) ) {
-          string zipCode = fields[ i ];
-          outputFile << zipCode << " " << block << "\n";
+      for ( size_t f = 0; f < fields.size() && i - keyField + f < block.records.size(); f++ ) {
+        if ( hasSecondaryIndex( fields[ f ] ) ) {
+          secondaryEntries[ f ].push_back( { block.records[ i - keyField + f ], block.records[ i ] } );
         }
       }
     }
   }
+}
 
-  inputFile.close();
-  outputFile.close();
+/**
+ * @brief Builds and saves every index from the collected entries.
+ *
+ * The index format is chosen by the index schema of the header (see makeKeyIndex()) and
+ * built bottom-up from the sorted entries, using the block size as its page size. A
+ * Bloom filter over the same keys is saved next to it (see bloomFileName()), and so is
+ * a secondary index for every field declared with SECONDARY_INDEX_TAG and the place
+ * name trie used for prefix completion (see trieFileName()).
+ *
+ * @param outputFileName The name of the index file to create.
+ * @param falsePositiveRate False positive rate the Bloom filter is sized for.
+ * @return True if every file was saved.
+ */
+bool Index::save( const string& outputFileName, double falsePositiveRate ) {
+  const auto& fields = header.getFields();
+  unique_ptr<KeyIndex> index = makeKeyIndex( header.getIndexSchema() );
+  if ( !index->build( outputFileName, entries, header.getBlockSize() ) ) {
+    cerr << "Error: Could not build index " << outputFileName << endl;
+    return false;
+  }
 
-  cout << "Data successfully organized and saved to '" << outputFileName << "'.\n";
-}
+  cout << "Index of " << index->getEntryCount() << " keys (" << index->describe()
+       << ") successfully saved to '" << outputFileName << "'.\n";
 
+  // Bloom filter over the same keys, so absent keys are rejected without reading the index
+  BloomFilter filter;
+  filter.create( entries.size(), falsePositiveRate );
+  for ( const auto& entry : entries ) {
+    filter.add( entry.first );
+  }
+  string filterFileName = bloomFileName( outputFileName );
+  if ( !filter.save( filterFileName ) ) {
+    cerr << "Error: Could not save Bloom filter " << filterFileName << endl;
+    return false;
+  }
+  cout << "Bloom filter of " << filter.getBitCount() << " bits (" << filter.getHashCount()
+       << " hashes) successfully saved to '" << filterFileName << "'.\n";
+
+  // Secondary indexes from field values to primary keys
+  for ( size_t f = 0; f < fields.size(); f++ ) {
+    if ( !hasSecondaryIndex( fields[ f ] ) ) continue;
+    SecondaryIndex secondary;
+    string secondaryFileName = secondaryIndexFileName( outputFileName, fields[ f ].name );
+    if ( !secondary.build( secondaryFileName, move( secondaryEntries[ f ] ) ) ) {
+      cerr << "Error: Could not save secondary index " << secondaryFileName << endl;
+      return false;
+    }
+    cout << "Secondary index on " << fields[ f ].name << " (" << secondary.getValueCount() << " values, "
+         << secondary.getKeyCount() << " keys) successfully saved to '" << secondaryFileName << "'.\n";
+  }
+
+  // Compressed trie of the place names for prefix completion
+  PrefixTrie trie;
+  string trieName = trieFileName( outputFileName );
+  if ( !trie.build( trieName, places ) ) {
+    cerr << "Error: Could not save place name trie " << trieName << endl;
+    return false;
+  }
+  cout << "Place name trie of " << trie.getNameCount() << " names (" << trie.getNodeCount()
+       << " nodes) successfully saved to '" << trieName << "'.\n";
+  return true;
+}
@@ -3,30 +3,71 @@
 #define INDEX_H
 #include <vector>
 #include <string>
+#include <utility>
+#include "BloomFilter.h"
+#include "HeaderRecord.h"
 
 using namespace std;
 
+struct Block;
+
 class Index {
 public:
   /**
- * @brief Splits a string into tokens based on a specified delimiter.
+ * @brief Builds the primary key index of a block file.
  *
- * @param line The input string to be split.
- * @param delimiter The character used as the delimiter for splitting the string.
- * @return A vector containing the tokens extracted from the input string.
+ * This method follows the active block chain of the block file and builds a
+ * primary key index mapping each zip code to the RBN of its block (see KeyIndex), plus a
+ * Bloom filter of the zip codes, a secondary index of every indexed field (see
+ * SecondaryIndex) and a place name trie (see PrefixTrie) saved next to the index.
+ *
+ * @param inputFileName The name of the input file containing block data.
+ * @param outputFileName The name of the index file to create.
+ * @param falsePositiveRate False positive rate the Bloom filter is sized for.
+ * @return True if the blocks were read and every index was saved.
  */
-  void processBlockData( const string& inputFileName, const string& outputFileName );
+  bool processBlockData( const string& inputFileName, const string& outputFileName,
+                         double falsePositiveRate = DEFAULT_BLOOM_FPR );
   /**
- * @brief Processes block data from an input file and organizes it into an output file.
+ * @brief Starts collecting the index entries of a block file, dropping earlier ones.
  *
- * This method reads data from an input file, extracts and processes relevant information,
- * and writes the results into an output file. Each valid block and zip code pair is stored
- * in the output file in the format "Block,Zip Code".
+ * @param header Header record of the block file; its fields and index schema are kept.
+ */
+  void begin( const HeaderRecord& header );
+  /**
+ * @brief Collects the entries of the records of one active block.
  *
- * @param inputFileName The name of the input file containing block data.
- * @param outputFileName The name of the output file where processed data will be saved.
+ * Blocks must be added in sequence set order, so the primary keys arrive sorted.
+ *
+ * @param block Block whose records are added.
+ */
+  void addBlock( const Block& block );
+  /**
+ * @brief Builds and saves the primary key index, Bloom filter, secondary indexes and
+ *        place name trie from the collected entries.
+ *
+ * @param outputFileName The name of the index file to create.
+ * @param falsePositiveRate False positive rate the Bloom filter is sized for.
+ * @return True if every file was saved.
+ */
+  bool save( const string& outputFileName, double falsePositiveRate = DEFAULT_BLOOM_FPR );
+  /**
+ * @brief Splits a string into tokens based on a specified delimiter.
+ *
+ * @param line The input string to be split.
+ * @param delimiter The character used as the delimiter for splitting the string.
+ * @return A vector containing the tokens extracted from the input string.
  */
   std::vector<std::string> split( const std::string& line, char delimiter );
+
+private:
+  HeaderRecord header;                                     ///< Header of the indexed block file
+  size_t fieldCount = 0;                                   ///< Fields per record
+  size_t keyField = 0;                                     ///< Field number of the primary key
+  size_t placeField = 1;                                   ///< Field number of the place name
+  vector<pair<string, int>> entries;                       ///< Primary key and RBN, in key order
+  vector<vector<pair<string, string>>> secondaryEntries;   ///< Value and primary key, per indexed field
+  vector<pair<string, string>> places;                     ///< Place name and primary key
 };
 
 #endif 
\ No newline at end of file
@@ -0,0 +1,52 @@
+// CSCI 331 Group Project - Copyright © 2024 Blocked Sequence Set Zip Code Processing System
+#include "KeyIndex.h"
+#include "BPlusTree.h"
+#include "DenseIndex.h"
+#include "SortedIndex.h"
+#include <sstream>
+
+using namespace std;
+
+/**
+ * @brief Looks up many keys sorted with compareKeys() and free of duplicates.
+ * @param sortedKeys Keys to look up in ascending order.
+ * @param visit Called for each key, in order, with its RBN or -1 if it is not indexed.
+ */
+void KeyIndex::findMany(const vector<string>& sortedKeys, const function<void(const string&, int)>& visit) {
+    for (const string& key : sortedKeys) {
+        visit(key, find(key));
+    }
+}
+
+/**
+ * @brief Returns the type given to one name in an index schema.
+ * @param schema Index schema such as "key:zip5,rbn:int".
+ * @param name Name to look up, e.g. "key".
+ * @return The type, or an empty string if the schema does not name it.
+ */
+string schemaType(const string& schema, const string& name) {
+    stringstream ss(schema);
+    string part;
+    while (getline(ss, part, ',')) {
+        size_t colon = part.find(':');
+        if (colon != string::npos && part.compare(0, colon, name) == 0) {
+            return part.substr(colon + 1);
+        }
+    }
+    return "";
+}
+
+/**
+ * @brief Creates an empty index of the format selected by an index schema.
+ * @param schema Index schema from the header record.
+ * @return A closed index of the selected format.
+ */
+unique_ptr<KeyIndex> makeKeyIndex(const string& schema) {
+    if (schemaType(schema, "key") == "zip5") {
+        return unique_ptr<KeyIndex>(new DenseIndex());
+    }
+    if (schemaType(schema, "key") == "uint32") {
+        return unique_ptr<KeyIndex>(new SortedIndex());
+    }
+    return unique_ptr<KeyIndex>(new BPlusTree());
+}
@@ -0,0 +1,130 @@
+// CSCI 331 Group Project - Copyright © 2024 Blocked Sequence Set Zip Code Processing System
+/**
+ * @file KeyIndex.h
+ * @brief Declaration of the KeyIndex interface shared by the primary key index formats.
+ *
+ * The format of index.idx is chosen by the index schema in the header record
+ * (HeaderRecord::setIndexSchema): string keys use a BPlusTree, 5-digit zip code keys
+ * can use a DenseIndex and 32-bit numeric keys a SortedIndex. Code that looks keys up
+ * only sees this interface.
+ */
+
+#ifndef KEY_INDEX_H
+#define KEY_INDEX_H
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @class KeyIndex
+ * @brief Persistent map from primary key to Relative Block Number.
+ *
+ * Keys are ordered with compareKeys(), the same order as the sequence set.
+ */
+class KeyIndex {
+public:
+    virtual ~KeyIndex() = default;
+
+    /**
+     * @brief Builds a new index file from entries sorted by key.
+     * @param fileName Path of the index file to create.
+     * @param entries Key and RBN pairs in ascending key order.
+     * @param pageSize Page size for paged formats, usually the block size.
+     * @return True if the index was written; it is left open on the new file.
+     */
+    virtual bool build(const std::string& fileName, const std::vector<std::pair<std::string, int>>& entries, int pageSize) = 0;
+
+    /**
+     * @brief Opens an existing index file.
+     * @param fileName Path of the index file.
+     * @param mapped True to map the file read-only; insert() and erase() then fail.
+     * @return True if the file holds a valid index of this format.
+     */
+    virtual bool open(const std::string& fileName, bool mapped = false) = 0;
+
+    /**
+     * @brief Closes the index file.
+     */
+    virtual void close() = 0;
+
+    /**
+     * @brief Looks up the RBN stored for a key.
+     * @param key Key to look up.
+     * @return RBN of the block holding the key, or -1 if the key is not indexed.
+     */
+    virtual int find(const std::string& key) = 0;
+
+    /**
+     * @brief Looks up many keys sorted with compareKeys() and free of duplicates.
+     *
+     * The default looks the keys up one by one.
+     *
+     * @param sortedKeys Keys to look up in ascending order.
+     * @param visit Called for each key, in order, with its RBN or -1 if it is not indexed.
+     */
+    virtual void findMany(const std::vector<std::string>& sortedKeys, const std::function<void(const std::string&, int)>& visit);
+
+    /**
+     * @brief Finds the largest indexed key.
+     * @param key Receives the largest key.
+     * @param RBN Receives the RBN stored for it.
+     * @return False if the index is empty.
+     */
+    virtual bool last(std::string& key, int& RBN) = 0;
+
+    /**
+     * @brief Inserts a key, or replaces the RBN of a key that is already indexed.
+     * @param key Key to insert.
+     * @param RBN Relative Block Number of the block holding the key.
+     * @return True if the index was updated.
+     */
+    virtual bool insert(const std::string& key, int RBN) = 0;
+
+    /**
+     * @brief Removes a key.
+     * @param key Key to remove.
+     * @return True if the key was indexed and has been removed.
+     */
+    virtual bool erase(const std::string& key) = 0;
+
+    /**
+     * @brief Visits entries in key order starting at the first key not less than low.
+     * @param low Smallest key to visit.
+     * @param visit Called with each key and RBN; return false to stop the scan.
+     */
+    virtual void scan(const std::string& low, const std::function<bool(const std::string&, int)>& visit) = 0;
+
+    /**
+     * @brief Describes the layout of the open index for messages, e.g. "4-level B+tree".
+     */
+    virtual std::string describe() const = 0;
+
+    virtual bool isOpen() const = 0;
+    virtual const std::string& getFileName() const = 0;
+    virtual int getEntryCount() const = 0;
+};
+
+/**
+ * @brief Creates an empty index of the format selected by an index schema.
+ *
+ * The schema is a comma separated list of name:type pairs such as "key:string,rbn:int".
+ * A key of type zip5 selects a DenseIndex, uint32 a SortedIndex; any other key type
+ * selects a BPlusTree.
+ *
+ * @param schema Index schema from the header record.
+ * @return A closed index of the selected format.
+ */
+std::unique_ptr<KeyIndex> makeKeyIndex(const std::string& schema);
+
+/**
+ * @brief Returns the type given to one name in an index schema.
+ * @param schema Index schema such as "key:zip5,rbn:int".
+ * @param name Name to look up, e.g. "key".
+ * @return The type, or an empty string if the schema does not name it.
+ */
+std::string schemaType(const std::string& schema, const std::string& name);
+
+#endif // KEY_INDEX_H
@@ -0,0 +1,93 @@
+// CSCI 331 Group Project - Copyright © 2024 Blocked Sequence Set Zip Code Processing System
+#include "MappedFile.h"
+#include <iostream>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+#ifdef _WIN32
+MappedFile::MappedFile()
+    : data(nullptr)
+    , size(0)
+    , fileHandle(INVALID_HANDLE_VALUE)
+    , mappingHandle(nullptr) {}
+#else
+MappedFile::MappedFile()
+    : data(nullptr)
+    , size(0) {}
+#endif
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+/**
+ * @brief Maps a file read-only, unmapping any file mapped before.
+ * @param fileName Path of the file to map.
+ * @return True if the file was mapped; an empty file cannot be mapped.
+ */
+bool MappedFile::open(const string& fileName) {
+    close();
+#ifdef _WIN32
+    fileHandle = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                             OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, nullptr);
+    LARGE_INTEGER length;
+    if (fileHandle == INVALID_HANDLE_VALUE || !GetFileSizeEx(fileHandle, &length) || length.QuadPart == 0) {
+        cerr << "Error: Could not map file: " << fileName << endl;
+        close();
+        return false;
+    }
+    mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    void* view = mappingHandle ? MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (view == nullptr) {
+        cerr << "Error: Could not map file: " << fileName << endl;
+        close();
+        return false;
+    }
+    size = static_cast<size_t>(length.QuadPart);
+#else
+    int fd = ::open(fileName.c_str(), O_RDONLY);
+    struct stat info;
+    if (fd < 0 || fstat(fd, &info) != 0 || info.st_size == 0) {
+        cerr << "Error: Could not map file: " << fileName << endl;
+        if (fd >= 0) ::close(fd);
+        return false;
+    }
+    void* view = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);  // The mapping keeps its own reference to the file
+    if (view == MAP_FAILED) {
+        cerr << "Error: Could not map file: " << fileName << endl;
+        return false;
+    }
+    // Lookups touch scattered blocks; do not read ahead around every fault
+    madvise(view, info.st_size, MADV_RANDOM);
+    size = static_cast<size_t>(info.st_size);
+#endif
+    data = static_cast<const char*>(view);
+    return true;
+}
+
+/**
+ * @brief Unmaps the file.
+ */
+void MappedFile::close() {
+#ifdef _WIN32
+    if (data != nullptr) UnmapViewOfFile(data);
+    if (mappingHandle != nullptr) CloseHandle(mappingHandle);
+    if (fileHandle != INVALID_HANDLE_VALUE) CloseHandle(fileHandle);
+    mappingHandle = nullptr;
+    fileHandle = INVALID_HANDLE_VALUE;
+#else
+    if (data != nullptr) munmap(const_cast<char*>(data), size);
+#endif
+    data = nullptr;
+    size = 0;
+}
@@ -0,0 +1,53 @@
+// CSCI 331 Group Project - Copyright © 2024 Blocked Sequence Set Zip Code Processing System
+/**
+ * @file MappedFile.h
+ * @brief Declaration of the MappedFile class, a read-only memory mapping of a whole file.
+ *
+ * The mapping is shared, so every process that maps the same file reads the same
+ * page cache copy, and nothing is read until a page is first touched.
+ */
+
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+
+/**
+ * @class MappedFile
+ * @brief Maps a file read-only into the address space (mmap, or a file mapping on Windows).
+ */
+class MappedFile {
+public:
+    MappedFile();
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /**
+     * @brief Maps a file read-only, unmapping any file mapped before.
+     * @param fileName Path of the file to map.
+     * @return True if the file was mapped; an empty file cannot be mapped.
+     */
+    bool open(const std::string& fileName);
+
+    /**
+     * @brief Unmaps the file.
+     */
+    void close();
+
+    bool isOpen() const { return data != nullptr; }
+    const char* getData() const { return data; }
+    size_t getSize() const { return size; }
+
+private:
+    const char* data;  ///< Start of the mapping, nullptr when nothing is mapped
+    size_t size;       ///< Length of the mapping in bytes
+#ifdef _WIN32
+    void* fileHandle;     ///< Handle of the mapped file
+    void* mappingHandle;  ///< Handle of the file mapping object
+#endif
+};
+
+#endif // MAPPED_FILE_H
@@ -0,0 +1,122 @@
+// CSCI 331 Group Project - Copyright © 2024 Blocked Sequence Set Zip Code Processing System
+#include "ParallelScan.h"
+#include "Block.h"
+#include "BlockView.h"
+#include "HeaderRecord.h"
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+/**
+ * @brief Number of workers used when none is requested.
+ * @return std::thread::hardware_concurrency(), or 1 if it is unknown.
+ */
+unsigned defaultScanWorkers() {
+    unsigned cores = thread::hardware_concurrency();
+    return cores > 0 ? cores : 1;
+}
+
+/**
+ * @brief Reads and visits one worker's slice of blocks.
+ *
+ * The slice is read sequentially through a private file handle, SCAN_READ_BLOCKS
+ * blocks per read call. Blocks of a compressed file are decompressed one at a time
+ * into a private buffer before they are visited.
+ *
+ * @param blockFile Path to the block file.
+ * @param header Header record of the block file.
+ * @param firstRBN First block of the slice.
+ * @param lastRBN Last block of the slice.
+ * @param worker Worker number passed on to visit.
+ * @param visit Visitor called for every block of the slice.
+ * @return Empty string on success, otherwise the error message.
+ */
+static string scanSlice(const string& blockFile, const HeaderRecord& header, int firstRBN, int lastRBN, unsigned worker,
+                        const function<void(unsigned, int, const BlockView&)>& visit) {
+    ifstream in(blockFile, ios::binary);
+    if (!in.is_open()) return "Could not open block file: " + blockFile;
+
+    size_t blockSize = header.getBlockSize();
+    size_t storedSize = storedBlockSize(header);
+    bool compressed = header.getCompressedBlockSize() > 0;
+    size_t fieldCount = recordFieldCount(header);
+    vector<char> buffer(storedSize * SCAN_READ_BLOCKS);
+    vector<char> image(compressed ? blockSize : 0);
+    BlockView view;
+
+    in.seekg(blockOffset(header, firstRBN));
+    for (int RBN = firstRBN; RBN <= lastRBN; RBN += SCAN_READ_BLOCKS) {
+        int count = min(SCAN_READ_BLOCKS, lastRBN - RBN + 1);
+        if (!in.read(buffer.data(), storedSize * count)) {
+            return "Could not read block " + to_string(RBN) + " of " + blockFile;
+        }
+        for (int i = 0; i < count; i++) {
+            const char* data = buffer.data() + i * storedSize;
+            if (compressed) {
+                if (!expandBlock(header, data, image.data())) {
+                    return "Block " + to_string(RBN + i) + " could not be decompressed";
+                }
+                data = image.data();
+            }
+            if (!view.reset(data, blockSize, fieldCount)) {
+                return "Block " + to_string(RBN + i) + " is malformed";
+            }
+            visit(worker, RBN + i, view);
+        }
+    }
+    return "";
+}
+
+/**
+ * @brief Visits a range of blocks of a block file with several worker threads.
+ *
+ * Worker w gets the w-th of `workers` equal slices of [firstRBN, lastRBN]; the calling
+ * thread runs the first slice itself and waits for the others.
+ *
+ * @param blockFile Path to the block file.
+ * @param header Header record of the block file.
+ * @param firstRBN First block to visit.
+ * @param lastRBN Last block to visit.
+ * @param workers Number of worker threads; 0 selects defaultScanWorkers().
+ * @param visit Called as visit(worker, RBN, view) from the worker's thread.
+ * @return False if a worker could not open, read or decode its slice.
+ */
+bool parallelScan(const string& blockFile, const HeaderRecord& header, int firstRBN, int lastRBN,
+                  unsigned workers, const function<void(unsigned, int, const BlockView&)>& visit) {
+    if (firstRBN < 1 || lastRBN < firstRBN) return true;
+    if (workers == 0) workers = defaultScanWorkers();
+
+    long long total = lastRBN - firstRBN + 1;
+    auto sliceStart = [&](unsigned w) {
+        return static_cast<int>(firstRBN + total * w / workers);
+    };
+
+    vector<string> errors(workers);
+    vector<thread> threads;
+    for (unsigned w = 1; w < workers; w++) {
+        if (sliceStart(w + 1) > sliceStart(w)) {
+            threads.emplace_back([&, w]() {
+                errors[w] = scanSlice(blockFile, header, sliceStart(w), sliceStart(w + 1) - 1, w, visit);
+            });
+        }
+    }
+    if (sliceStart(1) > firstRBN) {
+        errors[0] = scanSlice(blockFile, header, firstRBN, sliceStart(1) - 1, 0, visit);
+    }
+    for (thread& worker : threads) {
+        worker.join();
+    }
+
+    bool ok = true;
+    for (const string& error : errors) {
+        if (!error.empty()) {
+            cerr << "Error: " << error << endl;
+            ok = false;
+        }
+    }
+    return ok;
+}
@@ -0,0 +1,47 @@
+// CSCI 331 Group Project - Copyright © 2024 Blocked Sequence Set Zip Code Processing System
+/**
+ * @file ParallelScan.h
+ * @brief Declaration of the parallel block scan used by the full-file operations.
+ *
+ * A scan splits a range of RBNs into one contiguous slice per worker thread. Workers
+ * read their slice through their own file handle and buffer, so the only shared state
+ * is whatever the visitor touches; callers keep per-worker partial results and
+ * combine them after the scan.
+ */
+
+#ifndef PARALLEL_SCAN_H
+#define PARALLEL_SCAN_H
+
+#include <functional>
+#include <string>
+
+class BlockView;
+class HeaderRecord;
+
+/// Blocks a worker reads from its file handle at a time.
+const int SCAN_READ_BLOCKS = 64;
+
+/**
+ * @brief Number of workers used when none is requested.
+ * @return std::thread::hardware_concurrency(), or 1 if it is unknown.
+ */
+unsigned defaultScanWorkers();
+
+/**
+ * @brief Visits a range of blocks of a block file with several worker threads.
+ *
+ * Worker w gets the w-th of `workers` equal slices of [firstRBN, lastRBN] and visits
+ * its blocks in RBN order. Every block is visited once, available blocks included.
+ *
+ * @param blockFile Path to the block file.
+ * @param header Header record of the block file.
+ * @param firstRBN First block to visit.
+ * @param lastRBN Last block to visit.
+ * @param workers Number of worker threads; 0 selects defaultScanWorkers().
+ * @param visit Called as visit(worker, RBN, view) from the worker's thread.
+ * @return False if a worker could not open, read or decode its slice.
+ */
+bool parallelScan(const std::string& blockFile, const HeaderRecord& header, int firstRBN, int lastRBN,
+                  unsigned workers, const std::function<void(unsigned, int, const BlockView&)>& visit);
+
+#endif // PARALLEL_SCAN_H
@@ -0,0 +1,338 @@
+// CSCI 331 Group Project - Copyright © 2024 Blocked Sequence Set Zip Code Processing System
+#include "PrefixTrie.h"
+#include "Block.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <queue>
+
+using namespace std;
+
+/// Identifies a file written by PrefixTrie.
+static const char TRIE_MAGIC[4] = { 'P', 'T', 'R', '1' };
+
+/// Bytes of the file header.
+static const size_t TRIE_HEADER_SIZE = 32;
+
+/// Bytes of one node in the file.
+static const size_t TRIE_NODE_SIZE = 28;
+
+/**
+ * @brief Names the trie file saved next to an index file ("index.idx" -> "index.trie").
+ * @param indexName Path of the index file.
+ * @return Path of the trie file.
+ */
+string trieFileName(const string& indexName) {
+    size_t dot = indexName.find_last_of('.');
+    size_t slash = indexName.find_last_of("/\\");
+    if (dot == string::npos || (slash != string::npos && dot < slash)) return indexName + ".trie";
+    return indexName.substr(0, dot) + ".trie";
+}
+
+/**
+ * @brief Folds a name to lower case, the form the trie is searched in.
+ */
+static string foldName(const string& name) {
+    string folded = name.substr(0, UINT16_MAX);
+    for (char& c : folded) c = static_cast<char>(tolower(static_cast<unsigned char>(c)));
+    return folded;
+}
+
+/**
+ * @brief Appends a string with a 16-bit length prefix to a pool.
+ */
+static void putString(string& pool, const string& text) {
+    uint16_t length = static_cast<uint16_t>(min<size_t>(text.size(), UINT16_MAX));
+    pool.append(reinterpret_cast<const char*>(&length), 2);
+    pool.append(text, 0, length);
+}
+
+/**
+ * @brief Reads a string with a 16-bit length prefix from a pool.
+ * @return False if the string runs past the end of the pool.
+ */
+static bool getString(const char* pool, uint32_t poolSize, uint32_t& offset, string& out) {
+    uint16_t length;
+    if (offset + 2 > poolSize) return false;
+    memcpy(&length, pool + offset, 2);
+    if (offset + 2 + length > poolSize) return false;
+    out.assign(pool + offset + 2, length);
+    offset += 2 + length;
+    return true;
+}
+
+/**
+ * @brief Builds the trie from (place name, primary key) pairs, saves it and maps it.
+ *
+ * The folded names are sorted, and each node covers a range of them sharing a prefix:
+ * its label runs to the longest common prefix of the range, and the rest of the range
+ * is split by the next byte into its children. Nodes are numbered breadth-first.
+ *
+ * @param fileName Path of the trie file to create.
+ * @param entries Place name and primary key pairs in any order.
+ * @return True if the file was written and mapped.
+ */
+bool PrefixTrie::build(const string& fileName, const vector<pair<string, string>>& entries) {
+    struct Name {
+        string display;
+        vector<string> keys;
+    };
+    map<string, Name> names;
+    for (const auto& entry : entries) {
+        if (entry.first.empty()) continue;
+        Name& name = names[foldName(entry.first)];
+        if (name.display.empty()) name.display = entry.first;
+        name.keys.push_back(entry.second);
+    }
+    vector<const string*> sorted;
+    vector<Name*> values;
+    for (auto& name : names) {
+        sort(name.second.keys.begin(), name.second.keys.end(),
+             [](const string& a, const string& b) { return compareKeys(a, b) < 0; });
+        name.second.keys.erase(unique(name.second.keys.begin(), name.second.keys.end()), name.second.keys.end());
+        sorted.push_back(&name.first);
+        values.push_back(&name.second);
+    }
+
+    struct Pending {
+        uint32_t node;
+        size_t low, high, depth;
+    };
+    vector<Node> nodes(1, Node{});
+    string textPool, keyPool;
+    uint32_t keys = 0;
+    deque<Pending> pending = { { 0, 0, sorted.size(), 0 } };
+    while (!pending.empty()) {
+        Pending range = pending.front();
+        pending.pop_front();
+        Node next{};
+        next.labelOffset = static_cast<uint32_t>(textPool.size());
+        size_t end = range.depth;
+        if (range.low < range.high) {
+            const string& first = *sorted[range.low];
+            const string& last = *sorted[range.high - 1];
+            while (end < first.size() && end < last.size() && first[end] == last[end]) end++;
+            textPool.append(first, range.depth, end - range.depth);
+            next.labelLength = static_cast<uint16_t>(end - range.depth);
+
+            // The range is sorted, so the name ending at this node, if any, comes first
+            if (first.size() == end) {
+                const Name& name = *values[range.low];
+                next.nameOffset = static_cast<uint32_t>(textPool.size());
+                putString(textPool, name.display);
+                next.keyOffset = static_cast<uint32_t>(keyPool.size());
+                next.keyCount = static_cast<uint32_t>(name.keys.size());
+                for (const string& key : name.keys) putString(keyPool, key);
+                keys += next.keyCount;
+                range.low++;
+            }
+        }
+
+        next.firstChild = static_cast<uint32_t>(nodes.size());
+        for (size_t low = range.low; low < range.high;) {
+            size_t high = low;
+            while (high < range.high && (*sorted[high])[end] == (*sorted[low])[end]) high++;
+            pending.push_back({ static_cast<uint32_t>(nodes.size()), low, high, end });
+            nodes.push_back(Node{});
+            next.childCount++;
+            low = high;
+        }
+        nodes[range.node] = next;
+    }
+
+    // Children are numbered after their parent, so a backward pass sees them first
+    for (size_t i = nodes.size(); i-- > 0;) {
+        nodes[i].bestCount = nodes[i].keyCount;
+        for (uint32_t c = 0; c < nodes[i].childCount; c++) {
+            nodes[i].bestCount = max(nodes[i].bestCount, nodes[nodes[i].firstChild + c].bestCount);
+        }
+    }
+
+    uint32_t header[8] = {};
+    memcpy(header, TRIE_MAGIC, 4);
+    header[1] = static_cast<uint32_t>(nodes.size());
+    header[2] = static_cast<uint32_t>(names.size());
+    header[3] = keys;
+    header[4] = static_cast<uint32_t>(TRIE_HEADER_SIZE + nodes.size() * TRIE_NODE_SIZE);
+    header[5] = static_cast<uint32_t>(textPool.size());
+    header[6] = header[4] + header[5];
+    header[7] = static_cast<uint32_t>(keyPool.size());
+
+    // The file may be mapped by this trie; unmap it before it is rewritten
+    close();
+    ofstream out(fileName, ios::binary | ios::trunc);
+    if (!out.is_open()) {
+        cerr << "Error: Could not create trie file: " << fileName << endl;
+        return false;
+    }
+    out.write(reinterpret_cast<const char*>(header), TRIE_HEADER_SIZE);
+    out.write(reinterpret_cast<const char*>(nodes.data()), nodes.size() * TRIE_NODE_SIZE);
+    out.write(textPool.data(), textPool.size());
+    out.write(keyPool.data(), keyPool.size());
+    out.close();
+    if (!out) {
+        cerr << "Error: Could not write trie file: " << fileName << endl;
+        return false;
+    }
+    return open(fileName);
+}
+
+/**
+ * @brief Maps a trie file, unmapping any file mapped before.
+ * @param fileName Path of the trie file.
+ * @return True if the file holds a trie.
+ */
+bool PrefixTrie::open(const string& fileName) {
+    static_assert(sizeof(Node) == TRIE_NODE_SIZE, "trie nodes are stored as raw 28-byte records");
+    close();
+    this->fileName = fileName;
+    if (!file.open(fileName)) {
+        cerr << "Error: Could not map trie file: " << fileName << endl;
+        return false;
+    }
+
+    uint32_t header[8];
+    bool valid = file.getSize() >= TRIE_HEADER_SIZE && memcmp(file.getData(), TRIE_MAGIC, 4) == 0;
+    if (valid) {
+        memcpy(header, file.getData(), TRIE_HEADER_SIZE);
+        valid = header[1] > 0
+            && TRIE_HEADER_SIZE + static_cast<uint64_t>(header[1]) * TRIE_NODE_SIZE <= header[4]
+            && static_cast<uint64_t>(header[4]) + header[5] <= header[6]
+            && static_cast<uint64_t>(header[6]) + header[7] <= file.getSize();
+    }
+    if (!valid) {
+        cerr << "Error: " << fileName << " is not a trie file" << endl;
+        close();
+        return false;
+    }
+    nodeCount = header[1];
+    nameCount = header[2];
+    keyCount = header[3];
+    textPool = file.getData() + header[4];
+    textSize = header[5];
+    keyPool = file.getData() + header[6];
+    keySize = header[7];
+    return true;
+}
+
+/**
+ * @brief Unmaps the trie file.
+ */
+void PrefixTrie::close() {
+    file.close();
+    nodeCount = nameCount = keyCount = 0;
+    textPool = keyPool = nullptr;
+    textSize = keySize = 0;
+}
+
+/**
+ * @brief Copies one node out of the mapping.
+ * @return False if the node number is out of range.
+ */
+bool PrefixTrie::node(uint32_t number, Node& out) const {
+    if (number >= nodeCount) return false;
+    memcpy(&out, file.getData() + TRIE_HEADER_SIZE + static_cast<size_t>(number) * TRIE_NODE_SIZE, TRIE_NODE_SIZE);
+    return true;
+}
+
+/**
+ * @brief Copies a slice of the text pool.
+ * @return False if the slice runs past the end of the pool.
+ */
+bool PrefixTrie::text(uint32_t offset, uint32_t length, string& out) const {
+    if (static_cast<uint64_t>(offset) + length > textSize) return false;
+    out.assign(textPool + offset, length);
+    return true;
+}
+
+/**
+ * @brief Finds the k names starting with a prefix that have the most zip codes.
+ *
+ * The prefix is followed down from the root to the node covering it. Its subtree is
+ * then searched best-first: a queue holds subtrees by their largest key count and
+ * names by their own key count, so names come out of it by key count, ties in name
+ * order, and only the subtrees that may hold one of the first k are opened.
+ *
+ * @param prefix Start of the name, in any case; an empty prefix matches every name.
+ * @param k Number of completions to return.
+ * @return Up to k completions by key count, most first, ties in name order.
+ */
+vector<PrefixMatch> PrefixTrie::complete(const string& prefix, size_t k) const {
+    vector<PrefixMatch> matches;
+    string folded = foldName(prefix), path, label;
+    Node current;
+    uint32_t number = 0;
+    if (k == 0 || !node(number, current)) return matches;
+
+    // Descend to the node whose path starts with the prefix
+    size_t matched = 0;
+    while (true) {
+        if (!text(current.labelOffset, current.labelLength, label)) return matches;
+        size_t length = min(label.size(), folded.size() - matched);
+        if (folded.compare(matched, length, label, 0, length) != 0) return matches;
+        path += label;
+        matched += length;
+        if (matched == folded.size()) break;
+
+        // Children are sorted by the first byte of their label
+        uint32_t low = 0, high = current.childCount;
+        Node child;
+        string childLabel;
+        while (low < high) {
+            uint32_t mid = low + (high - low) / 2;
+            if (!node(current.firstChild + mid, child) || !text(child.labelOffset, 1, childLabel)) return matches;
+            if (static_cast<unsigned char>(childLabel[0]) < static_cast<unsigned char>(folded[matched])) low = mid + 1;
+            else high = mid;
+        }
+        if (low == current.childCount || !node(current.firstChild + low, child)
+            || !text(child.labelOffset, 1, childLabel) || childLabel[0] != folded[matched]) {
+            return matches;
+        }
+        number = current.firstChild + low;
+        current = child;
+    }
+
+    struct Item {
+        uint32_t count;  ///< Key count of the name, or largest key count of the subtree
+        string path;     ///< Folded name, or folded path to the end of the subtree's label
+        uint32_t node;
+        bool name;       ///< True for the name ending at node, false for the subtree of node
+    };
+    auto later = [](const Item& a, const Item& b) {
+        if (a.count != b.count) return a.count < b.count;
+        if (a.path != b.path) return a.path > b.path;
+        return !a.name && b.name;
+    };
+    priority_queue<Item, vector<Item>, decltype(later)> queue(later);
+    queue.push({ current.bestCount, path, number, false });
+    while (!queue.empty() && matches.size() < k) {
+        Item item = queue.top();
+        queue.pop();
+        if (!node(item.node, current)) break;
+
+        if (item.name) {
+            PrefixMatch match;
+            uint32_t offset = current.nameOffset;
+            if (!getString(textPool, textSize, offset, match.name)) break;
+            offset = current.keyOffset;
+            match.keys.resize(current.keyCount);
+            for (string& key : match.keys) {
+                if (!getString(keyPool, keySize, offset, key)) break;
+            }
+            matches.push_back(move(match));
+            continue;
+        }
+
+        if (current.keyCount > 0) queue.push({ current.keyCount, item.path, item.node, true });
+        for (uint32_t c = 0; c < current.childCount; c++) {
+            Node child;
+            if (!node(current.firstChild + c, child) || !text(child.labelOffset, child.labelLength, label)) break;
+            queue.push({ child.bestCount, item.path + label, current.firstChild + c, false });
+        }
+    }
+    return matches;
+}
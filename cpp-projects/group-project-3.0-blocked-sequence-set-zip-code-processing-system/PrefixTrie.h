@@ -0,0 +1,113 @@
+// CSCI 331 Group Project - Copyright © 2024 Blocked Sequence Set Zip Code Processing System
+/**
+ * @file PrefixTrie.h
+ * @brief Declaration of the PrefixTrie class, a persisted radix tree over place names
+ *        answering top-k prefix completions from a read-only memory mapping.
+ *
+ * Names are folded to lower case, so "holts" and "Holts" both complete to Holtsville.
+ * The file ("index.idx" -> "index.trie") holds a 32-byte header (magic "PTR1", node
+ * count, name count, key count, then offset and size of the text and key pools), the
+ * nodes as fixed 28-byte records in breadth-first order so the children of a node are
+ * contiguous and sorted by the first byte of their label, a text pool of edge labels and
+ * length-prefixed display names, and a pool of length-prefixed primary keys.
+ *
+ * Every node stores the largest key count in its subtree, so the completions with the
+ * most zip codes are found best-first without visiting the rest of the subtree.
+ */
+
+#ifndef PREFIX_TRIE_H
+#define PREFIX_TRIE_H
+
+#include "MappedFile.h"
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Names the trie file saved next to an index file ("index.idx" -> "index.trie").
+ * @param indexName Path of the index file.
+ * @return Path of the trie file.
+ */
+std::string trieFileName(const std::string& indexName);
+
+/**
+ * @brief One completion of a prefix.
+ */
+struct PrefixMatch {
+    std::string name;               ///< Place name as first seen in the records
+    std::vector<std::string> keys;  ///< Primary keys of the records with the name, in compareKeys() order
+};
+
+/**
+ * @class PrefixTrie
+ * @brief Compressed trie of place names with the primary keys of each name, read through mmap.
+ *
+ * The trie is immutable; it is rebuilt and remapped by build() after the records change.
+ */
+class PrefixTrie {
+public:
+    /**
+     * @brief Builds the trie from (place name, primary key) pairs, saves it and maps it.
+     * @param fileName Path of the trie file to create.
+     * @param entries Place name and primary key pairs in any order.
+     * @return True if the file was written and mapped.
+     */
+    bool build(const std::string& fileName, const std::vector<std::pair<std::string, std::string>>& entries);
+
+    /**
+     * @brief Maps a trie file, unmapping any file mapped before.
+     * @param fileName Path of the trie file.
+     * @return True if the file holds a trie.
+     */
+    bool open(const std::string& fileName);
+
+    /**
+     * @brief Unmaps the trie file.
+     */
+    void close();
+
+    /**
+     * @brief Finds the k names starting with a prefix that have the most zip codes.
+     * @param prefix Start of the name, in any case; an empty prefix matches every name.
+     * @param k Number of completions to return.
+     * @return Up to k completions by key count, most first, ties in name order.
+     */
+    std::vector<PrefixMatch> complete(const std::string& prefix, size_t k) const;
+
+    bool isOpen() const { return file.isOpen(); }
+    const std::string& getFileName() const { return fileName; }
+    uint32_t getNodeCount() const { return nodeCount; }
+    uint32_t getNameCount() const { return nameCount; }
+    uint32_t getKeyCount() const { return keyCount; }
+
+private:
+    /**
+     * @brief One node as stored in the file.
+     */
+    struct Node {
+        uint32_t labelOffset;  ///< Edge label in the text pool
+        uint16_t labelLength;  ///< Bytes of the edge label
+        uint16_t childCount;   ///< Number of children
+        uint32_t firstChild;   ///< Node number of the first child
+        uint32_t nameOffset;   ///< Display name in the text pool, if keyCount > 0
+        uint32_t keyOffset;    ///< First key in the key pool, if keyCount > 0
+        uint32_t keyCount;     ///< Keys of the name ending at this node
+        uint32_t bestCount;    ///< Largest keyCount in the subtree
+    };
+
+    bool node(uint32_t number, Node& out) const;
+    bool text(uint32_t offset, uint32_t length, std::string& out) const;
+
+    MappedFile file;            ///< Mapping of the trie file
+    std::string fileName;       ///< Path of the mapped file
+    uint32_t nodeCount = 0;     ///< Nodes in the file
+    uint32_t nameCount = 0;     ///< Distinct folded names
+    uint32_t keyCount = 0;      ///< Keys over all names
+    const char* textPool = nullptr;  ///< Start of the text pool inside the mapping
+    uint32_t textSize = 0;           ///< Bytes of the text pool
+    const char* keyPool = nullptr;   ///< Start of the key pool inside the mapping
+    uint32_t keySize = 0;            ///< Bytes of the key pool
+};
+
+#endif // PREFIX_TRIE_H
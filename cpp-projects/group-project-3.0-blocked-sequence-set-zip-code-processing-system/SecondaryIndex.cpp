@@ -0,0 +1,221 @@
+// CSCI 331 Group Project - Copyright © 2024 Blocked Sequence Set Zip Code Processing System
+#include "SecondaryIndex.h"
+#include "Block.h"
+#include "HeaderRecord.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+using namespace std;
+
+/// Identifies a file written by SecondaryIndex.
+static const char SECONDARY_MAGIC[4] = { 'S', 'D', 'X', '1' };
+
+/// Bytes of the file header (magic, value count, key count, reserved).
+static const size_t SECONDARY_HEADER_SIZE = 16;
+
+/**
+ * @brief Orders primary keys like the sequence set.
+ */
+static bool keyLess(const string& a, const string& b) {
+    return compareKeys(a, b) < 0;
+}
+
+/**
+ * @brief Tells whether a field is declared with a secondary index.
+ * @param field Field metadata from the header record.
+ * @return True if the type schema ends with SECONDARY_INDEX_TAG.
+ */
+bool hasSecondaryIndex(const FieldMetadata& field) {
+    size_t tagLength = strlen(SECONDARY_INDEX_TAG);
+    return field.typeSchema.size() >= tagLength
+        && field.typeSchema.compare(field.typeSchema.size() - tagLength, tagLength, SECONDARY_INDEX_TAG) == 0;
+}
+
+/**
+ * @brief Names the secondary index file of a field ("index.idx", "state" -> "index.state.sdx").
+ * @param indexName Path of the primary index file.
+ * @param fieldName Name of the indexed field.
+ * @return Path of the secondary index file.
+ */
+string secondaryIndexFileName(const string& indexName, const string& fieldName) {
+    size_t dot = indexName.find_last_of('.');
+    size_t slash = indexName.find_last_of("/\\");
+    string base = (dot == string::npos || (slash != string::npos && dot < slash)) ? indexName : indexName.substr(0, dot);
+    return base + "." + fieldName + ".sdx";
+}
+
+SecondaryIndex::SecondaryIndex()
+    : keyCount(0)
+    , loaded(false)
+    , dirty(false) {}
+
+/**
+ * @brief Replaces the contents with (value, primary key) pairs and saves them to a file.
+ * @param fileName Path of the index file to create.
+ * @param entries Value and primary key pairs in any order.
+ * @return True if the file was written.
+ */
+bool SecondaryIndex::build(const string& fileName, vector<pair<string, string>> entries) {
+    postings.clear();
+    keyCount = entries.size();
+    for (auto& entry : entries) {
+        postings[entry.first].push_back(move(entry.second));
+    }
+    for (auto& posting : postings) {
+        sort(posting.second.begin(), posting.second.end(), keyLess);
+    }
+    this->fileName = fileName;
+    loaded = true;
+    dirty = true;
+    return save();
+}
+
+/**
+ * @brief Appends a length-prefixed string to a file image.
+ */
+static void putString(string& image, const string& text) {
+    uint16_t length = static_cast<uint16_t>(min<size_t>(text.size(), UINT16_MAX));
+    image.append(reinterpret_cast<const char*>(&length), 2);
+    image.append(text, 0, length);
+}
+
+/**
+ * @brief Writes the index to its file if it changed since it was loaded or saved.
+ * @return True if the file is up to date.
+ */
+bool SecondaryIndex::save() {
+    if (!loaded || !dirty) return loaded;
+    string image(SECONDARY_HEADER_SIZE, '\0');
+    uint32_t valueCount = static_cast<uint32_t>(postings.size()), keys = static_cast<uint32_t>(keyCount);
+    memcpy(&image[0], SECONDARY_MAGIC, 4);
+    memcpy(&image[4], &valueCount, 4);
+    memcpy(&image[8], &keys, 4);
+    for (const auto& posting : postings) {
+        putString(image, posting.first);
+        uint32_t count = static_cast<uint32_t>(posting.second.size());
+        image.append(reinterpret_cast<const char*>(&count), 4);
+        for (const string& key : posting.second) {
+            putString(image, key);
+        }
+    }
+
+    ofstream out(fileName, ios::binary | ios::trunc);
+    if (!out.is_open()) {
+        cerr << "Error: Could not create secondary index file: " << fileName << endl;
+        return false;
+    }
+    out.write(image.data(), image.size());
+    if (!out.good()) {
+        cerr << "Error: Could not write secondary index file: " << fileName << endl;
+        return false;
+    }
+    dirty = false;
+    return true;
+}
+
+/**
+ * @brief Loads an index file.
+ * @param fileName Path of the index file.
+ * @return True if the file holds a secondary index.
+ */
+bool SecondaryIndex::load(const string& fileName) {
+    postings.clear();
+    keyCount = 0;
+    loaded = false;
+    dirty = false;
+    this->fileName = fileName;
+
+    ifstream in(fileName, ios::binary);
+    if (!in.is_open()) {
+        cerr << "Error: Could not open secondary index file: " << fileName << endl;
+        return false;
+    }
+    string image((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+
+    size_t pos = SECONDARY_HEADER_SIZE;
+    auto getWord = [&image, &pos](uint32_t& word) {
+        if (pos + 4 > image.size()) return false;
+        memcpy(&word, image.data() + pos, 4);
+        pos += 4;
+        return true;
+    };
+    auto getString = [&image, &pos](string& text) {
+        uint16_t length;
+        if (pos + 2 > image.size()) return false;
+        memcpy(&length, image.data() + pos, 2);
+        if (pos + 2 + length > image.size()) return false;
+        text.assign(image, pos + 2, length);
+        pos += 2 + length;
+        return true;
+    };
+
+    uint32_t valueCount = 0;
+    bool valid = image.size() >= SECONDARY_HEADER_SIZE && memcmp(image.data(), SECONDARY_MAGIC, 4) == 0;
+    if (valid) memcpy(&valueCount, image.data() + 4, 4);
+    for (uint32_t v = 0; valid && v < valueCount; v++) {
+        string value;
+        uint32_t count = 0;
+        valid = getString(value) && getWord(count);
+        vector<string>& keys = postings[value];
+        for (uint32_t k = 0; valid && k < count; k++) {
+            keys.emplace_back();
+            valid = getString(keys.back());
+        }
+        keyCount += count;
+    }
+    if (!valid) {
+        cerr << "Error: " << fileName << " is not a secondary index file" << endl;
+        postings.clear();
+        keyCount = 0;
+        return false;
+    }
+    loaded = true;
+    return true;
+}
+
+/**
+ * @brief Returns the primary keys of the records holding a value.
+ * @param value Field value, matched exactly.
+ * @return Primary keys in compareKeys() order, or nullptr if no record holds the value.
+ */
+const vector<string>* SecondaryIndex::find(const string& value) const {
+    auto posting = postings.find(value);
+    return posting == postings.end() ? nullptr : &posting->second;
+}
+
+/**
+ * @brief Adds a primary key to the posting list of a value.
+ * @param value Field value of the record.
+ * @param key Primary key of the record.
+ */
+void SecondaryIndex::add(const string& value, const string& key) {
+    vector<string>& keys = postings[value];
+    auto at = lower_bound(keys.begin(), keys.end(), key, keyLess);
+    if (at != keys.end() && *at == key) return;
+    keys.insert(at, key);
+    keyCount++;
+    dirty = true;
+}
+
+/**
+ * @brief Removes a primary key from the posting list of a value.
+ * @param value Field value of the record.
+ * @param key Primary key of the record.
+ * @return True if the key was listed under the value.
+ */
+bool SecondaryIndex::remove(const string& value, const string& key) {
+    auto posting = postings.find(value);
+    if (posting == postings.end()) return false;
+    vector<string>& keys = posting->second;
+    auto at = lower_bound(keys.begin(), keys.end(), key, keyLess);
+    if (at == keys.end() || *at != key) return false;
+    keys.erase(at);
+    if (keys.empty()) postings.erase(posting);
+    keyCount--;
+    dirty = true;
+    return true;
+}
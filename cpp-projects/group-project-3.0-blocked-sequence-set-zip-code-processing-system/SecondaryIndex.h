@@ -0,0 +1,113 @@
+// CSCI 331 Group Project - Copyright © 2024 Blocked Sequence Set Zip Code Processing System
+/**
+ * @file SecondaryIndex.h
+ * @brief Declaration of the SecondaryIndex class, a persistent map from a field value to
+ *        the primary keys of the records holding it.
+ *
+ * A field gets a secondary index when its type schema in the header record ends with
+ * SECONDARY_INDEX_TAG, e.g. "string(2) indexed". Each index lives in its own file next
+ * to the primary index ("index.idx" -> "index.state.sdx"): a 16-byte header (magic
+ * "SDX1", value count, key count, reserved) followed by the values in ascending order,
+ * each a length-prefixed value, a key count and the length-prefixed primary keys.
+ *
+ * Posting lists hold primary keys rather than RBNs, so records moving between blocks
+ * never touch a secondary index; the keys are resolved through the primary index.
+ */
+
+#ifndef SECONDARY_INDEX_H
+#define SECONDARY_INDEX_H
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+struct FieldMetadata;
+
+/// Suffix of a field type schema that asks for a secondary index on the field.
+const char* const SECONDARY_INDEX_TAG = " indexed";
+
+/**
+ * @brief Tells whether a field is declared with a secondary index.
+ * @param field Field metadata from the header record.
+ * @return True if the type schema ends with SECONDARY_INDEX_TAG.
+ */
+bool hasSecondaryIndex(const FieldMetadata& field);
+
+/**
+ * @brief Names the secondary index file of a field ("index.idx", "state" -> "index.state.sdx").
+ * @param indexName Path of the primary index file.
+ * @param fieldName Name of the indexed field.
+ * @return Path of the secondary index file.
+ */
+std::string secondaryIndexFileName(const std::string& indexName, const std::string& fieldName);
+
+/**
+ * @class SecondaryIndex
+ * @brief Field value to posting list of primary keys, loaded into memory.
+ *
+ * Posting lists are kept in compareKeys() order. Changes are made in memory and
+ * written back by save().
+ */
+class SecondaryIndex {
+public:
+    SecondaryIndex();
+
+    /**
+     * @brief Replaces the contents with (value, primary key) pairs and saves them to a file.
+     * @param fileName Path of the index file to create.
+     * @param entries Value and primary key pairs in any order.
+     * @return True if the file was written.
+     */
+    bool build(const std::string& fileName, std::vector<std::pair<std::string, std::string>> entries);
+
+    /**
+     * @brief Loads an index file.
+     * @param fileName Path of the index file.
+     * @return True if the file holds a secondary index.
+     */
+    bool load(const std::string& fileName);
+
+    /**
+     * @brief Writes the index to its file if it changed since it was loaded or saved.
+     * @return True if the file is up to date.
+     */
+    bool save();
+
+    /**
+     * @brief Returns the primary keys of the records holding a value.
+     * @param value Field value, matched exactly.
+     * @return Primary keys in compareKeys() order, or nullptr if no record holds the value.
+     */
+    const std::vector<std::string>* find(const std::string& value) const;
+
+    /**
+     * @brief Adds a primary key to the posting list of a value.
+     * @param value Field value of the record.
+     * @param key Primary key of the record.
+     */
+    void add(const std::string& value, const std::string& key);
+
+    /**
+     * @brief Removes a primary key from the posting list of a value.
+     * @param value Field value of the record.
+     * @param key Primary key of the record.
+     * @return True if the key was listed under the value.
+     */
+    bool remove(const std::string& value, const std::string& key);
+
+    bool isLoaded() const { return loaded; }
+    bool isDirty() const { return dirty; }
+    const std::string& getFileName() const { return fileName; }
+    size_t getValueCount() const { return postings.size(); }
+    size_t getKeyCount() const { return keyCount; }
+
+private:
+    std::string fileName;                                     ///< Path of the index file
+    std::map<std::string, std::vector<std::string>> postings; ///< Primary keys per field value
+    size_t keyCount;                                          ///< Keys over all posting lists
+    bool loaded;                                              ///< True once built or loaded
+    bool dirty;                                               ///< True if changed since the last save
+};
+
+#endif // SECONDARY_INDEX_H
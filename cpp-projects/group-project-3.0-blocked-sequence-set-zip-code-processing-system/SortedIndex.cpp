@@ -0,0 +1,367 @@
+// CSCI 331 Group Project - Copyright © 2024 Blocked Sequence Set Zip Code Processing System
+#include "SortedIndex.h"
+#include <cstring>
+#include <iostream>
+
+using namespace std;
+
+/// Identifies an index file written by SortedIndex.
+static const char SORTED_MAGIC[4] = { 'S', 'I', 'X', '1' };
+
+/// Bytes of the file header (magic, entry count, smallest key, largest key).
+static const size_t SORTED_HEADER_SIZE = 16;
+
+/// Bytes before the first entry: the header and one guide slot per bucket boundary.
+static const size_t SORTED_ENTRIES_OFFSET = SORTED_HEADER_SIZE + (SORTED_GUIDE_BUCKETS + 1) * 4;
+
+/// Bytes per entry: uint32 key and uint32 RBN.
+static const size_t SORTED_ENTRY_SIZE = 8;
+
+SortedIndex::SortedIndex()
+    : guide(nullptr)
+    , entries(nullptr)
+    , count(0)
+    , minKey(0)
+    , maxKey(0)
+    , lookups(0)
+    , probes(0) {}
+
+/**
+ * @brief Converts a key to the numeric key of a sorted index.
+ * @param key Key such as "501" or "00501".
+ * @param value Receives the numeric value.
+ * @return False if the key is not all digits or does not fit in 32 bits.
+ */
+bool sortedIndexKey(const string& key, uint32_t& value) {
+    if (key.empty()) return false;
+    uint64_t number = 0;
+    for (char c : key) {
+        if (c < '0' || c > '9') return false;
+        number = number * 10 + (c - '0');
+        if (number > UINT32_MAX) return false;
+    }
+    value = static_cast<uint32_t>(number);
+    return true;
+}
+
+/**
+ * @brief Returns the guide table bucket of a key inside the indexed key range.
+ * @param key Key between minKey and maxKey.
+ * @param minKey Smallest indexed key.
+ * @param maxKey Largest indexed key.
+ * @return Bucket number below SORTED_GUIDE_BUCKETS.
+ */
+static size_t guideBucket(uint32_t key, uint32_t minKey, uint32_t maxKey) {
+    uint64_t span = static_cast<uint64_t>(maxKey) - minKey + 1;
+    return static_cast<size_t>((static_cast<uint64_t>(key) - minKey) * SORTED_GUIDE_BUCKETS / span);
+}
+
+/**
+ * @brief Fills in the header and guide table of a file image from its entries.
+ *
+ * Guide slot b holds the first entry in bucket b; slot SORTED_GUIDE_BUCKETS holds the
+ * entry count, so bucket b spans the entries from slot b up to slot b + 1.
+ *
+ * @param image Words of the file image; the entries must already be in place and sorted.
+ */
+static void indexImage(vector<uint32_t>& image) {
+    const size_t firstWord = SORTED_ENTRIES_OFFSET / 4;
+    uint32_t count = static_cast<uint32_t>((image.size() - firstWord) / 2);
+    uint32_t minKey = count > 0 ? image[firstWord] : 0;
+    uint32_t maxKey = count > 0 ? image[firstWord + 2 * (count - 1)] : 0;
+    memcpy(image.data(), SORTED_MAGIC, 4);
+    image[1] = count;
+    image[2] = minKey;
+    image[3] = maxKey;
+
+    uint32_t entry = 0;
+    for (size_t bucket = 0; bucket < SORTED_GUIDE_BUCKETS; bucket++) {
+        while (entry < count && guideBucket(image[firstWord + 2 * entry], minKey, maxKey) < bucket) entry++;
+        image[SORTED_HEADER_SIZE / 4 + bucket] = entry;
+    }
+    image[SORTED_HEADER_SIZE / 4 + SORTED_GUIDE_BUCKETS] = count;
+}
+
+uint32_t SortedIndex::keyAt(size_t entry) const {
+    uint32_t key;
+    memcpy(&key, entries + entry * SORTED_ENTRY_SIZE, 4);
+    return key;
+}
+
+uint32_t SortedIndex::rbnAt(size_t entry) const {
+    uint32_t RBN;
+    memcpy(&RBN, entries + entry * SORTED_ENTRY_SIZE + 4, 4);
+    return RBN;
+}
+
+uint32_t SortedIndex::guideAt(size_t bucket) const {
+    uint32_t entry;
+    memcpy(&entry, guide + bucket * 4, 4);
+    return entry;
+}
+
+/**
+ * @brief Points the members at a file image after it was read, mapped or resized.
+ * @param data First byte of the image.
+ */
+void SortedIndex::attach(const char* data) {
+    guide = data + SORTED_HEADER_SIZE;
+    entries = data + SORTED_ENTRIES_OFFSET;
+    memcpy(&count, data + 4, 4);
+    memcpy(&minKey, data + 8, 4);
+    memcpy(&maxKey, data + 12, 4);
+}
+
+/**
+ * @brief Builds a new index file in one pass over the entries.
+ * @param fileName Path of the index file to create.
+ * @param entries Key and RBN pairs in ascending key order; every key must be numeric.
+ * @param pageSize Unused; the file has no pages.
+ * @return True if the index was written; it is left open on the new file.
+ */
+bool SortedIndex::build(const string& fileName, const vector<pair<string, int>>& entries, int) {
+    close();
+    vector<uint32_t> image(SORTED_ENTRIES_OFFSET / 4);
+    image.reserve(image.size() + entries.size() * 2);
+    for (const auto& entry : entries) {
+        uint32_t key;
+        if (!sortedIndexKey(entry.first, key)) {
+            cerr << "Error: Key " << entry.first << " is not a 32-bit numeric key" << endl;
+            return false;
+        }
+        if (image.size() > SORTED_ENTRIES_OFFSET / 4 && key <= image[image.size() - 2]) {
+            cerr << "Error: Key " << entry.first << " is out of order" << endl;
+            return false;
+        }
+        image.push_back(key);
+        image.push_back(static_cast<uint32_t>(entry.second));
+    }
+    indexImage(image);
+
+    ofstream out(fileName, ios::binary | ios::trunc);
+    if (!out.is_open()) {
+        cerr << "Error: Could not create index file: " << fileName << endl;
+        return false;
+    }
+    out.write(reinterpret_cast<const char*>(image.data()), image.size() * 4);
+    out.close();
+    if (!out) {
+        cerr << "Error: Could not write index file: " << fileName << endl;
+        return false;
+    }
+    return open(fileName);
+}
+
+/**
+ * @brief Opens an existing index file, reading it or mapping it read-only.
+ * @param fileName Path of the index file.
+ * @param mapped True to map the file read-only; insert() and erase() then fail.
+ * @return True if the file holds a sorted index.
+ */
+bool SortedIndex::open(const string& fileName, bool mapped) {
+    close();
+    const char* data = nullptr;
+    size_t size = 0;
+    if (mapped) {
+        if (!mapping.open(fileName)) return false;
+        data = mapping.getData();
+        size = mapping.getSize();
+    } else {
+        file.open(fileName, ios::in | ios::out | ios::binary);
+        if (!file.is_open()) {
+            cerr << "Error: Could not open index file: " << fileName << endl;
+            return false;
+        }
+        file.seekg(0, ios::end);
+        size = static_cast<size_t>(file.tellg()) / 4 * 4;
+        file.seekg(0);
+        loaded.resize(size / 4);
+        if (file.read(reinterpret_cast<char*>(loaded.data()), size)) {
+            data = reinterpret_cast<const char*>(loaded.data());
+        }
+    }
+
+    uint32_t entryCount = 0;
+    if (data != nullptr && size >= SORTED_ENTRIES_OFFSET) memcpy(&entryCount, data + 4, 4);
+    if (data == nullptr || size < SORTED_ENTRIES_OFFSET || memcmp(data, SORTED_MAGIC, 4) != 0
+        || size < SORTED_ENTRIES_OFFSET + static_cast<size_t>(entryCount) * SORTED_ENTRY_SIZE) {
+        cerr << "Error: " << fileName << " is not a sorted index file" << endl;
+        close();
+        return false;
+    }
+
+    // Drop entries left past the end by erase()
+    if (!mapped) loaded.resize(SORTED_ENTRIES_OFFSET / 4 + static_cast<size_t>(entryCount) * 2);
+    this->fileName = fileName;
+    attach(data);
+    return true;
+}
+
+/**
+ * @brief Closes the index file.
+ */
+void SortedIndex::close() {
+    if (file.is_open()) file.close();
+    file.clear();
+    mapping.close();
+    loaded.clear();
+    fileName.clear();
+    guide = nullptr;
+    entries = nullptr;
+    count = 0;
+    minKey = 0;
+    maxKey = 0;
+    lookups = 0;
+    probes = 0;
+}
+
+/**
+ * @brief Finds the first entry whose key is not less than a key.
+ *
+ * The guide table narrows the search to the entries of the key's bucket. Each step
+ * then guesses the position of the key from the keys at both ends of the remaining
+ * range; the range shrinks on every step, so a bucket of skewed keys cannot loop.
+ *
+ * @param key Numeric key to look for.
+ * @return Entry number, equal to the entry count if every key is smaller.
+ */
+size_t SortedIndex::lowerBound(uint32_t key) {
+    if (count == 0 || key < minKey) return 0;
+    if (key > maxKey) return count;
+    lookups++;
+    size_t bucket = guideBucket(key, minKey, maxKey);
+    size_t low = guideAt(bucket), high = guideAt(bucket + 1);
+    while (low < high) {
+        uint32_t first = keyAt(low), lastKey = keyAt(high - 1);
+        if (key <= first) return low;
+        if (key > lastKey) return high;
+
+        // first < key <= lastKey, so the range holds at least two entries
+        size_t probe = low + static_cast<size_t>(static_cast<uint64_t>(key - first) * (high - 1 - low) / (lastKey - first));
+        probes++;
+        uint32_t found = keyAt(probe);
+        if (found == key) return probe;
+        if (found < key) low = probe + 1;
+        else high = probe;
+    }
+    return low;
+}
+
+/**
+ * @brief Looks up the RBN stored for a key with an interpolation search.
+ * @param key Key to look up.
+ * @return RBN of the block holding the key, or -1 if the key is not indexed.
+ */
+int SortedIndex::find(const string& key) {
+    uint32_t value;
+    if (!isOpen() || !sortedIndexKey(key, value)) return -1;
+    size_t entry = lowerBound(value);
+    if (entry < count && keyAt(entry) == value) return static_cast<int>(rbnAt(entry));
+    return -1;
+}
+
+/**
+ * @brief Finds the largest indexed key.
+ * @param key Receives the largest key.
+ * @param RBN Receives the RBN stored for it.
+ * @return False if the index is empty.
+ */
+bool SortedIndex::last(string& key, int& RBN) {
+    if (!isOpen() || count == 0) return false;
+    key = to_string(keyAt(count - 1));
+    RBN = static_cast<int>(rbnAt(count - 1));
+    return true;
+}
+
+/**
+ * @brief Writes the header, the guide table and the entries from one entry on to the index file.
+ *
+ * After an erase the file keeps one stale entry past the end; the count in the header
+ * decides how many entries are read.
+ *
+ * @param from First entry that changed.
+ * @return True if the file was updated.
+ */
+bool SortedIndex::writeFrom(size_t from) {
+    indexImage(loaded);
+    attach(reinterpret_cast<const char*>(loaded.data()));
+
+    file.clear();
+    file.seekp(0);
+    file.write(reinterpret_cast<const char*>(loaded.data()), SORTED_ENTRIES_OFFSET);
+    if (from < count) {
+        file.seekp(SORTED_ENTRIES_OFFSET + static_cast<long long>(from) * SORTED_ENTRY_SIZE);
+        file.write(entries + from * SORTED_ENTRY_SIZE, (count - from) * SORTED_ENTRY_SIZE);
+    }
+    file.flush();
+    return file.good();
+}
+
+/**
+ * @brief Inserts a key, or replaces the RBN of a key that is already indexed.
+ * @param key Key to insert.
+ * @param RBN Relative Block Number of the block holding the key.
+ * @return True if the index was updated.
+ */
+bool SortedIndex::insert(const string& key, int RBN) {
+    if (!isOpen()) return false;
+    if (mapping.isOpen()) {
+        cerr << "Error: " << fileName << " is open read-only" << endl;
+        return false;
+    }
+    uint32_t value;
+    if (!sortedIndexKey(key, value)) {
+        cerr << "Error: Key " << key << " cannot be indexed" << endl;
+        return false;
+    }
+
+    size_t entry = lowerBound(value);
+    size_t word = SORTED_ENTRIES_OFFSET / 4 + entry * 2;
+    if (entry < count && keyAt(entry) == value) {
+        loaded[word + 1] = static_cast<uint32_t>(RBN);
+    } else {
+        loaded.insert(loaded.begin() + word, { value, static_cast<uint32_t>(RBN) });
+    }
+    return writeFrom(entry);
+}
+
+/**
+ * @brief Removes a key.
+ * @param key Key to remove.
+ * @return True if the key was indexed and has been removed.
+ */
+bool SortedIndex::erase(const string& key) {
+    if (!isOpen()) return false;
+    if (mapping.isOpen()) {
+        cerr << "Error: " << fileName << " is open read-only" << endl;
+        return false;
+    }
+    uint32_t value;
+    if (!sortedIndexKey(key, value)) return false;
+    size_t entry = lowerBound(value);
+    if (entry >= count || keyAt(entry) != value) return false;
+
+    size_t word = SORTED_ENTRIES_OFFSET / 4 + entry * 2;
+    loaded.erase(loaded.begin() + word, loaded.begin() + word + 2);
+    return writeFrom(entry);
+}
+
+/**
+ * @brief Visits keys in ascending order starting at the first one not less than low.
+ * @param low Smallest key to visit; keys that are not numeric visit nothing.
+ * @param visit Called with each key and RBN; return false to stop the scan.
+ */
+void SortedIndex::scan(const string& low, const function<bool(const string&, int)>& visit) {
+    uint32_t value;
+    if (!isOpen() || !sortedIndexKey(low, value)) return;
+    for (size_t entry = lowerBound(value); entry < count; entry++) {
+        if (!visit(to_string(keyAt(entry)), static_cast<int>(rbnAt(entry)))) return;
+    }
+}
+
+/**
+ * @brief Describes the index, e.g. "sorted array of 40933 entries".
+ */
+string SortedIndex::describe() const {
+    return "sorted array of " + to_string(count) + " entries";
+}
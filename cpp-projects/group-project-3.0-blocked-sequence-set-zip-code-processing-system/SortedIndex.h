@@ -0,0 +1,103 @@
+// CSCI 331 Group Project - Copyright © 2024 Blocked Sequence Set Zip Code Processing System
+/**
+ * @file SortedIndex.h
+ * @brief Declaration of the SortedIndex class, a sorted array of fixed-width numeric entries.
+ *
+ * The index file is a 16-byte header (magic "SIX1", entry count, smallest key, largest
+ * key), a guide table and the entries in ascending key order, each a uint32 key and a
+ * uint32 RBN. The guide table splits the key range into SORTED_GUIDE_BUCKETS equal
+ * buckets and holds the first entry of each, so a lookup interpolates only between the
+ * entries of one bucket. Zip codes are dense within a state but uneven across states;
+ * interpolating inside a bucket takes about 2 probes per lookup instead of 6 over the
+ * whole array.
+ */
+
+#ifndef SORTED_INDEX_H
+#define SORTED_INDEX_H
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "KeyIndex.h"
+#include "MappedFile.h"
+
+/// Number of equal key ranges the guide table of a sorted index splits the keys into.
+const size_t SORTED_GUIDE_BUCKETS = 1024;
+
+/**
+ * @class SortedIndex
+ * @brief Sorted array of (uint32 key, uint32 RBN) entries searched by interpolation.
+ *
+ * Only all-digit keys that fit in 32 bits can be indexed. Their numeric order is the
+ * compareKeys() order, and scans report keys without leading zeros. Inserts and erases
+ * shift the entries after the changed one, recompute the guide table and rewrite both
+ * to the file.
+ */
+class SortedIndex : public KeyIndex {
+public:
+    SortedIndex();
+
+    bool build(const std::string& fileName, const std::vector<std::pair<std::string, int>>& entries, int pageSize) override;
+    bool open(const std::string& fileName, bool mapped = false) override;
+    void close() override;
+    int find(const std::string& key) override;
+    bool last(std::string& key, int& RBN) override;
+    bool insert(const std::string& key, int RBN) override;
+    bool erase(const std::string& key) override;
+    void scan(const std::string& low, const std::function<bool(const std::string&, int)>& visit) override;
+    std::string describe() const override;
+
+    bool isOpen() const override { return entries != nullptr; }
+    const std::string& getFileName() const override { return fileName; }
+    int getEntryCount() const override { return static_cast<int>(count); }
+    unsigned long long getLookups() const { return lookups; }
+    unsigned long long getProbes() const { return probes; }
+
+private:
+    /**
+     * @brief Finds the first entry whose key is not less than a key.
+     * @param key Numeric key to look for.
+     * @return Entry number, equal to the entry count if every key is smaller.
+     */
+    size_t lowerBound(uint32_t key);
+
+    /**
+     * @brief Writes the header, the guide table and the entries from one entry on to the index file.
+     * @param from First entry that changed.
+     * @return True if the file was updated.
+     */
+    bool writeFrom(size_t from);
+
+    /**
+     * @brief Points the members at a file image after it was read, mapped or resized.
+     * @param data First byte of the image.
+     */
+    void attach(const char* data);
+
+    uint32_t keyAt(size_t entry) const;
+    uint32_t rbnAt(size_t entry) const;
+    uint32_t guideAt(size_t bucket) const;
+
+    std::string fileName;           ///< Path of the open index file
+    std::fstream file;              ///< Open index file, when not mapped
+    MappedFile mapping;             ///< Read-only mapping of the index file, if mapped
+    std::vector<uint32_t> loaded;   ///< File image read from the file, when not mapped
+    const char* guide;              ///< First guide table slot, in the mapping or in loaded
+    const char* entries;            ///< First entry, in the mapping or in loaded
+    uint32_t count;                 ///< Number of entries
+    uint32_t minKey;                ///< Smallest key, from the file header
+    uint32_t maxKey;                ///< Largest key, from the file header
+    unsigned long long lookups;     ///< Searches since the index was opened
+    unsigned long long probes;      ///< Entries probed by those searches
+};
+
+/**
+ * @brief Converts a key to the numeric key of a sorted index.
+ * @param key Key such as "501" or "00501".
+ * @param value Receives the numeric value.
+ * @return False if the key is not all digits or does not fit in 32 bits.
+ */
+bool sortedIndexKey(const std::string& key, uint32_t& value);
+
+#endif // SORTED_INDEX_H
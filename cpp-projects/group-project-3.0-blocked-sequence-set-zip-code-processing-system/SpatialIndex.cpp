@@ -0,0 +1,232 @@
+// CSCI 331 Group Project - Copyright © 2024 Blocked Sequence Set Zip Code Processing System
+#include "SpatialIndex.h"
+#include "Block.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+using namespace std;
+
+static const double DEGREES_TO_RADIANS = 3.14159265358979323846 / 180.0;
+
+/**
+ * @brief Orders matches by distance, then by key, so every query method agrees on ties.
+ */
+bool SpatialMatch::operator<(const SpatialMatch& other) const {
+    if (distanceKm != other.distanceKm) return distanceKm < other.distanceKm;
+    return compareKeys(point->key, other.point->key) < 0;
+}
+
+/**
+ * @brief Great-circle distance between two locations (haversine formula).
+ * @param latitude1 Latitude of the first location in degrees.
+ * @param longitude1 Longitude of the first location in degrees.
+ * @param latitude2 Latitude of the second location in degrees.
+ * @param longitude2 Longitude of the second location in degrees.
+ * @return Distance in kilometres.
+ */
+double greatCircleKm(double latitude1, double longitude1, double latitude2, double longitude2) {
+    double dLatitude = (latitude2 - latitude1) * DEGREES_TO_RADIANS;
+    double dLongitude = (longitude2 - longitude1) * DEGREES_TO_RADIANS;
+    double a = sin(dLatitude / 2) * sin(dLatitude / 2)
+        + cos(latitude1 * DEGREES_TO_RADIANS) * cos(latitude2 * DEGREES_TO_RADIANS) * sin(dLongitude / 2) * sin(dLongitude / 2);
+    return 2 * EARTH_RADIUS_KM * asin(min(1.0, sqrt(a)));
+}
+
+/**
+ * @brief Converts a location to a point on the unit sphere.
+ */
+static void toUnitSphere(double latitude, double longitude, double v[3]) {
+    double phi = latitude * DEGREES_TO_RADIANS, lambda = longitude * DEGREES_TO_RADIANS;
+    v[0] = cos(phi) * cos(lambda);
+    v[1] = cos(phi) * sin(lambda);
+    v[2] = sin(phi);
+}
+
+static double chordSquared(const double a[3], const double b[3]) {
+    double dx = a[0] - b[0], dy = a[1] - b[1], dz = a[2] - b[2];
+    return dx * dx + dy * dy + dz * dz;
+}
+
+/**
+ * @brief Builds the tree, replacing any previous contents.
+ *
+ * Every range is split at its median along the axis with the widest spread, so the
+ * tree is balanced and its nodes can stay in one array in tree order.
+ *
+ * @param input Record locations in any order.
+ */
+void SpatialIndex::build(vector<SpatialPoint> input) {
+    size_t n = input.size();
+    vector<Vector3> inputPositions(n);
+    for (size_t i = 0; i < n; i++) {
+        toUnitSphere(input[i].latitude, input[i].longitude, inputPositions[i].v);
+    }
+
+    // Build over a permutation, then move the points into tree order once
+    vector<size_t> order(n);
+    iota(order.begin(), order.end(), 0);
+    positions = inputPositions;
+    axes.assign(n, 0);
+    buildRange(order, 0, n);
+
+    points.clear();
+    points.reserve(n);
+    for (size_t i = 0; i < n; i++) {
+        points.push_back(move(input[order[i]]));
+        positions[i] = inputPositions[order[i]];
+    }
+    built = true;
+}
+
+/**
+ * @brief Drops every point.
+ */
+void SpatialIndex::clear() {
+    points.clear();
+    positions.clear();
+    axes.clear();
+    built = false;
+}
+
+/**
+ * @brief Splits one range of the permutation at its median.
+ * @param order Permutation of the input points; positions is still in input order.
+ * @param low First position of the range.
+ * @param high One past the last position of the range.
+ */
+void SpatialIndex::buildRange(vector<size_t>& order, size_t low, size_t high) {
+    if (high - low <= 1) return;
+    double lowest[3] = { 2, 2, 2 }, highest[3] = { -2, -2, -2 };
+    for (size_t i = low; i < high; i++) {
+        for (int axis = 0; axis < 3; axis++) {
+            lowest[axis] = min(lowest[axis], positions[order[i]].v[axis]);
+            highest[axis] = max(highest[axis], positions[order[i]].v[axis]);
+        }
+    }
+    int axis = 0;
+    for (int a = 1; a < 3; a++) {
+        if (highest[a] - lowest[a] > highest[axis] - lowest[axis]) axis = a;
+    }
+
+    size_t mid = low + (high - low) / 2;
+    nth_element(order.begin() + low, order.begin() + mid, order.begin() + high, [this, axis](size_t a, size_t b) {
+        return positions[a].v[axis] < positions[b].v[axis];
+    });
+    axes[mid] = static_cast<unsigned char>(axis);
+    buildRange(order, low, mid);
+    buildRange(order, mid + 1, high);
+}
+
+/**
+ * @brief Wraps a point as a match, with its great-circle distance from a location.
+ */
+SpatialMatch SpatialIndex::match(size_t point, double latitude, double longitude) const {
+    return { &points[point], greatCircleKm(latitude, longitude, points[point].latitude, points[point].longitude) };
+}
+
+/**
+ * @brief Collects the k closest points of one range into a max-heap of chord distances.
+ * @param low First position of the range.
+ * @param high One past the last position of the range.
+ * @param target Query location on the unit sphere.
+ * @param k Number of points wanted.
+ * @param heap Max-heap of (squared chord distance, position) pairs ordered like
+ *             SpatialMatch, at most k long.
+ */
+void SpatialIndex::nearestBelow(size_t low, size_t high, const Vector3& target, size_t k,
+                                vector<pair<double, size_t>>& heap) const {
+    if (low >= high) return;
+    size_t mid = low + (high - low) / 2;
+    auto closer = [this](const pair<double, size_t>& a, const pair<double, size_t>& b) {
+        return a.first != b.first ? a.first < b.first : compareKeys(points[a.second].key, points[b.second].key) < 0;
+    };
+    pair<double, size_t> candidate(chordSquared(positions[mid].v, target.v), mid);
+    if (heap.size() < k) {
+        heap.push_back(candidate);
+        push_heap(heap.begin(), heap.end(), closer);
+    } else if (closer(candidate, heap.front())) {
+        pop_heap(heap.begin(), heap.end(), closer);
+        heap.back() = candidate;
+        push_heap(heap.begin(), heap.end(), closer);
+    }
+
+    // Every point on the far side of the split is at least diff away along the split axis
+    double diff = target.v[axes[mid]] - positions[mid].v[axes[mid]];
+    bool leftFirst = diff < 0;
+    nearestBelow(leftFirst ? low : mid + 1, leftFirst ? mid : high, target, k, heap);
+    if (heap.size() < k || diff * diff <= heap.front().first) {
+        nearestBelow(leftFirst ? mid + 1 : low, leftFirst ? high : mid, target, k, heap);
+    }
+}
+
+/**
+ * @brief Collects the points of one range within a squared chord distance.
+ * @param low First position of the range.
+ * @param high One past the last position of the range.
+ * @param target Query location on the unit sphere.
+ * @param limit Largest squared chord distance.
+ * @param found Receives the positions of the points in range.
+ */
+void SpatialIndex::withinBelow(size_t low, size_t high, const Vector3& target, double limit, vector<size_t>& found) const {
+    if (low >= high) return;
+    size_t mid = low + (high - low) / 2;
+    if (chordSquared(positions[mid].v, target.v) <= limit) found.push_back(mid);
+
+    double diff = target.v[axes[mid]] - positions[mid].v[axes[mid]];
+    if (diff < 0 || diff * diff <= limit) withinBelow(low, mid, target, limit, found);
+    if (diff >= 0 || diff * diff <= limit) withinBelow(mid + 1, high, target, limit, found);
+}
+
+/**
+ * @brief Finds the k points closest to a location.
+ * @param latitude Latitude of the location in degrees.
+ * @param longitude Longitude of the location in degrees.
+ * @param k Number of points to return.
+ * @return Up to k matches, closest first.
+ */
+vector<SpatialMatch> SpatialIndex::nearest(double latitude, double longitude, size_t k) const {
+    Vector3 target;
+    toUnitSphere(latitude, longitude, target.v);
+    vector<pair<double, size_t>> heap;
+    heap.reserve(k);
+    if (k > 0) nearestBelow(0, points.size(), target, k, heap);
+
+    vector<SpatialMatch> matches;
+    matches.reserve(heap.size());
+    for (const auto& entry : heap) {
+        matches.push_back(match(entry.second, latitude, longitude));
+    }
+    sort(matches.begin(), matches.end());
+    return matches;
+}
+
+/**
+ * @brief Finds every point within a distance of a location.
+ *
+ * The tree is searched with the chord length of the radius, widened slightly against
+ * rounding; the candidates are then checked with greatCircleKm(), so the result is the
+ * same as comparing every point's great-circle distance with the radius.
+ *
+ * @param latitude Latitude of the location in degrees.
+ * @param longitude Longitude of the location in degrees.
+ * @param radiusKm Largest distance in kilometres.
+ * @return The matches, closest first.
+ */
+vector<SpatialMatch> SpatialIndex::within(double latitude, double longitude, double radiusKm) const {
+    vector<SpatialMatch> matches;
+    if (radiusKm < 0) return matches;
+    Vector3 target;
+    toUnitSphere(latitude, longitude, target.v);
+    double angle = min(radiusKm / EARTH_RADIUS_KM, 3.14159265358979323846);
+    double chord = 2 * sin(angle / 2);
+    vector<size_t> found;
+    withinBelow(0, points.size(), target, chord * chord * (1 + 1e-9) + 1e-12, found);
+
+    for (size_t point : found) {
+        SpatialMatch candidate = match(point, latitude, longitude);
+        if (candidate.distanceKm <= radiusKm) matches.push_back(candidate);
+    }
+    sort(matches.begin(), matches.end());
+    return matches;
+}
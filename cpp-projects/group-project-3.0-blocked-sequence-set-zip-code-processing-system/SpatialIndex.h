@@ -0,0 +1,117 @@
+// CSCI 331 Group Project - Copyright © 2024 Blocked Sequence Set Zip Code Processing System
+/**
+ * @file SpatialIndex.h
+ * @brief Declaration of the SpatialIndex class, an in-memory k-d tree over record locations.
+ *
+ * Latitude and longitude are converted to points on the unit sphere, so the straight
+ * line (chord) distance between two points grows with their great-circle distance and
+ * a three-dimensional k-d tree answers nearest neighbour and radius queries exactly,
+ * including across the antimeridian.
+ */
+
+#ifndef SPATIAL_INDEX_H
+#define SPATIAL_INDEX_H
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+/// Mean radius of the Earth in kilometres.
+const double EARTH_RADIUS_KM = 6371.0088;
+
+/**
+ * @brief One indexed record location.
+ */
+struct SpatialPoint {
+    std::string key;   ///< Primary key of the record
+    int RBN;           ///< Block holding the record
+    double latitude;   ///< Latitude in degrees
+    double longitude;  ///< Longitude in degrees
+};
+
+/**
+ * @brief A point found by a query and its distance from the query location.
+ */
+struct SpatialMatch {
+    const SpatialPoint* point;  ///< Point inside the index that produced the match
+    double distanceKm;          ///< Great-circle distance from the query location
+
+    /**
+     * @brief Orders matches by distance, then by key, so every query method agrees on ties.
+     */
+    bool operator<(const SpatialMatch& other) const;
+};
+
+/**
+ * @brief Great-circle distance between two locations (haversine formula).
+ * @param latitude1 Latitude of the first location in degrees.
+ * @param longitude1 Longitude of the first location in degrees.
+ * @param latitude2 Latitude of the second location in degrees.
+ * @param longitude2 Longitude of the second location in degrees.
+ * @return Distance in kilometres.
+ */
+double greatCircleKm(double latitude1, double longitude1, double latitude2, double longitude2);
+
+/**
+ * @class SpatialIndex
+ * @brief Static k-d tree over the locations of the records of a block file.
+ *
+ * The tree is implicit: the points are reordered so that the median of every range
+ * is its node, and only the split axis of each node is stored. It must be rebuilt
+ * after the file changes.
+ */
+class SpatialIndex {
+public:
+    /**
+     * @brief Builds the tree, replacing any previous contents.
+     * @param points Record locations in any order.
+     */
+    void build(std::vector<SpatialPoint> points);
+
+    /**
+     * @brief Drops every point.
+     */
+    void clear();
+
+    /**
+     * @brief Finds the k points closest to a location.
+     * @param latitude Latitude of the location in degrees.
+     * @param longitude Longitude of the location in degrees.
+     * @param k Number of points to return.
+     * @return Up to k matches, closest first.
+     */
+    std::vector<SpatialMatch> nearest(double latitude, double longitude, size_t k) const;
+
+    /**
+     * @brief Finds every point within a distance of a location.
+     * @param latitude Latitude of the location in degrees.
+     * @param longitude Longitude of the location in degrees.
+     * @param radiusKm Largest distance in kilometres.
+     * @return The matches, closest first.
+     */
+    std::vector<SpatialMatch> within(double latitude, double longitude, double radiusKm) const;
+
+    bool isBuilt() const { return built; }
+    size_t size() const { return points.size(); }
+
+private:
+    /**
+     * @brief Position of a point on the unit sphere.
+     */
+    struct Vector3 {
+        double v[3];
+    };
+
+    void buildRange(std::vector<size_t>& order, size_t low, size_t high);
+    void nearestBelow(size_t low, size_t high, const Vector3& target, size_t k, std::vector<std::pair<double, size_t>>& heap) const;
+    void withinBelow(size_t low, size_t high, const Vector3& target, double limit, std::vector<size_t>& found) const;
+    SpatialMatch match(size_t point, double latitude, double longitude) const;
+
+    std::vector<SpatialPoint> points;     ///< Points in tree order
+    std::vector<Vector3> positions;       ///< Unit sphere position of each point
+    std::vector<unsigned char> axes;      ///< Split axis of the node at each position
+    bool built = false;                   ///< True once build() has run
+};
+
+#endif // SPATIAL_INDEX_H
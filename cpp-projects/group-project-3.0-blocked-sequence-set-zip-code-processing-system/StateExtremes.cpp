@@ -0,0 +1,167 @@
+// CSCI 331 Group Project - Copyright © 2024 Blocked Sequence Set Zip Code Processing System
+#include "StateExtremes.h"
+#include "Block.h"
+#include "BlockView.h"
+#include "HeaderRecord.h"
+#include <iostream>
+
+using namespace std;
+
+/// USPS state, district, territory and military abbreviations in alphabetical order.
+static const char* const STATE_ABBREVIATIONS[] = {
+    "AA", "AE", "AK", "AL", "AP", "AR", "AS", "AZ", "CA", "CO", "CT", "DC", "DE",
+    "FL", "FM", "GA", "GU", "HI", "IA", "ID", "IL", "IN", "KS", "KY", "LA", "MA",
+    "MD", "ME", "MH", "MI", "MN", "MO", "MP", "MS", "MT", "NC", "ND", "NE", "NH",
+    "NJ", "NM", "NV", "NY", "OH", "OK", "OR", "PA", "PR", "PW", "RI", "SC", "SD",
+    "TN", "TX", "UT", "VA", "VI", "VT", "WA", "WI", "WV", "WY"
+};
+
+static const int STATE_COUNT = sizeof(STATE_ABBREVIATIONS) / sizeof(STATE_ABBREVIATIONS[0]);
+static_assert(STATE_COUNT <= STATE_CODE_SLOTS, "state codes must fit in a 64-bit set");
+
+/**
+ * @brief Table from the two letters of an abbreviation (26 x 26) to its state code.
+ */
+struct StateCodeTable {
+    signed char codes[26 * 26];
+
+    StateCodeTable() {
+        for (signed char& code : codes) code = -1;
+        for (int i = 0; i < STATE_COUNT; i++) {
+            codes[(STATE_ABBREVIATIONS[i][0] - 'A') * 26 + (STATE_ABBREVIATIONS[i][1] - 'A')] = static_cast<signed char>(i);
+        }
+    }
+};
+
+/**
+ * @brief Maps a two-letter USPS state or territory abbreviation to its code.
+ * @param state Abbreviation such as "NY".
+ * @return Code in [0, STATE_CODE_SLOTS), or -1 for an unknown abbreviation.
+ */
+int stateCode(string_view state) {
+    static const StateCodeTable table;
+    if (state.size() != 2 || state[0] < 'A' || state[0] > 'Z' || state[1] < 'A' || state[1] > 'Z') return -1;
+    return table.codes[(state[0] - 'A') * 26 + (state[1] - 'A')];
+}
+
+/**
+ * @brief Returns the abbreviation of a state code; codes follow alphabetical order.
+ * @param code State code from stateCode().
+ * @return Abbreviation, or an empty string for an unused code.
+ */
+const char* stateAbbreviation(int code) {
+    return code >= 0 && code < STATE_COUNT ? STATE_ABBREVIATIONS[code] : "";
+}
+
+/**
+ * @brief Replaces an extreme when a value beats it, or ties it with a smaller key.
+ * @param better True if the candidate is strictly more extreme than the current value.
+ * @param candidate Candidate value.
+ * @param candidateKey Key of the candidate record.
+ * @param value Current extreme value.
+ * @param key Key of the current extreme record.
+ */
+static void offer(bool better, double candidate, string_view candidateKey, double& value, string& key) {
+    if (better || (candidate == value && compareKeys(candidateKey, key) < 0)) {
+        value = candidate;
+        key.assign(candidateKey.data(), candidateKey.size());
+    }
+}
+
+/**
+ * @brief Adds one record.
+ * @param key Primary key of the record.
+ * @param latitude Latitude of the record.
+ * @param longitude Longitude of the record.
+ */
+void StateExtremes::add(string_view key, double latitude, double longitude) {
+    if (count++ == 0) {
+        east = west = longitude;
+        north = south = latitude;
+        eastKey.assign(key.data(), key.size());
+        westKey = northKey = southKey = eastKey;
+        return;
+    }
+    offer(longitude > east, longitude, key, east, eastKey);
+    offer(longitude < west, longitude, key, west, westKey);
+    offer(latitude > north, latitude, key, north, northKey);
+    offer(latitude < south, latitude, key, south, southKey);
+}
+
+/**
+ * @brief Folds the extremes of another partial result into this one.
+ * @param other Extremes of the same state over other records.
+ */
+void StateExtremes::merge(const StateExtremes& other) {
+    if (other.count == 0) return;
+    if (count == 0) {
+        *this = other;
+        return;
+    }
+    count += other.count;
+    offer(other.east > east, other.east, other.eastKey, east, eastKey);
+    offer(other.west < west, other.west, other.westKey, west, westKey);
+    offer(other.north > north, other.north, other.northKey, north, northKey);
+    offer(other.south < south, other.south, other.southKey, south, southKey);
+}
+
+/**
+ * @brief Creates an empty aggregator, locating the fields by name in the header.
+ * @param header Header record of the block file.
+ */
+ExtremesAggregator::ExtremesAggregator(const HeaderRecord& header)
+    : keyField(header.getPrimaryKeyField())
+    , stateField(fieldIndex(header, "state", 2))
+    , latitudeField(fieldIndex(header, "latitude", 4))
+    , longitudeField(fieldIndex(header, "longitude", 5))
+    , skipped(0) {}
+
+/**
+ * @brief Adds every record of one block.
+ * @param view View of the block.
+ */
+void ExtremesAggregator::addBlock(const BlockView& view) {
+    for (size_t r = 0; r < view.getRecordCount(); r++) {
+        int code = stateCode(view.field(r, stateField));
+        string_view latitude = view.field(r, latitudeField);
+        string_view longitude = view.field(r, longitudeField);
+        if (code < 0 || latitude.empty() || longitude.empty()) {
+            skipped++;
+            continue;
+        }
+        states[code].add(view.field(r, keyField), parseDouble(latitude), parseDouble(longitude));
+    }
+}
+
+/**
+ * @brief Folds the partial result of another aggregator into this one.
+ * @param other Aggregator over other blocks of the same file.
+ */
+void ExtremesAggregator::merge(const ExtremesAggregator& other) {
+    for (int code = 0; code < STATE_CODE_SLOTS; code++) {
+        states[code].merge(other.states[code]);
+    }
+    skipped += other.skipped;
+}
+
+/**
+ * @brief Prints one line per state: state, easternmost, westernmost, northernmost
+ *        and southernmost key.
+ * @param out Stream to print to.
+ * @param onlyState State code to print alone, or -1 for every state.
+ */
+void ExtremesAggregator::print(ostream& out, int onlyState) const {
+    out << "State,Easternmost,Westernmost,Northernmost,Southernmost\n";
+    for (int code = 0; code < STATE_CODE_SLOTS; code++) {
+        const StateExtremes& state = states[code];
+        if (state.count == 0 || (onlyState >= 0 && code != onlyState)) continue;
+        out << stateAbbreviation(code) << ","
+            << state.eastKey << ","
+            << state.westKey << ","
+            << state.northKey << ","
+            << state.southKey << "\n";
+    }
+    if (skipped > 0 && onlyState < 0) {
+        out << skipped << " records skipped (unknown state or missing coordinates)\n";
+    }
+}
@@ -0,0 +1,122 @@
+// CSCI 331 Group Project - Copyright © 2024 Blocked Sequence Set Zip Code Processing System
+/**
+ * @file StateExtremes.h
+ * @brief Declaration of the streaming per-state extremes operator used by listMost().
+ *
+ * States are identified by a small integer code so per-state state can live in flat
+ * arrays (and later in 64-bit state sets) instead of maps keyed by strings.
+ */
+
+#ifndef STATE_EXTREMES_H
+#define STATE_EXTREMES_H
+
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+
+class BlockView;
+class HeaderRecord;
+
+/// Number of state code slots; every code fits in a 64-bit state set.
+const int STATE_CODE_SLOTS = 64;
+
+/**
+ * @brief Maps a two-letter USPS state or territory abbreviation to its code.
+ * @param state Abbreviation such as "NY".
+ * @return Code in [0, STATE_CODE_SLOTS), or -1 for an unknown abbreviation.
+ */
+int stateCode(std::string_view state);
+
+/**
+ * @brief Returns the abbreviation of a state code; codes follow alphabetical order.
+ * @param code State code from stateCode().
+ * @return Abbreviation, or an empty string for an unused code.
+ */
+const char* stateAbbreviation(int code);
+
+/**
+ * @brief Running extremes of the records of one state.
+ *
+ * Ties keep the smaller key, so the result does not depend on the order in which
+ * records or partial results are added.
+ */
+struct StateExtremes {
+    unsigned long long count = 0;  ///< Records added so far
+    double east = 0;               ///< Largest longitude
+    double west = 0;               ///< Smallest longitude
+    double north = 0;              ///< Largest latitude
+    double south = 0;              ///< Smallest latitude
+    std::string eastKey;           ///< Key of the easternmost record
+    std::string westKey;           ///< Key of the westernmost record
+    std::string northKey;          ///< Key of the northernmost record
+    std::string southKey;          ///< Key of the southernmost record
+
+    /**
+     * @brief Adds one record.
+     * @param key Primary key of the record.
+     * @param latitude Latitude of the record.
+     * @param longitude Longitude of the record.
+     */
+    void add(std::string_view key, double latitude, double longitude);
+
+    /**
+     * @brief Folds the extremes of another partial result into this one.
+     * @param other Extremes of the same state over other records.
+     */
+    void merge(const StateExtremes& other);
+};
+
+/**
+ * @class ExtremesAggregator
+ * @brief Streaming operator computing the easternmost, westernmost, northernmost and
+ *        southernmost record of each state.
+ *
+ * Blocks are fed one at a time through views, so memory use is one accumulator per
+ * state code no matter how large the file is.
+ */
+class ExtremesAggregator {
+public:
+    /**
+     * @brief Creates an empty aggregator, locating the fields by name in the header.
+     *
+     * Falls back to the zip code layout (key, place, state, county, latitude, longitude)
+     * for fields the header does not name.
+     *
+     * @param header Header record of the block file.
+     */
+    explicit ExtremesAggregator(const HeaderRecord& header);
+
+    /**
+     * @brief Adds every record of one block.
+     * @param view View of the block.
+     */
+    void addBlock(const BlockView& view);
+
+    /**
+     * @brief Folds the partial result of another aggregator into this one.
+     * @param other Aggregator over other blocks of the same file.
+     */
+    void merge(const ExtremesAggregator& other);
+
+    /**
+     * @brief Prints one line per state: state, easternmost, westernmost, northernmost
+     *        and southernmost key.
+     * @param out Stream to print to.
+     * @param onlyState State code to print alone, or -1 for every state.
+     */
+    void print(std::ostream& out, int onlyState = -1) const;
+
+    const StateExtremes& getState(int code) const { return states[code]; }
+    unsigned long long getSkippedRecords() const { return skipped; }
+
+private:
+    size_t keyField;                          ///< Field number of the primary key
+    size_t stateField;                        ///< Field number of the state
+    size_t latitudeField;                     ///< Field number of the latitude
+    size_t longitudeField;                    ///< Field number of the longitude
+    StateExtremes states[STATE_CODE_SLOTS];   ///< Accumulator per state code
+    unsigned long long skipped;               ///< Records with an unknown state or no coordinates
+};
+
+#endif // STATE_EXTREMES_H
@@ -0,0 +1,289 @@
+// CSCI 331 Group Project - Copyright © 2024 Blocked Sequence Set Zip Code Processing System
+#include "WriteAheadLog.h"
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+/// Identifies a file written by WriteAheadLog.
+static const char LOG_MAGIC[4] = { 'W', 'A', 'L', '1' };
+
+/// Bytes of the log file header.
+static const size_t LOG_HEADER_SIZE = 16;
+
+/// Bytes of a record header (type, RBN, payload length, checksum).
+static const size_t LOG_RECORD_HEADER_SIZE = 16;
+
+/// Record types.
+static const uint32_t LOG_IMAGE = 1;
+static const uint32_t LOG_COMMIT = 2;
+
+#ifdef _WIN32
+static int openForWrite(const string& fileName, bool truncate) {
+    return _open(fileName.c_str(), _O_WRONLY | _O_BINARY | (truncate ? _O_CREAT | _O_TRUNC : 0), _S_IREAD | _S_IWRITE);
+}
+static bool writeAll(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        int written = _write(fd, data, static_cast<unsigned>(size));
+        if (written <= 0) return false;
+        data += written;
+        size -= written;
+    }
+    return true;
+}
+static bool syncDescriptor(int fd) { return _commit(fd) == 0; }
+static void closeDescriptor(int fd) { _close(fd); }
+#else
+static int openForWrite(const string& fileName, bool truncate) {
+    return ::open(fileName.c_str(), O_WRONLY | (truncate ? O_CREAT | O_TRUNC : 0), 0644);
+}
+static bool writeAll(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t written = ::write(fd, data, size);
+        if (written <= 0) return false;
+        data += written;
+        size -= written;
+    }
+    return true;
+}
+static bool syncDescriptor(int fd) { return fsync(fd) == 0; }
+static void closeDescriptor(int fd) { ::close(fd); }
+#endif
+
+/**
+ * @brief Names the log file of a block file ("block.dat" -> "block.wal").
+ * @param blockFile Path of the block file.
+ * @return Path of the log file.
+ */
+string logFileName(const string& blockFile) {
+    size_t dot = blockFile.find_last_of('.');
+    size_t slash = blockFile.find_last_of("/\\");
+    if (dot == string::npos || (slash != string::npos && dot < slash)) return blockFile + ".wal";
+    return blockFile.substr(0, dot) + ".wal";
+}
+
+/**
+ * @brief Forces the written contents of a file to disk (fsync, or _commit on Windows).
+ * @param fileName Path of the file.
+ * @return True if the file was synced.
+ */
+bool syncFile(const string& fileName) {
+    int fd = openForWrite(fileName, false);
+    if (fd < 0) return false;
+    bool synced = syncDescriptor(fd);
+    closeDescriptor(fd);
+    return synced;
+}
+
+/**
+ * @brief Checksum of a record (32-bit FNV-1a over its header fields and payload).
+ */
+static uint32_t recordChecksum(uint32_t type, int32_t RBN, const char* payload, uint32_t length) {
+    uint32_t hash = 2166136261u;
+    auto mix = [&hash](const void* data, size_t size) {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; i++) {
+            hash = (hash ^ bytes[i]) * 16777619u;
+        }
+    };
+    mix(&type, 4);
+    mix(&RBN, 4);
+    mix(&length, 4);
+    mix(payload, length);
+    return hash;
+}
+
+/**
+ * @brief Appends one record to a buffer.
+ */
+static void putRecord(string& buffer, uint32_t type, int32_t RBN, const string& payload) {
+    uint32_t fields[4] = { type, static_cast<uint32_t>(RBN), static_cast<uint32_t>(payload.size()),
+                           recordChecksum(type, RBN, payload.data(), static_cast<uint32_t>(payload.size())) };
+    buffer.append(reinterpret_cast<const char*>(fields), LOG_RECORD_HEADER_SIZE);
+    buffer += payload;
+}
+
+WriteAheadLog::WriteAheadLog()
+    : fd(-1)
+    , committedBytes(0)
+    , uncommitted(0)
+    , pendingCommits(0)
+    , fileSize(0)
+    , commits(0)
+    , syncs(0) {}
+
+WriteAheadLog::~WriteAheadLog() {
+    if (fd >= 0) closeDescriptor(fd);
+}
+
+/**
+ * @brief Creates an empty log file, replacing any earlier one, and syncs it.
+ * @param fileName Path of the log file.
+ * @param blockSize Block size of the block file, recorded in the log header.
+ * @param headerSize Header region size of the block file, recorded in the log header.
+ * @return True if the log file was created.
+ */
+bool WriteAheadLog::open(const string& fileName, int blockSize, int headerSize) {
+    if (fd >= 0) closeDescriptor(fd);
+    this->fileName = fileName;
+    buffer.clear();
+    committedBytes = 0;
+    uncommitted = 0;
+    pendingCommits = 0;
+
+    fd = openForWrite(fileName, true);
+    int32_t header[4] = { 0, blockSize, headerSize, 0 };
+    memcpy(header, LOG_MAGIC, 4);
+    if (fd < 0 || !writeAll(fd, reinterpret_cast<const char*>(header), LOG_HEADER_SIZE) || !syncDescriptor(fd)) {
+        cerr << "Error: Could not create log file: " << fileName << endl;
+        remove();
+        return false;
+    }
+    fileSize = LOG_HEADER_SIZE;
+    return true;
+}
+
+/**
+ * @brief Closes the log file and deletes it; buffered records are dropped.
+ */
+void WriteAheadLog::remove() {
+    if (fd >= 0) closeDescriptor(fd);
+    fd = -1;
+    if (!fileName.empty()) std::remove(fileName.c_str());
+    buffer.clear();
+    committedBytes = 0;
+    uncommitted = 0;
+    pendingCommits = 0;
+    fileSize = 0;
+}
+
+/**
+ * @brief Appends the after image of a block, or of the header region for RBN 0.
+ * @param RBN Relative Block Number of the block, 0 for the header region.
+ * @param image Bytes to write at that position.
+ */
+void WriteAheadLog::append(int RBN, const string& image) {
+    putRecord(buffer, LOG_IMAGE, RBN, image);
+    uncommitted++;
+}
+
+/**
+ * @brief Appends a commit record closing the images appended since the last one.
+ */
+void WriteAheadLog::commit() {
+    if (uncommitted == 0) return;
+    putRecord(buffer, LOG_COMMIT, 0, string());
+    committedBytes = buffer.size();
+    uncommitted = 0;
+    pendingCommits++;
+    commits++;
+}
+
+/**
+ * @brief Drops the buffered images appended since the last commit record.
+ *
+ * The log is only synced after a commit record (see BufferPool::flush()), so the
+ * dropped images never reached the file.
+ */
+void WriteAheadLog::rollback() {
+    buffer.resize(committedBytes);
+    uncommitted = 0;
+}
+
+/**
+ * @brief Writes the buffered records to the log file and syncs it.
+ *
+ * This is the group commit: every mutation committed since the last sync becomes
+ * durable with a single write and a single sync.
+ *
+ * @return True if every buffered record is on disk.
+ */
+bool WriteAheadLog::sync() {
+    if (buffer.empty()) return true;
+    if (fd < 0 || !writeAll(fd, buffer.data(), buffer.size()) || !syncDescriptor(fd)) {
+        cerr << "Error: Could not write log file: " << fileName << endl;
+        return false;
+    }
+    fileSize += buffer.size();
+    buffer.clear();
+    committedBytes = 0;
+    pendingCommits = 0;
+    syncs++;
+    return true;
+}
+
+/**
+ * @brief Writes the images of every committed mutation of a log file.
+ *
+ * Images are held back until the commit record that closes them has been read, so a
+ * mutation cut short by a crash is dropped as a whole. A missing log has nothing to
+ * replay, while one with a foreign header fails, so the block file stays stale and
+ * the log is kept for inspection.
+ *
+ * @param fileName Path of the log file.
+ * @param headerSize Header region size of the block file, checked against the log header.
+ * @param apply Called with the RBN (0 for the header region) and image of every
+ *              committed record, in log order; returns false to stop with an error.
+ * @return Number of mutations replayed, or -1 if the log is not a log of this block
+ *         file or apply failed.
+ */
+long WriteAheadLog::replay(const string& fileName, int headerSize,
+                           const function<bool(int, const string&)>& apply) {
+    ifstream in(fileName, ios::binary);
+    if (!in.is_open()) return 0;
+    string log((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+    int32_t header[4];
+    // Only a crash while open() created the log leaves it shorter than its header
+    if (log.size() < LOG_HEADER_SIZE) return 0;
+    if (memcmp(log.data(), LOG_MAGIC, 4) != 0) {
+        cerr << "Error: " << fileName << " is not a log file" << endl;
+        return -1;
+    }
+    memcpy(header, log.data(), LOG_HEADER_SIZE);
+    if (header[2] != headerSize) {
+        cerr << "Error: " << fileName << " was written for another block file" << endl;
+        return -1;
+    }
+
+    long replayed = 0;
+    vector<pair<int, string>> images;
+    for (size_t pos = LOG_HEADER_SIZE; pos + LOG_RECORD_HEADER_SIZE <= log.size();) {
+        uint32_t fields[4];
+        memcpy(fields, log.data() + pos, LOG_RECORD_HEADER_SIZE);
+        int32_t RBN = static_cast<int32_t>(fields[1]);
+        const char* payload = log.data() + pos + LOG_RECORD_HEADER_SIZE;
+        if (fields[2] > log.size() - pos - LOG_RECORD_HEADER_SIZE
+            || recordChecksum(fields[0], RBN, payload, fields[2]) != fields[3]) {
+            break;
+        }
+        pos += LOG_RECORD_HEADER_SIZE + fields[2];
+
+        if (fields[0] == LOG_IMAGE) {
+            images.emplace_back(RBN, string(payload, fields[2]));
+        } else if (fields[0] == LOG_COMMIT) {
+            for (const auto& image : images) {
+                if (!apply(image.first, image.second)) return -1;
+            }
+            images.clear();
+            replayed++;
+        } else {
+            break;
+        }
+    }
+    return replayed;
+}
@@ -0,0 +1,128 @@
+// CSCI 331 Group Project - Copyright © 2024 Blocked Sequence Set Zip Code Processing System
+/**
+ * @file WriteAheadLog.h
+ * @brief Declaration of the WriteAheadLog class, a redo log of block and header images.
+ *
+ * Every block or header write of a mutation is appended to the log as a full after
+ * image, followed by a commit record once the mutation is complete. The images are
+ * only written in place after the log has been synced to disk, so after a crash the
+ * block file is brought back to the last synced commit by writing the logged images
+ * again; replaying an image twice does no harm.
+ *
+ * The log file ("block.dat" -> "block.wal") starts with a 16-byte header (magic "WAL1",
+ * block size, header size, reserved). Each record is a 16-byte record header (type, RBN,
+ * payload length, checksum) followed by its payload. Replay stops at the first torn or
+ * corrupt record and drops the records after the last commit before it.
+ */
+
+#ifndef WRITE_AHEAD_LOG_H
+#define WRITE_AHEAD_LOG_H
+
+#include <cstddef>
+#include <functional>
+#include <string>
+
+/// Mutations committed to the log before it is synced and applied in place.
+const size_t DEFAULT_GROUP_COMMIT = 32;
+
+/// Log file size past which the block file is checkpointed and the log started over.
+const size_t LOG_CHECKPOINT_BYTES = 16 * 1024 * 1024;
+
+/**
+ * @brief Names the log file of a block file ("block.dat" -> "block.wal").
+ * @param blockFile Path of the block file.
+ * @return Path of the log file.
+ */
+std::string logFileName(const std::string& blockFile);
+
+/**
+ * @brief Forces the written contents of a file to disk (fsync, or _commit on Windows).
+ * @param fileName Path of the file.
+ * @return True if the file was synced.
+ */
+bool syncFile(const std::string& fileName);
+
+/**
+ * @class WriteAheadLog
+ * @brief Appends block images and commit records to a log file and syncs them in groups.
+ *
+ * Records are buffered in memory and reach the file, in one write and one sync, when
+ * sync() is called; the caller decides how many commits to group into one sync.
+ */
+class WriteAheadLog {
+public:
+    WriteAheadLog();
+    ~WriteAheadLog();
+
+    WriteAheadLog(const WriteAheadLog&) = delete;
+    WriteAheadLog& operator=(const WriteAheadLog&) = delete;
+
+    /**
+     * @brief Creates an empty log file, replacing any earlier one, and syncs it.
+     * @param fileName Path of the log file.
+     * @param blockSize Block size of the block file, recorded in the log header.
+     * @param headerSize Header region size of the block file, recorded in the log header.
+     * @return True if the log file was created.
+     */
+    bool open(const std::string& fileName, int blockSize, int headerSize);
+
+    /**
+     * @brief Closes the log file and deletes it; buffered records are dropped.
+     */
+    void remove();
+
+    /**
+     * @brief Appends the after image of a block, or of the header region for RBN 0.
+     * @param RBN Relative Block Number of the block, 0 for the header region.
+     * @param image Bytes to write at that position.
+     */
+    void append(int RBN, const std::string& image);
+
+    /**
+     * @brief Appends a commit record closing the images appended since the last one.
+     */
+    void commit();
+
+    /**
+     * @brief Drops the buffered images appended since the last commit record.
+     */
+    void rollback();
+
+    /**
+     * @brief Writes the buffered records to the log file and syncs it.
+     * @return True if every buffered record is on disk.
+     */
+    bool sync();
+
+    /**
+     * @brief Writes the images of every committed mutation of a log file.
+     * @param fileName Path of the log file.
+     * @param headerSize Header region size of the block file, checked against the log header.
+     * @param apply Called with the RBN (0 for the header region) and image of every
+     *              committed record, in log order; returns false to stop with an error.
+     * @return Number of mutations replayed, or -1 if the log is not a log of this block
+     *         file or apply failed.
+     */
+    static long replay(const std::string& fileName, int headerSize,
+                       const std::function<bool(int, const std::string&)>& apply);
+
+    bool isOpen() const { return fd >= 0; }
+    bool hasUncommitted() const { return uncommitted > 0; }
+    size_t getPendingCommits() const { return pendingCommits; }
+    size_t getFileSize() const { return fileSize; }
+    unsigned long long getCommits() const { return commits; }
+    unsigned long long getSyncs() const { return syncs; }
+
+private:
+    std::string fileName;          ///< Path of the log file
+    int fd;                        ///< Descriptor of the open log file, -1 if closed
+    std::string buffer;            ///< Records not yet written to the file
+    size_t committedBytes;         ///< Bytes of buffer up to the last commit record
+    size_t uncommitted;            ///< Images appended since the last commit record
+    size_t pendingCommits;         ///< Commit records not yet synced
+    size_t fileSize;               ///< Bytes written to the log file
+    unsigned long long commits;    ///< Commit records appended since the program started
+    unsigned long long syncs;      ///< Syncs of the log file since the program started
+};
+
+#endif // WRITE_AHEAD_LOG_H
@@ -0,0 +1,170 @@
+// CSCI 331 Group Project - Copyright © 2024 Blocked Sequence Set Zip Code Processing System
+#include "ZoneMap.h"
+#include "Block.h"
+#include "HeaderRecord.h"
+#include "StateExtremes.h"
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+
+using namespace std;
+
+/// Identifies a sidecar zone map file.
+static const char ZONE_MAGIC[4] = { 'Z', 'M', 'P', '1' };
+
+/**
+ * @brief Copies a key into a zero padded zone map key slot.
+ */
+static void setKey(char* slot, const string& key) {
+    memset(slot, 0, ZONE_KEY_WIDTH);
+    memcpy(slot, key.data(), min(key.size(), ZONE_KEY_WIDTH));
+}
+
+/**
+ * @brief Summarizes the records of a block.
+ * @param block Block to summarize.
+ * @param header Header record naming the key, state, latitude and longitude fields.
+ * @return The zone map of the block.
+ */
+ZoneMap ZoneMap::of(const Block& block, const HeaderRecord& header) {
+    ZoneMap zone;
+    memset(zone.minKey, 0, ZONE_KEY_WIDTH);
+    memset(zone.maxKey, 0, ZONE_KEY_WIDTH);
+    zone.minLatitude = zone.minLongitude = numeric_limits<float>::infinity();
+    zone.maxLatitude = zone.maxLongitude = -numeric_limits<float>::infinity();
+    zone.states = 0;
+
+    size_t fieldCount = recordFieldCount(header);
+    size_t keyField = header.getPrimaryKeyField();
+    size_t stateField = fieldIndex(header, "state", 2);
+    size_t latitudeField = fieldIndex(header, "latitude", 4);
+    size_t longitudeField = fieldIndex(header, "longitude", 5);
+    if (block.records.size() < fieldCount) return zone;
+
+    // Records are kept in key order, so the first and last keys bound the block
+    setKey(zone.minKey, block.records[keyField]);
+    setKey(zone.maxKey, block.records[block.records.size() - fieldCount + keyField]);
+
+    for (size_t first = 0; first + fieldCount <= block.records.size(); first += fieldCount) {
+        int code = stateCode(block.records[first + stateField]);
+        if (code >= 0) zone.states |= uint64_t(1) << code;
+
+        const string& latitudeText = block.records[first + latitudeField];
+        const string& longitudeText = block.records[first + longitudeField];
+        if (latitudeText.empty() || longitudeText.empty()) continue;
+        double latitude = strtod(latitudeText.c_str(), nullptr);
+        double longitude = strtod(longitudeText.c_str(), nullptr);
+
+        // Round outwards so the float box still contains the exact coordinates
+        float low = static_cast<float>(latitude), high = low;
+        if (low > latitude) low = nextafterf(low, -INFINITY);
+        if (high < latitude) high = nextafterf(high, INFINITY);
+        zone.minLatitude = min(zone.minLatitude, low);
+        zone.maxLatitude = max(zone.maxLatitude, high);
+
+        low = high = static_cast<float>(longitude);
+        if (low > longitude) low = nextafterf(low, -INFINITY);
+        if (high < longitude) high = nextafterf(high, INFINITY);
+        zone.minLongitude = min(zone.minLongitude, low);
+        zone.maxLongitude = max(zone.maxLongitude, high);
+    }
+    return zone;
+}
+
+string_view ZoneMap::getMinKey() const {
+    return string_view(minKey, strnlen(minKey, ZONE_KEY_WIDTH));
+}
+
+string_view ZoneMap::getMaxKey() const {
+    return string_view(maxKey, strnlen(maxKey, ZONE_KEY_WIDTH));
+}
+
+/**
+ * @brief Writes the zone map as ZONE_MAP_SIZE bytes in host byte order.
+ * @param out Destination of ZONE_MAP_SIZE bytes.
+ */
+void ZoneMap::encode(char* out) const {
+    memcpy(out, minKey, ZONE_KEY_WIDTH);
+    memcpy(out + ZONE_KEY_WIDTH, maxKey, ZONE_KEY_WIDTH);
+    float box[4] = { minLatitude, maxLatitude, minLongitude, maxLongitude };
+    memcpy(out + 2 * ZONE_KEY_WIDTH, box, sizeof(box));
+    memcpy(out + 2 * ZONE_KEY_WIDTH + sizeof(box), &states, sizeof(states));
+}
+
+/**
+ * @brief Reads a zone map written by encode().
+ * @param in Source of ZONE_MAP_SIZE bytes.
+ */
+void ZoneMap::decode(const char* in) {
+    memcpy(minKey, in, ZONE_KEY_WIDTH);
+    memcpy(maxKey, in + ZONE_KEY_WIDTH, ZONE_KEY_WIDTH);
+    float box[4];
+    memcpy(box, in + 2 * ZONE_KEY_WIDTH, sizeof(box));
+    minLatitude = box[0];
+    maxLatitude = box[1];
+    minLongitude = box[2];
+    maxLongitude = box[3];
+    memcpy(&states, in + 2 * ZONE_KEY_WIDTH + sizeof(box), sizeof(states));
+}
+
+/**
+ * @brief Names the sidecar zone map file of a block file ("block.dat" -> "block.zmap").
+ * @param blockFile Path of the block file.
+ * @return Path of the sidecar file.
+ */
+string zoneMapFileName(const string& blockFile) {
+    size_t dot = blockFile.find_last_of('.');
+    size_t slash = blockFile.find_last_of("/\\");
+    if (dot == string::npos || (slash != string::npos && dot < slash)) return blockFile + ".zmap";
+    return blockFile.substr(0, dot) + ".zmap";
+}
+
+/**
+ * @brief Writes a sidecar file holding the zone map of every block, RBN 1 first.
+ * @param fileName Path of the sidecar file.
+ * @param zones Zone maps in RBN order.
+ * @return True if the file was written.
+ */
+bool writeZoneMapFile(const string& fileName, const vector<ZoneMap>& zones) {
+    ofstream out(fileName, ios::binary | ios::trunc);
+    if (!out.is_open()) {
+        cerr << "Error: Could not create zone map file: " << fileName << endl;
+        return false;
+    }
+    string data(ZONE_FILE_HEADER_SIZE + zones.size() * ZONE_MAP_SIZE, '\0');
+    int32_t count = static_cast<int32_t>(zones.size());
+    memcpy(&data[0], ZONE_MAGIC, 4);
+    memcpy(&data[4], &count, 4);
+    for (size_t i = 0; i < zones.size(); i++) {
+        zones[i].encode(&data[ZONE_FILE_HEADER_SIZE + i * ZONE_MAP_SIZE]);
+    }
+    out.write(data.data(), data.size());
+    return out.good();
+}
+
+/**
+ * @brief Reads a sidecar file written by writeZoneMapFile().
+ * @param fileName Path of the sidecar file.
+ * @param zones Receives the zone maps in RBN order.
+ * @return False if the file is missing or malformed.
+ */
+bool readZoneMapFile(const string& fileName, vector<ZoneMap>& zones) {
+    ifstream in(fileName, ios::binary);
+    char head[ZONE_FILE_HEADER_SIZE];
+    if (!in.read(head, sizeof(head)) || memcmp(head, ZONE_MAGIC, 4) != 0) return false;
+
+    int32_t count;
+    memcpy(&count, head + 4, 4);
+    if (count < 0) return false;
+    string data(static_cast<size_t>(count) * ZONE_MAP_SIZE, '\0');
+    if (!in.read(&data[0], data.size())) return false;
+
+    zones.resize(count);
+    for (int32_t i = 0; i < count; i++) {
+        zones[i].decode(&data[i * ZONE_MAP_SIZE]);
+    }
+    return true;
+}
@@ -0,0 +1,97 @@
+// CSCI 331 Group Project - Copyright © 2024 Blocked Sequence Set Zip Code Processing System
+/**
+ * @file ZoneMap.h
+ * @brief Declaration of the ZoneMap summary kept for every block and of its sidecar file.
+ *
+ * A zone map records the key range, the latitude and longitude bounding box and the set
+ * of states of the records in one block. It is stored in the block header and copied
+ * into a sidecar file (block.zmap next to block.dat), so queries can rule blocks out
+ * without reading them.
+ */
+
+#ifndef ZONE_MAP_H
+#define ZONE_MAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct Block;
+class HeaderRecord;
+
+/// Bytes of a key kept in a zone map; longer keys are cut, which can only widen the range.
+const size_t ZONE_KEY_WIDTH = 12;
+
+/// Bytes of an encoded zone map.
+const size_t ZONE_MAP_SIZE = 2 * ZONE_KEY_WIDTH + 4 * sizeof(float) + sizeof(uint64_t);
+
+/**
+ * @struct ZoneMap
+ * @brief Summary of the records of one block.
+ *
+ * Coordinates are stored as floats rounded outwards, so the box always contains every
+ * record of the block. A block without records has no states and an empty box.
+ */
+struct ZoneMap {
+    char minKey[ZONE_KEY_WIDTH];  ///< Smallest key, zero padded
+    char maxKey[ZONE_KEY_WIDTH];  ///< Largest key (at most ZONE_KEY_WIDTH bytes of it), zero padded
+    float minLatitude;            ///< Smallest latitude
+    float maxLatitude;            ///< Largest latitude
+    float minLongitude;           ///< Smallest longitude
+    float maxLongitude;           ///< Largest longitude
+    uint64_t states;              ///< Bit stateCode(s) is set for every state s in the block
+
+    /**
+     * @brief Summarizes the records of a block.
+     * @param block Block to summarize.
+     * @param header Header record naming the key, state, latitude and longitude fields.
+     * @return The zone map of the block.
+     */
+    static ZoneMap of(const Block& block, const HeaderRecord& header);
+
+    std::string_view getMinKey() const;
+    std::string_view getMaxKey() const;
+    bool hasState(int code) const { return code >= 0 && code < 64 && (states >> code & 1) != 0; }
+
+    /**
+     * @brief Writes the zone map as ZONE_MAP_SIZE bytes in host byte order.
+     * @param out Destination of ZONE_MAP_SIZE bytes.
+     */
+    void encode(char* out) const;
+
+    /**
+     * @brief Reads a zone map written by encode().
+     * @param in Source of ZONE_MAP_SIZE bytes.
+     */
+    void decode(const char* in);
+};
+
+/**
+ * @brief Names the sidecar zone map file of a block file ("block.dat" -> "block.zmap").
+ * @param blockFile Path of the block file.
+ * @return Path of the sidecar file.
+ */
+std::string zoneMapFileName(const std::string& blockFile);
+
+/// Bytes before the first entry of a sidecar file: magic "ZMP1" and the entry count (int32).
+const size_t ZONE_FILE_HEADER_SIZE = 8;
+
+/**
+ * @brief Writes a sidecar file holding the zone map of every block, RBN 1 first.
+ * @param fileName Path of the sidecar file.
+ * @param zones Zone maps in RBN order.
+ * @return True if the file was written.
+ */
+bool writeZoneMapFile(const std::string& fileName, const std::vector<ZoneMap>& zones);
+
+/**
+ * @brief Reads a sidecar file written by writeZoneMapFile().
+ * @param fileName Path of the sidecar file.
+ * @param zones Receives the zone maps in RBN order.
+ * @return False if the file is missing or malformed.
+ */
+bool readZoneMapFile(const std::string& fileName, std::vector<ZoneMap>& zones);
+
+#endif // ZONE_MAP_H
@@ -1,8 +1,14 @@
 // CSCI 331 Group Project - Copyright © 2024 Blocked Sequence Set Zip Code Processing System
 #include "Block.h"
 #include "Index.h"
+#include "BufferPool.h"
+#include "ExternalSort.h"
+#include "BlockSizeBenchmark.h"
+#include <cstdio>
 #include <iostream>
+#include <sstream>
 #include <string>
+#include <vector>
 
 using namespace std;
 
@@ -12,37 +18,174 @@ using namespace std;
  * This function provides an interactive menu-driven interface for managing and querying blocks. 
  * It performs the following steps:
  * 
- * 1. Creates a block file from an input CSV file.
- * 2. Parses the block file to populate the global `blocks` map.
- * 3. Enters an infinite loop providing the user with the following options:
+ * 1. Bulk loads the input CSV file into a block file and builds the index file named in
+ *    the header record, in the format of its index schema, in the same pass. An
+ *    unsorted input file is first sorted by zip code with an external merge sort.
+ * 2. Opens the block file through the buffer pool (blocks are read on demand).
+ * 3. Rebuilds the index from the block file if the block file had to be recovered.
+ * 4. Enters an infinite loop providing the user with the following options:
  *    - Dump all blocks in physical order.
  *    - Dump all blocks in logical order.
  *    - Query a specific block by its RBN.
  *    - Exit the program.
+ *    - Show the buffer pool hit/miss/eviction counters.
+ *    - Insert a record, or every record of a CSV file, in key order.
+ *    - Delete several zip codes.
+ *    - Get the most of one state, reading only the blocks whose zone map holds it.
+ *    - List the records of a zip code range in key order.
+ *    - Find the zip codes nearest a location, or within a distance of it.
+ *    - Find the zip codes of a state, county or place name through its secondary index.
+ *    - Complete the start of a place name, most zip codes first.
  * 
  * The user can query the details of a specific block by entering its RBN, including
  * availability, records, and predecessor/successor RBNs.
  * 
+ * Command line options:
+ *    --frames N   Number of block frames in the buffer pool (default DEFAULT_POOL_FRAMES).
+ *    --threads N  Worker threads for option 4 and the physical dump (default: one per
+ *                 hardware thread; 1 scans on the calling thread).
+ *    --bloom-fpr P  False positive rate of the Bloom filter built with the index
+ *                 (default DEFAULT_BLOOM_FPR).
+ *    --index-schema S  Index schema of the new block file: "key:string,rbn:int"
+ *                 (B+tree, the default), "key:zip5,rbn:int" (direct-address table) or
+ *                 "key:uint32,rbn:int" (sorted array searched by interpolation).
+ *    --input FILE Input CSV file (default us_postal_codes.csv).
+ *    --sort       Sort the input CSV file by zip code before loading it, for inputs
+ *                 such as us_postal_codes_ROWS_RANDOMIZED.csv.
+ *    --sort-memory MB  Memory budget of the sort in MiB (default DEFAULT_SORT_MEMORY);
+ *                 implies --sort.
+ *    --block-size N  Bytes per block of the new block file (default DEFAULT_BLOCK_SIZE);
+ *                 it is recorded in the header record, which every reader follows.
+ *    --fill-factor F  Fraction of each block filled by the bulk load, leaving the rest
+ *                 for inserts (default DEFAULT_FILL_FACTOR); recorded in the header record.
+ *    --compression C  Codec of the blocks of the new block file: "none" (the default),
+ *                 "lz" or "front"; recorded in the header record, which every reader follows.
+ *    --compressed-block-size N  Bytes each compressed block takes on disk (default half
+ *                 the block size for "lz", 15/16 of it for "front"); blocks still hold
+ *                 up to the block size of records once decompressed.
+ *    --benchmark SIZES  Bulk load, scan and search scratch copies of the input with each
+ *                 of the comma separated block sizes (e.g. 512,4096,16384), print the
+ *                 measurements and exit.
+ *    --mmap       Serve an existing block file and index read-only through memory
+ *                 mappings; steps 1 and 3 are skipped and inserts and deletes fail.
+ *    --reopen     Open the existing block file and index instead of creating them;
+ *                 step 1 is skipped.
+ *    --group-commit N  Inserts and deletes committed to the redo log per log sync
+ *                 (default DEFAULT_GROUP_COMMIT; 1 syncs after every one).
+ * 
  * @return int Exit code. Returns 0 if successful.
  */
-int main() {
+int main(int argc, char* argv[]) {
     string inputFile = "us_postal_codes.csv";
-    string outputFile = "block.txt";
+    string outputFile = "block.dat";
+    size_t frameCount = DEFAULT_POOL_FRAMES;
+    bool mapped = false;
+    bool reopen = false;
+    size_t groupCommit = DEFAULT_GROUP_COMMIT;
+    unsigned workers = 0;
+    double bloomRate = DEFAULT_BLOOM_FPR;
+    double fillFactor = DEFAULT_FILL_FACTOR;
+    size_t blockSize = DEFAULT_BLOCK_SIZE;
+    string compression = DEFAULT_BLOCK_CODEC;
+    size_t compressedBlockSize = 0;
+    vector<size_t> benchmarkSizes;
+    string indexSchema = DEFAULT_INDEX_SCHEMA;
+    bool sortInput = false;
+    size_t sortMemory = DEFAULT_SORT_MEMORY;
 
-    // Step 1: Create the block file from the input CSV
-    if (createBlockFile(inputFile, outputFile)) {
-        cout << "Block file created successfully.\n";
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--frames" && i + 1 < argc) {
+            frameCount = stoul(argv[++i]);
+        } else if (arg == "--threads" && i + 1 < argc) {
+            workers = stoul(argv[++i]);
+        } else if (arg == "--bloom-fpr" && i + 1 < argc) {
+            bloomRate = stod(argv[++i]);
+        } else if (arg == "--input" && i + 1 < argc) {
+            inputFile = argv[++i];
+        } else if (arg == "--sort") {
+            sortInput = true;
+        } else if (arg == "--sort-memory" && i + 1 < argc) {
+            sortMemory = stoul(argv[++i]) * 1024 * 1024;
+            sortInput = true;
+        } else if (arg == "--block-size" && i + 1 < argc) {
+            blockSize = stoul(argv[++i]);
+        } else if (arg == "--compression" && i + 1 < argc) {
+            compression = argv[++i];
+        } else if (arg == "--compressed-block-size" && i + 1 < argc) {
+            compressedBlockSize = stoul(argv[++i]);
+        } else if (arg == "--benchmark" && i + 1 < argc) {
+            stringstream sizes(argv[++i]);
+            string size;
+            while (getline(sizes, size, ',')) {
+                if (!size.empty()) benchmarkSizes.push_back(stoul(size));
+            }
+        } else if (arg == "--fill-factor" && i + 1 < argc) {
+            fillFactor = stod(argv[++i]);
+        } else if (arg == "--index-schema" && i + 1 < argc) {
+            indexSchema = argv[++i];
+        } else if (arg == "--mmap") {
+            mapped = true;
+        } else if (arg == "--reopen") {
+            reopen = true;
+        } else if (arg == "--group-commit" && i + 1 < argc) {
+            groupCommit = stoul(argv[++i]);
+        } else {
+            cerr << "Unknown option: " << arg << "\n";
+            return 1;
+        }
+    }
+
+    // Step 1: Load the block file and its indexes from the input CSV in one pass,
+    // sorting the input first if asked to
+    string loadFile = inputFile;
+    if (sortInput && ((!mapped && !reopen) || !benchmarkSizes.empty())) {
+        ExternalSort sorter(sortMemory);
+        loadFile = sortedFileName(inputFile);
+        if (!sorter.sort(inputFile, loadFile)) {
+            cerr << "Failed to sort " << inputFile << ".\n";
+            return 1;
+        }
+        cout << "Sorted " << sorter.getRecordCount() << " records of " << inputFile << " ("
+             << sorter.getRunCount() << " runs, " << sorter.getMergePasses() << " merge passes).\n";
+    }
+
+    if (!benchmarkSizes.empty()) {
+        bool measured = benchmarkBlockSizes(loadFile, benchmarkSizes, indexSchema, fillFactor, compression, workers, cout);
+        if (loadFile != inputFile) remove(loadFile.c_str());
+        return measured ? 0 : 1;
+    }
+
+    if (mapped) {
+        cout << "Serving " << outputFile << " read-only through a memory mapping.\n";
+    } else if (reopen) {
+        cout << "Reopening " << outputFile << ".\n";
     } else {
-        cerr << "Failed to create block file.\n";
+        bool loaded = bulkLoad(loadFile, outputFile, blockSize, indexSchema, fillFactor, bloomRate, DEFAULT_INDEX_FILE,
+                               compression, compressedBlockSize);
+        if (loadFile != inputFile) remove(loadFile.c_str());
+        if (!loaded) {
+            cerr << "Failed to create block file.\n";
+            return 1;
+        }
+        cout << "Block file created successfully.\n";
+    }
+
+    // Step 2: Open the block file; blocks are read through the buffer pool on demand
+    blockPool.setGroupCommit(groupCommit);
+    if (!openBlockFile(outputFile, frameCount, mapped, bloomRate)) {
         return 1;
     }
+    string indexFile = blockPool.getHeader().getIndexFileName();
 
-    Index index;
-    index.processBlockData( outputFile, "index.idx" );
-    // Step 2: Parse the block file to populate the global blocks map
-    parseBlockFile(outputFile);
+    // Step 3: Rebuild the primary key index named in the header record; a recovered
+    // block file may have lost mutations its indexes already hold
+    if (blockPool.wasRecovered()) {
+        Index index;
+        index.processBlockData( outputFile, indexFile, bloomRate );
+    }
 
-    // Step 3: Enter an infinite loop to provide a user menu
+    // Step 4: Enter an infinite loop to provide a user menu
     while (true) {
         cout << "\n===== Block Management Menu =====\n";
         cout << "1. Dump Blocks in Physical Order\n";
@@ -51,6 +194,16 @@ int main() {
 		cout << "4. Get the most of each state.\n";
 		cout << "5. Search for several zip codes.\n";
         cout << "6. Exit\n";
+        cout << "7. Show buffer pool statistics\n";
+        cout << "8. Insert a record\n";
+        cout << "9. Insert records from a CSV file\n";
+        cout << "10. Delete several zip codes\n";
+        cout << "11. Get the most of one state\n";
+        cout << "12. List the zip codes in a range\n";
+        cout << "13. Find the zip codes nearest a location\n";
+        cout << "14. Find the zip codes within a distance of a location\n";
+        cout << "15. Find the zip codes by state, county or place name\n";
+        cout << "16. Complete a place name\n";
 		
         cout << "Enter your choice: ";
 
@@ -60,7 +213,7 @@ int main() {
         switch (choice) {
             case 1:
                 cout << "\n----- Physical Order Dump -----\n";
-                dumpPhysicalOrder();
+                dumpPhysicalOrder(workers);
                 break;
 
             case 2:
@@ -73,16 +226,16 @@ int main() {
                 int RBN;
                 cin >> RBN;
 
-                if (blocks.find(RBN) != blocks.end()) {
-                    const Block& block = blocks[RBN];
+                Block block;
+                if (blockPool.getBlock(RBN, block)) {
                     cout << "\nDetails of Block RBN " << RBN << ":\n";
                     cout << "Available: " << (block.isAvailable ? "Yes" : "No") << "\n";
                     cout << "Records: ";
                     for (const string& record : block.records) {
                         cout << record << " ";
                     }
-                    cout << "\nPredecessor RBN: " << RBN-1 << "\n";
-                    cout << "Successor RBN: " << RBN+1 << "\n";
+                    cout << "\nPredecessor RBN: " << block.predecessorRBN << "\n";
+                    cout << "Successor RBN: " << block.successorRBN << "\n";
                 } else {
                     cout << "\nError: Block with RBN " << RBN << " not found.\n";
                 }
@@ -90,8 +243,8 @@ int main() {
             }
 			
 			case 4: {
-				listMost();
                 cout << "\n----- State Most Data -----\n";
+				listMost(workers);
                 break;
             }
 			
@@ -100,18 +253,107 @@ int main() {
 				cout << "Please enter the zip codes you want!" << endl;
 		std::string text;
 		cin >> text;
-		auto result = splitZipLine(text);
-		for (const auto& str : result) {
-		search(str, "index.idx");
-    }
+		searchMany(splitZipLine(text), indexFile);
 		break;
 			}
 
             case 6:{
                 cout << "Exiting the program. Goodbye!\n";
+                closeBlockFile();
                 return 0;
 			}
 
+            case 7:
+                cout << "\n----- Buffer Pool Statistics -----\n";
+                blockPool.printStats(cout);
+                break;
+
+            case 8: {
+                cout << "Enter the record (zip,place,state,county,lat,long): ";
+                string record;
+                cin >> ws;
+                getline(cin, record);
+                if (insertRecord(record)) {
+                    cout << "Record inserted.\n";
+                }
+                break;
+            }
+
+            case 9: {
+                cout << "Enter the CSV file name: ";
+                string csvFile;
+                cin >> csvFile;
+                cout << insertRecordsFromFile(csvFile) << " records inserted.\n";
+                break;
+            }
+
+            case 10: {
+                cout << "Please enter the zip codes you want to delete!" << endl;
+                string text;
+                cin >> text;
+                for (const auto& str : splitZipLine(text)) {
+                    if (deleteRecord(str)) {
+                        cout << str << " deleted.\n";
+                    }
+                }
+                break;
+            }
+
+            case 11: {
+                cout << "Enter the state abbreviation: ";
+                string state;
+                cin >> state;
+                cout << "\n----- State Most Data -----\n";
+                listMostOfState(state);
+                break;
+            }
+
+            case 12: {
+                cout << "Enter the lowest and highest zip code: ";
+                string lowZip, highZip;
+                cin >> lowZip >> highZip;
+                printRange(lowZip, highZip, indexFile);
+                break;
+            }
+
+            case 13: {
+                cout << "Enter the latitude, longitude and number of zip codes: ";
+                double latitude, longitude;
+                size_t count;
+                cin >> latitude >> longitude >> count;
+                printNearest(latitude, longitude, count);
+                break;
+            }
+
+            case 14: {
+                cout << "Enter the latitude, longitude and distance in km: ";
+                double latitude, longitude, radiusKm;
+                cin >> latitude >> longitude >> radiusKm;
+                printWithinRadius(latitude, longitude, radiusKm);
+                break;
+            }
+
+            case 15: {
+                cout << "Enter the field (state, county or place_name): ";
+                string fieldName, value;
+                cin >> fieldName;
+                cout << "Enter the value: ";
+                cin >> ws;
+                getline(cin, value);
+                printByField(fieldName, value, indexFile);
+                break;
+            }
+
+            case 16: {
+                cout << "Enter the number of completions and the start of the place name: ";
+                size_t count;
+                string prefix;
+                cin >> count >> ws;
+                getline(cin, prefix);
+                printCompletions(prefix, count, indexFile);
+                break;
+            }
+
             default:
                 cout << "Invalid choice. Please try again.\n";
                 break;